@@ -0,0 +1,20 @@
+#include "Aad.h"
+
+// every block below from.nodes.block is full , node blocks are filled one node at a time
+void AadTape::propagate(const Mark& from , const Mark& to) const {
+    for (size_t b = from.nodes.block + 1; b-- > to.nodes.block;){
+        AadNode* block = nodes_.block(b);
+        const size_t hi = b == from.nodes.block ? from.nodes.used : AadArena<AadNode>::BLOCK;
+        const size_t lo = b == to.nodes.block ? to.nodes.used : 0;
+        for (size_t i = hi; i-- > lo;){
+            const AadNode& node = block[i];
+            const double adjoint = node.adjoint;
+            if (adjoint == 0.0){
+                continue;
+            }
+            for (size_t k = 0; k < node.arity; ++k){
+                node.edges[k].parent->adjoint += node.edges[k].partial * adjoint;
+            }
+        }
+    }
+}
@@ -0,0 +1,251 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+ * Reverse mode automatic differentiation (AAD) on a tape
+ * - AadReal is a double plus a pointer to its node on the calling thread's tape , a number without a node is a constant,
+ *   arithmetic on constants records nothing and costs what the double arithmetic costs
+ * - every operation with a recorded argument appends one node with the local partials against its recorded arguments,
+ *   propagate() walks the nodes backwards once and leaves d result / d input in the adjoint of every input
+ * - nodes and edges live in arenas of fixed size blocks: rewind() / reset() only move the end back , blocks stay
+ *   allocated for the next valuation and are only freed with the thread
+ * - a Monte Carlo pricer takes a mark after recording its inputs , then per path records , propagates back to the mark
+ *   and rewinds to it , so the tape never holds more than one path (input adjoints keep adding up across paths)
+ */
+
+class AadTape;
+
+struct AadNode;
+
+struct AadEdge {
+    double partial;
+    AadNode* parent;
+};
+
+struct AadNode {
+    double adjoint;
+    AadEdge* edges;
+    size_t arity;
+};
+
+// blocks of BLOCK elements , an allocation never straddles two blocks
+template <typename T>
+class AadArena {
+
+public:
+    static const size_t BLOCK = 1 << 14;
+
+    struct Mark {
+        size_t block;
+        size_t used;
+    };
+
+    AadArena() : block_(0) , used_(0){
+        blocks_.emplace_back(new T[BLOCK]);
+        current_ = blocks_[0].get();
+    }
+
+    T* allocate(size_t n){
+        if (used_ + n > BLOCK){
+            if (++block_ == blocks_.size()){
+                blocks_.emplace_back(new T[BLOCK]);
+            }
+            current_ = blocks_[block_].get();
+            used_ = 0;
+        }
+        T* p = current_ + used_;
+        used_ += n;
+        return p;
+    }
+
+    Mark mark() const {return {block_ , used_};}
+    void rewind(const Mark& m){
+        block_ = m.block;
+        used_ = m.used;
+        current_ = blocks_[block_].get();
+    }
+
+    T* block(size_t b) const {return blocks_[b].get();}
+    size_t blocks() const {return blocks_.size();}
+
+private:
+    std::vector<std::unique_ptr<T[]>> blocks_;
+    T* current_;
+    size_t block_;
+    size_t used_;
+};
+
+class AadTape {
+
+public:
+    struct Mark {
+        AadArena<AadNode>::Mark nodes;
+        AadArena<AadEdge>::Mark edges;
+    };
+
+    // the tape every AadReal operation on this thread records on
+    static AadTape& local(){
+        thread_local AadTape tape;
+        return tape;
+    }
+
+    AadNode* record(size_t arity){
+        AadNode* node = nodes_.allocate(1);
+        node->adjoint = 0.0;
+        node->arity = arity;
+        node->edges = arity > 0 ? edges_.allocate(arity) : nullptr;
+        return node;
+    }
+
+    Mark mark() const {return {nodes_.mark() , edges_.mark()};}
+    void rewind(const Mark& m){
+        nodes_.rewind(m.nodes);
+        edges_.rewind(m.edges);
+    }
+    void reset(){rewind(Mark{{0 , 0} , {0 , 0}});}
+
+    // pushes the adjoints of the nodes recorded in [to , from) back to their arguments , latest first
+    void propagate(const Mark& from , const Mark& to) const;
+
+    // from the end of the tape back to its start
+    void propagate() const {propagate(mark() , Mark{{0 , 0} , {0 , 0}});}
+
+    // bytes held by the arenas , for sizing
+    size_t capacity() const {return nodes_.blocks() * AadArena<AadNode>::BLOCK * sizeof(AadNode) +
+                                    edges_.blocks() * AadArena<AadEdge>::BLOCK * sizeof(AadEdge);}
+
+private:
+    AadTape() = default;
+    AadTape(const AadTape&) = delete;
+    AadTape& operator=(const AadTape&) = delete;
+
+    AadArena<AadNode> nodes_;
+    AadArena<AadEdge> edges_;
+};
+
+
+class AadReal {
+
+public:
+    AadReal() : value_(0.0) , node_(nullptr){}
+    AadReal(double value) : value_(value) , node_(nullptr){}
+
+    // a fresh input of the local tape
+    static AadReal input(double value){
+        AadReal x(value);
+        x.node_ = AadTape::local().record(0);
+        return x;
+    }
+
+    double value() const {return value_;}
+    bool recorded() const {return node_ != nullptr;}
+
+    // d result / d this once the tape has been propagated , 0 for a constant
+    double adjoint() const {return node_ != nullptr ? node_->adjoint : 0.0;}
+
+    // seeds the sweep: propagating after x.seed(1) gives dx / d input
+    void seed(double adjoint = 1.0) const {
+        if (node_ != nullptr){
+            node_->adjoint += adjoint;
+        }
+    }
+
+    // value and partials of an operation on n arguments , constants get no edge
+    static AadReal make(double value , size_t n , const AadReal* const* args , const double* partials){
+        size_t recorded = 0;
+        for (size_t k = 0; k < n; ++k){
+            recorded += args[k]->node_ != nullptr;
+        }
+        AadReal out(value);
+        if (recorded == 0){
+            return out;
+        }
+        out.node_ = AadTape::local().record(recorded);
+        AadEdge* e = out.node_->edges;
+        for (size_t k = 0; k < n; ++k){
+            if (args[k]->node_ != nullptr){
+                e->partial = partials[k];
+                e->parent = args[k]->node_;
+                ++e;
+            }
+        }
+        return out;
+    }
+
+    static AadReal unary(double value , const AadReal& a , double da){
+        AadReal out(value);
+        if (a.node_ != nullptr){
+            out.node_ = AadTape::local().record(1);
+            out.node_->edges[0] = {da , a.node_};
+        }
+        return out;
+    }
+
+    static AadReal binary(double value , const AadReal& a , double da , const AadReal& b , double db){
+        if (a.node_ == nullptr){
+            return unary(value , b , db);
+        }
+        if (b.node_ == nullptr){
+            return unary(value , a , da);
+        }
+        AadReal out(value);
+        out.node_ = AadTape::local().record(2);
+        out.node_->edges[0] = {da , a.node_};
+        out.node_->edges[1] = {db , b.node_};
+        return out;
+    }
+
+    AadReal& operator+=(const AadReal& b){return *this = binary(value_ + b.value_ , *this , 1.0 , b , 1.0);}
+    AadReal& operator-=(const AadReal& b){return *this = binary(value_ - b.value_ , *this , 1.0 , b , -1.0);}
+    AadReal& operator*=(const AadReal& b){return *this = binary(value_ * b.value_ , *this , b.value_ , b , value_);}
+    AadReal& operator/=(const AadReal& b){
+        const double inv = 1.0 / b.value_;
+        return *this = binary(value_ * inv , *this , inv , b , -value_ * inv * inv);
+    }
+
+private:
+    double value_;
+    AadNode* node_;
+};
+
+inline AadReal operator-(const AadReal& a){return AadReal::unary(-a.value() , a , -1.0);}
+inline AadReal operator+(const AadReal& a , const AadReal& b){return AadReal::binary(a.value() + b.value() , a , 1.0 , b , 1.0);}
+inline AadReal operator-(const AadReal& a , const AadReal& b){return AadReal::binary(a.value() - b.value() , a , 1.0 , b , -1.0);}
+inline AadReal operator*(const AadReal& a , const AadReal& b){return AadReal::binary(a.value() * b.value() , a , b.value() , b , a.value());}
+inline AadReal operator/(const AadReal& a , const AadReal& b){
+    const double inv = 1.0 / b.value();
+    return AadReal::binary(a.value() * inv , a , inv , b , -a.value() * inv * inv);
+}
+
+inline bool operator<(const AadReal& a , const AadReal& b){return a.value() < b.value();}
+inline bool operator>(const AadReal& a , const AadReal& b){return a.value() > b.value();}
+inline bool operator<=(const AadReal& a , const AadReal& b){return a.value() <= b.value();}
+inline bool operator>=(const AadReal& a , const AadReal& b){return a.value() >= b.value();}
+
+inline AadReal exp(const AadReal& a){
+    const double e = std::exp(a.value());
+    return AadReal::unary(e , a , e);
+}
+
+inline AadReal log(const AadReal& a){return AadReal::unary(std::log(a.value()) , a , 1.0 / a.value());}
+
+inline AadReal sqrt(const AadReal& a){
+    const double s = std::sqrt(a.value());
+    return AadReal::unary(s , a , 0.5 / s);
+}
+
+// the larger argument itself , no node: the derivative follows whichever side is taken
+inline AadReal max(const AadReal& a , const AadReal& b){return a.value() >= b.value() ? a : b;}
+inline AadReal min(const AadReal& a , const AadReal& b){return a.value() <= b.value() ? a : b;}
+
+// exact N(x) , same erfc as normal_cdf<CdfAccuracy::EXACT>
+inline AadReal normal_cdf(const AadReal& a){
+    const double x = a.value();
+    return AadReal::unary(0.5 * std::erfc(-x * 0.7071067811865476) , a , 0.3989422804014327 * std::exp(-0.5 * x * x));
+}
+
+inline double value(const AadReal& a){return a.value();}
+inline double value(double a){return a;}
@@ -1,14 +1,25 @@
-#pragma once 
-#include "Optionp.hpp"
+#pragma once
+#include "Optionbase.hpp"
 #include "EuropeanOptionp.hpp"
 #include<cmath>
+#include<vector>
+#include<algorithm>
 
 
-class AmericanOption : public Option {
-public: 
+class AmericanOption : public OptionBase {
+public:
+    // CRR: u = e^(sigma sqrt(dt)) , d = 1/u
+    // LEISEN_REIMER: Peizer-Pratt inversion of d1/d2 , converges smoothly at O(1/N^2) , always runs an odd number of steps
+    enum class TreeType {CRR , LEISEN_REIMER};
+
     int num_steps_;
-    AmericanOption(double spot , double strike , double rate , double T , double sigma , Optiontype type , int num_steps = 100) :
-                                                                Option(spot , strike , rate , T , sigma,type),num_steps_(num_steps){}
+    TreeType tree_;
+    double dividend_;   // continuous dividend yield q: the tree grows at r - q and discounts at r
+
+    AmericanOption(double spot , double strike , double rate , double T , double sigma , Optiontype type , int num_steps = 100 ,
+                   TreeType tree = TreeType::CRR , double dividend = 0.0) :
+                                                                OptionBase(spot , strike , rate , T , sigma,type),num_steps_(num_steps),tree_(tree),
+                                                                dividend_(dividend){}
 
     ~AmericanOption() = default;
 
@@ -16,41 +27,55 @@ public:
 
     double price() const override {
         // we are implementing binomial tree pricing for american option pricing
-        double dt  = T_/ num_steps_;
-        double u = std::exp(sigma_ * std::sqrt(dt));
-        double d =  1.0/u;
-        double p = ((std::exp(rate_*dt)) - d )/(u-d);
+        return backward_induction(steps());
+    }
 
-        // still needs to done
+    // Greeks come off the nodes of one lattice instead of repricing bumped trees
+    // - delta , gamma , theta: CRR runs the extended tree (two extra steps before t=0 so three nodes S d^2 , S , S u^2 sit at t=0)
+    //   Leisen-Reimer uses the nodes at steps 1 and 2 of its own tree
+    // - vega , rho: central bumps , each pair of bumped lattices runs in one backward pass (shared_grid_induction),
+    //   the two CRR rho lattices also share their grid (u , d do not depend on r)
 
-    }
+    double delta() const override {return lattice_greeks().delta;}
 
-    double delta() const override {
-        double h = 0.01 *spot_;
-        AmericanOption upoption(spot_+h , strike_ , rate_ , T_ , sigma_, type_,num_steps_);
-        AmericanOption downoption(spot_-h , strike_ , rate_ , T_ , sigma_, type_,num_steps_);
+    double gamma() const override {return lattice_greeks().gamma;}
 
-        return (upoption.price() - downoption.price())/(2.0*h);
-    }
+    // per calendar day
+    double theta() const override {return lattice_greeks().theta;}
 
-    double gamma() const override {
-        double h = 0.01 * spot_;
-        AmericanOption upoption(spot_+h , strike_ , rate_ , T_ , sigma_, type_,num_steps_);
-        AmericanOption downoption(spot_-h , strike_ , rate_ , T_ , sigma_, type_,num_steps_);
-        return (upoption.price() + downoption.price()-2*price())/(h*h);
+    // per 1% vol , the bump is 1 vol point or half of sigma when that is smaller so sigma - h stays positive
+    double vega() const override {
+        const double h = std::min(0.01 , 0.5 * sigma_);
+        const int n = steps();
+        const double dt = T_ / n;
+        TreeParams tp[2] = {params(n , rate_ , dt , sigma_ + h) , params(n , rate_ , dt , sigma_ - h)};
+        double bumped[2];
+        shared_grid_induction(tp , 2 , n , bumped);
+        return (bumped[0] - bumped[1]) / (2.0 * h) * 0.01;
     }
 
-    double theta() const override {
-        double h = 1.0/365.0 ; 
-        AmericanOption futureopt(spot_ , strike_ , rate_ , T_-h , sigma_, type_,num_steps_);
-        return futureopt.price() - price();
+    // per 1% rate
+    double rho() const {
+        double bumped[2];
+        rate_bumps(0.01 , bumped);
+        return (bumped[0] - bumped[1])/2.0;
     }
-    double vega() const override {
-        double h = 0.01; 
-        AmericanOption upoptsigma(spot_ ,strike_, rate_, sigma_ + h, T_, type_, num_steps_);
-        AmericanOption downoptsigma(spot_, strike_, rate_, sigma_ - h, T_, type_, num_steps_);
-        return (upoptsigma.price() - downoptsigma.price())/2.0;
 
+    struct TreeGreeks {
+        double price;
+        double delta;
+        double gamma;
+        double theta;
+        double vega;
+        double rho;
+    };
+
+    // everything at once: one extended lattice + one rho pass + one vega pass
+    TreeGreeks greeks() const {
+        TreeGreeks g = lattice_greeks();
+        g.vega = vega();
+        g.rho = rho();
+        return g;
     }
 
     double earlyexcercisepremium(){
@@ -58,5 +83,260 @@ public:
         return price() - euroopt.price();
     }
 
+private:
+    struct TreeParams {
+        double u;
+        double d;
+        double p;
+        double disc;
+    };
+
+    // Leisen-Reimer needs an odd number of steps so the strike sits on the middle node at expiry
+    int steps() const {
+        int n = std::max(num_steps_ , 1);
+        if (tree_ == TreeType::LEISEN_REIMER && n % 2 == 0){
+            ++n;
+        }
+        return n;
+    }
+
+    // Peizer-Pratt method 2 inversion used by Leisen-Reimer
+    static double peizer_pratt(double z , int n){
+        double a = z / (n + 1.0/3.0 + 0.1/(n + 1.0));
+        double h = 0.5 * std::sqrt(1.0 - std::exp(-a*a*(n + 1.0/6.0)));
+        return z >= 0.0 ? 0.5 + h : 0.5 - h;
+    }
+
+    // node values of the first levels of the tree , level[i][j] for i <= 4
+    struct Levels {
+        double level[5][5];
+    };
+
+    TreeParams params(int n) const {return params(n , rate_ , T_ / n);}
+
+    TreeParams params(int n , double rate , double dt) const {return params(n , rate , dt , sigma_);}
+
+    TreeParams params(int n , double rate , double dt , double sigma) const {
+        double growth = std::exp((rate - dividend_) * dt);
+        TreeParams tp;
+        tp.disc = std::exp(-rate * dt);
+
+        if (tree_ == TreeType::LEISEN_REIMER){
+            double sig_sqrt_T = sigma * std::sqrt(T_);
+            double d1 = (std::log(spot_/strike_) + (rate - dividend_ + 0.5*sigma*sigma)*T_) / sig_sqrt_T;
+            double d2 = d1 - sig_sqrt_T;
+            tp.p = peizer_pratt(d2 , n);
+            tp.u = growth * peizer_pratt(d1 , n) / tp.p;
+            tp.d = (growth - tp.p * tp.u) / (1.0 - tp.p);
+        }
+        else{
+            tp.u = std::exp(sigma * std::sqrt(dt));
+            tp.d = 1.0 / tp.u;
+            tp.p = (growth - tp.d) / (tp.u - tp.d);
+        }
+        return tp;
+    }
+
+    // one scratch buffer per thread , grows to the biggest tree priced on that thread and is then reused
+    static double* scratch(size_t n){
+        thread_local std::vector<double> buffer;
+        if (buffer.size() < n){
+            buffer.resize(n);
+        }
+        return buffer.data();
+    }
+
+    /*
+     * Backward induction on a single rolling array of num_steps+1 values
+     * - node (i , j) has spot S u^j d^(i-j) , built from precomputed S u^j and d^k so no pow() in the loop
+     * - exercise region is contiguous: low nodes for a put , high nodes for a call
+     *   so each level is walked starting from the exercise side and once the first node is worth
+     *   more held than exercised the rest of the level is pure discounting with no payoff evaluation
+     *   (an American call with no dividend yield never crosses , it degenerates to the European tree)
+     */
+    double backward_induction(int n) const {return backward_induction(params(n) , n , nullptr);}
+
+    double backward_induction(const TreeParams& tp , int n , Levels* levels) const {
+        const size_t m = static_cast<size_t>(n) + 1;
+
+        double* v = scratch(3 * m);
+        double* spot_up = v + m;   // S u^j
+        double* down = v + 2 * m;  // d^k
+
+        spot_up[0] = spot_;
+        down[0] = 1.0;
+        for (size_t j = 1; j < m; ++j){
+            spot_up[j] = spot_up[j-1] * tp.u;
+            down[j] = down[j-1] * tp.d;
+        }
+
+        const bool call = type_ == Optiontype::CALL;
+        const double K = strike_;
+        for (int j = 0; j <= n; ++j){
+            double S = spot_up[j] * down[n-j];
+            v[j] = call ? std::max(S - K , 0.0) : std::max(K - S , 0.0);
+        }
+        if (levels && n <= 4){
+            std::copy(v , v + n + 1 , levels->level[n]);
+        }
+
+        const double pu = tp.disc * tp.p;
+        const double pd = tp.disc * (1.0 - tp.p);
+
+        for (int i = n - 1; i >= 0; --i){
+            if (call){
+                // high nodes first , value at j+1 is saved before it is overwritten
+                double above = v[i+1];
+                int j = i;
+                for (; j >= 0; --j){
+                    double here = v[j];
+                    double hold = pu * above + pd * here;
+                    double exercise = spot_up[j] * down[i-j] - K;
+                    above = here;
+                    if (hold >= exercise){
+                        v[j] = hold;
+                        --j;
+                        break;
+                    }
+                    v[j] = exercise;
+                }
+                for (; j >= 0; --j){
+                    double here = v[j];
+                    v[j] = pu * above + pd * here;
+                    above = here;
+                }
+            }
+            else{
+                int j = 0;
+                for (; j <= i; ++j){
+                    double hold = pu * v[j+1] + pd * v[j];
+                    double exercise = K - spot_up[j] * down[i-j];
+                    if (hold >= exercise){
+                        v[j] = hold;
+                        ++j;
+                        break;
+                    }
+                    v[j] = exercise;
+                }
+                for (; j <= i; ++j){
+                    v[j] = pu * v[j+1] + pd * v[j];
+                }
+            }
+
+            if (levels && i <= 4){
+                std::copy(v , v + i + 1 , levels->level[i]);
+            }
+        }
+
+        return v[0];
+    }
+
+    TreeGreeks lattice_greeks() const {
+        const int n = steps();
+        const double dt = T_ / n;
+        Levels lv;
+        TreeGreeks g = TreeGreeks();
+
+        if (tree_ == TreeType::CRR){
+            // extended tree: n+2 steps of the same dt starting at -2dt , the subtree at node (2,1) is exactly the n step tree
+            double u = std::exp(sigma_ * std::sqrt(dt));
+            double d = 1.0 / u;
+            backward_induction(params(n + 2 , rate_ , dt) , n + 2 , &lv);
+
+            double Su = spot_ * u * u;
+            double Sd = spot_ * d * d;
+            const double* f = lv.level[2];
+            g.price = f[1];
+            g.delta = (f[2] - f[0]) / (Su - Sd);
+            g.gamma = ((f[2] - f[1]) / (Su - spot_) - (f[1] - f[0]) / (spot_ - Sd)) / (0.5 * (Su - Sd));
+            // middle node two steps later is S again , a one step tree only has the root at -2dt to compare with
+            double later = n >= 2 ? lv.level[4][2] : f[1];
+            double earlier = n >= 2 ? f[1] : lv.level[0][0];
+            g.theta = (later - earlier) / (2.0 * dt) / 365.0;
+            return g;
+        }
+
+        // needs at least two levels below the root
+        const int nl = std::max(n , 3);
+        const double dtl = T_ / nl;
+        TreeParams tp = params(nl);
+        g.price = backward_induction(tp , nl , &lv);
+        const double* f1 = lv.level[1];
+        const double* f2 = lv.level[2];
+        double S1u = spot_ * tp.u;
+        double S1d = spot_ * tp.d;
+        double S2uu = spot_ * tp.u * tp.u;
+        double S2ud = spot_ * tp.u * tp.d;
+        double S2dd = spot_ * tp.d * tp.d;
+        g.delta = (f1[1] - f1[0]) / (S1u - S1d);
+        g.gamma = ((f2[2] - f2[1]) / (S2uu - S2ud) - (f2[1] - f2[0]) / (S2ud - S2dd)) / (0.5 * (S2uu - S2dd));
+        // S u d is not S on this tree , move the middle node back to S with delta/gamma before differencing in time
+        double shift = S2ud - spot_;
+        double middle = f2[1] - g.delta * shift - 0.5 * g.gamma * shift * shift;
+        g.theta = (middle - lv.level[0][0]) / (2.0 * dtl) / 365.0;
+        return g;
+    }
+
+    // prices at rate +- h , out = {up , down}
+    void rate_bumps(double h , double* out) const {
+        const int n = steps();
+        const double dt = T_ / n;
+        TreeParams tp[2] = {params(n , rate_ + h , dt) , params(n , rate_ - h , dt)};
+        shared_grid_induction(tp , 2 , n , out);
+    }
+
+    /*
+     * Several lattices (different p and discount , and u , d unless they coincide) in a single backward pass
+     * - on one grid (CRR rho bumps) node spots and payoffs are evaluated once per node and shared by every lattice
+     * - otherwise (vega bumps , Leisen-Reimer rho bumps) each lattice has its own spots , only the pass is shared
+     */
+    void shared_grid_induction(const TreeParams* tp , int k , int n , double* out) const {
+        const size_t m = static_cast<size_t>(n) + 1;
+        const size_t lanes = static_cast<size_t>(k);
+        bool one_grid = true;
+        for (size_t l = 1; l < lanes; ++l){
+            one_grid = one_grid && tp[l].u == tp[0].u && tp[l].d == tp[0].d;
+        }
+        const size_t grids = one_grid ? 1 : lanes;
+
+        double* v = scratch((lanes + 2 * grids) * m);
+        double* spot_up = v + lanes * m;       // grid g: spot_up + g m , down + g m
+        double* down = spot_up + grids * m;
+
+        for (size_t g = 0; g < grids; ++g){
+            double* su = spot_up + g * m;
+            double* dn = down + g * m;
+            su[0] = spot_;
+            dn[0] = 1.0;
+            for (size_t j = 1; j < m; ++j){
+                su[j] = su[j-1] * tp[g].u;
+                dn[j] = dn[j-1] * tp[g].d;
+            }
+        }
+
+        const double w = type_ == Optiontype::CALL ? 1.0 : -1.0;
+        auto exercise = [&](size_t g , int i , int j){return w * (spot_up[g * m + j] * down[g * m + i - j] - strike_);};
+        for (int j = 0; j <= n; ++j){
+            for (size_t l = 0; l < lanes; ++l){
+                v[l * m + j] = std::max(exercise(one_grid ? 0 : l , n , j) , 0.0);
+            }
+        }
+
+        for (int i = n - 1; i >= 0; --i){
+            for (int j = 0; j <= i; ++j){
+                const double shared = exercise(0 , i , j);
+                for (size_t l = 0; l < lanes; ++l){
+                    double* vl = v + l * m;
+                    double hold = tp[l].disc * (tp[l].p * vl[j+1] + (1.0 - tp[l].p) * vl[j]);
+                    vl[j] = std::max(hold , one_grid || l == 0 ? shared : exercise(l , i , j));
+                }
+            }
+        }
+
+        for (size_t l = 0; l < lanes; ++l){
+            out[l] = v[l * m];
+        }
+    }
+
 
-};
\ No newline at end of file
+};
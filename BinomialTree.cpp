@@ -0,0 +1,346 @@
+#include "BinomialTree.h"
+#include "Aad.h"
+#include "Instrumentation.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+BinomialTree::BinomialTree(const Config& config) : config_(config){
+    if (config_.num_steps < 1){
+        throw std::invalid_argument("BinomialTree needs at least one step");
+    }
+    if (config_.tolerance < 0.0){
+        throw std::invalid_argument("BinomialTree tolerance must be non-negative");
+    }
+    if (config_.tolerance > 0.0 && config_.max_steps < config_.num_steps){
+        throw std::invalid_argument("BinomialTree max_steps must be at least num_steps");
+    }
+}
+
+AmericanOption BinomialTree::lattice(double K , double T , Option::Type type , const MarketData& marketdata , int steps) const {
+    OptionBase::Optiontype t = type == Option::Type::CALL ? OptionBase::Optiontype::CALL : OptionBase::Optiontype::PUT;
+    return AmericanOption(marketdata.spot_ , K , marketdata.rate_ , T , marketdata.volatility_ , t , steps , config_.tree ,
+                          marketdata.dividend_);
+}
+
+AmericanOption BinomialTree::lattice(double K , double T , Option::Type type , const MarketData& marketdata) const {
+    if (config_.tolerance > 0.0){
+        return lattice(K , T , type , marketdata , converge(K , T , type , marketdata).steps);
+    }
+    return lattice(K , T , type , marketdata , config_.num_steps);
+}
+
+namespace {
+
+// the steps a lattice really runs , Leisen-Reimer rounds up to odd
+int tree_steps(int n , AmericanOption::TreeType tree){
+    return tree == AmericanOption::TreeType::LEISEN_REIMER && n % 2 == 0 ? n + 1 : n;
+}
+
+// backward induction , the greeks set runs several
+double induce(const AmericanOption& a){
+    PRICING_TIME(BINOMIAL_TREE , INDUCTION);
+    return a.price();
+}
+
+AmericanOption::TreeGreeks induce_greeks(const AmericanOption& a){
+    PRICING_TIME(BINOMIAL_TREE , INDUCTION);
+    return a.greeks();
+}
+
+} // namespace
+
+BinomialTree::Result BinomialTree::converge(double K , double T , Option::Type type , const MarketData& marketdata) const {
+    Result r{induce(lattice(K , T , type , marketdata , config_.num_steps)) , std::numeric_limits<double>::infinity() ,
+             tree_steps(config_.num_steps , config_.tree)};
+    while (tree_steps(2 * r.steps , config_.tree) <= config_.max_steps){
+        const int n = tree_steps(2 * r.steps , config_.tree);
+        const double p = induce(lattice(K , T , type , marketdata , n));
+        r.error = std::abs(p - r.price) * r.steps / (n - r.steps);
+        r.price = p;
+        r.steps = n;
+        if (r.error <= config_.tolerance){
+            break;
+        }
+    }
+    return r;
+}
+
+BinomialTree::Result BinomialTree::run(const Option& option , const MarketData& marketdata) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , 1);
+    return converge(option.strike_ , option.expiry_ , option.type_ , marketdata);
+}
+
+// the price of the converged lattice is already in hand , only greeks need the lattice again
+double BinomialTree::value(double K , double T , Option::Type type , const MarketData& marketdata) const {
+    if (config_.tolerance > 0.0){
+        return converge(K , T , type , marketdata).price;
+    }
+    return induce(lattice(K , T , type , marketdata , config_.num_steps));
+}
+
+static Greeks to_greeks(const AmericanOption::TreeGreeks& g){
+    Greeks out;
+    out.delta = g.delta;
+    out.gamma = g.gamma;
+    out.vega = g.vega;
+    out.theta = g.theta;
+    out.rho = g.rho;
+    return out;
+}
+
+double BinomialTree::price(const Option& option, const MarketData& marketdata) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , 1);
+    return value(option.strike_ , option.expiry_ , option.type_ , marketdata);
+}
+
+Greeks BinomialTree::greeks(const Option& option, const MarketData& marketdata) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , 1);
+    return to_greeks(induce_greeks(lattice(option.strike_ , option.expiry_ , option.type_ , marketdata)));
+}
+
+// price alone is one lattice , anything more runs the greeks set (which prices too)
+Valuation BinomialTree::evaluate(const Option& option , const MarketData& marketdata , unsigned request) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , 1);
+    Valuation v;
+    if (request & Valuation::GREEKS){
+        AmericanOption::TreeGreeks g = induce_greeks(lattice(option.strike_ , option.expiry_ , option.type_ , marketdata));
+        v.price = g.price;
+        v.greeks = to_greeks(g);
+    }
+    else if (request & Valuation::PRICE){
+        v.price = value(option.strike_ , option.expiry_ , option.type_ , marketdata);
+    }
+    return v;
+}
+
+void BinomialTree::price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , batch.size());
+    for (size_t i = 0; i < batch.size(); ++i){
+        out[i] = value(batch.strike_[i] , batch.expiry_[i] , batch.type_[i] , marketdata);
+    }
+}
+
+void BinomialTree::price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , batch.size());
+    for (size_t i = 0; i < batch.size(); ++i){
+        out[i] = value(batch.strike_[i] , batch.expiry_[i] , batch.type_[i] , marketdata[i]);
+    }
+}
+
+void BinomialTree::greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , batch.size());
+    for (size_t i = 0; i < batch.size(); ++i){
+        store(to_greeks(induce_greeks(lattice(batch.strike_[i] , batch.expiry_[i] , batch.type_[i] , marketdata))) , out , i);
+    }
+}
+
+void BinomialTree::greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , batch.size());
+    for (size_t i = 0; i < batch.size(); ++i){
+        store(to_greeks(induce_greeks(lattice(batch.strike_[i] , batch.expiry_[i] , batch.type_[i] , marketdata[i]))) , out , i);
+    }
+}
+
+namespace {
+
+// AmericanOption::peizer_pratt on the tape , at z = 0 the expansion 0.5 + 0.5 a sqrt(n + 1/6) keeps the slope finite
+AadReal peizer_pratt(const AadReal& z , int n){
+    const AadReal a = z / (n + 1.0 / 3.0 + 0.1 / (n + 1.0));
+    if (z.value() == 0.0){
+        return 0.5 + 0.5 * std::sqrt(n + 1.0 / 6.0) * a;
+    }
+    const AadReal h = 0.5 * sqrt(1.0 - exp(-a * a * (n + 1.0 / 6.0)));
+    return z.value() >= 0.0 ? 0.5 + h : 0.5 - h;
+}
+
+// the levels of one lattice kept for its adjoint sweep , per thread and reused
+struct LatticeScratch {
+    std::vector<double> values;     // level i starts at i (i + 1) / 2
+    std::vector<int> exercised;     // nodes of level i on the exercise side of its boundary
+    std::vector<double> spot_up;
+    std::vector<double> down;
+    std::vector<double> adjoint[2];
+    std::vector<double> spot_up_adjoint;
+    std::vector<double> down_adjoint;
+};
+
+/*
+ * The lattice of AmericanOption::backward_induction as one node of the tape
+ * - the tree parameters (u , d and the discounted probabilities) are taped as usual , the rollback between them and
+ *   the price runs on doubles and keeps every level , then a hand written adjoint sweep walks it from the root down
+ *   and the node gets the price's partials against S , u , d , pu and pd: about a price for the rollback , a price for the sweep
+ * - exercise is decided on values (the boundary of each level is stored) , so the boundary stays put and only the
+ *   payoffs of exercised nodes are differentiated
+ * - same step count (odd for Leisen-Reimer) and same tie rule as the double lattice , the value matches it exactly
+ */
+AadReal rollback(const AadReal& S , const AadReal& u , const AadReal& d , const AadReal& pu , const AadReal& pd , double K , bool call , int n){
+    thread_local LatticeScratch work;
+    const size_t m = static_cast<size_t>(n) + 1;
+    work.values.resize(m * (m + 1) / 2);
+    work.exercised.resize(m);
+    work.spot_up.resize(m);
+    work.down.resize(m);
+    double* spot_up = work.spot_up.data();
+    double* down = work.down.data();
+    spot_up[0] = S.value();
+    down[0] = 1.0;
+    for (size_t j = 1; j < m; ++j){
+        spot_up[j] = spot_up[j - 1] * u.value();
+        down[j] = down[j - 1] * d.value();
+    }
+
+    const double w = call ? 1.0 : -1.0;
+    const double a = pu.value() , b = pd.value();
+    auto level = [&](int i){return work.values.data() + static_cast<size_t>(i) * (i + 1) / 2;};
+    // exercise sits at low nodes of a put and high nodes of a call , node k counted from that side is j = call ? i - k : k
+    auto node = [&](int i , int k){return call ? i - k : k;};
+
+    double* top = level(n);
+    int itm = 0;
+    for (int k = 0; k <= n; ++k){
+        const int j = node(n , k);
+        top[j] = std::max(w * (spot_up[j] * down[n - j] - K) , 0.0);
+        itm += top[j] > 0.0 && itm == k;
+    }
+    work.exercised[n] = itm;
+    for (int i = n - 1; i >= 0; --i){
+        const double* next = level(i + 1);
+        double* v = level(i);
+        int k = 0;
+        for (; k <= i; ++k){
+            const int j = node(i , k);
+            const double hold = a * next[j + 1] + b * next[j];
+            const double exercise = w * (spot_up[j] * down[i - j] - K);
+            if (hold >= exercise){
+                break;
+            }
+            v[j] = exercise;
+        }
+        work.exercised[i] = k;
+        for (; k <= i; ++k){
+            const int j = node(i , k);
+            v[j] = a * next[j + 1] + b * next[j];
+        }
+    }
+
+    // adjoint sweep: bar of level i , pushed onto level i + 1 through the rollback or onto the spots through an exercise
+    for (std::vector<double>& bar : work.adjoint){
+        bar.assign(m , 0.0);
+    }
+    work.spot_up_adjoint.assign(m , 0.0);
+    work.down_adjoint.assign(m , 0.0);
+    double* su_bar = work.spot_up_adjoint.data();
+    double* d_bar = work.down_adjoint.data();
+    double a_bar = 0.0 , b_bar = 0.0;
+    work.adjoint[0][0] = 1.0;
+    for (int i = 0; i <= n; ++i){
+        double* bar = work.adjoint[i & 1].data();
+        double* below = work.adjoint[(i + 1) & 1].data();
+        const double* next = i < n ? level(i + 1) : nullptr;
+        if (i < n){
+            std::fill(below , below + i + 2 , 0.0);
+        }
+        for (int k = 0; k <= i; ++k){
+            const int j = node(i , k);
+            const double vb = bar[j];
+            if (vb == 0.0){
+                continue;
+            }
+            if (k < work.exercised[i]){
+                su_bar[j] += vb * w * down[i - j];
+                d_bar[i - j] += vb * w * spot_up[j];
+            }
+            else if (i < n){
+                a_bar += vb * next[j + 1];
+                b_bar += vb * next[j];
+                below[j + 1] += a * vb;
+                below[j] += b * vb;
+            }
+        }
+    }
+
+    // spot_up[j] = S u^j , down[k] = d^k
+    double S_bar = 0.0 , u_bar = 0.0 , dd_bar = 0.0 , u_pow = 1.0 , d_pow = 1.0;
+    for (size_t j = 0; j < m; ++j){
+        S_bar += su_bar[j] * u_pow;
+        if (j > 0){
+            u_bar += su_bar[j] * static_cast<double>(j) * S.value() * u_pow / u.value();
+            dd_bar += d_bar[j] * static_cast<double>(j) * d_pow / d.value();
+        }
+        u_pow *= u.value();
+        d_pow *= d.value();
+    }
+
+    const AadReal* args[5] = {&S , &u , &d , &pu , &pd};
+    const double partials[5] = {S_bar , u_bar , dd_bar , a_bar , b_bar};
+    return AadReal::make(level(0)[0] , 5 , args , partials);
+}
+
+// tree parameters of AmericanOption::params on the tape , then the rollback node
+AadReal taped_lattice(const AadReal& S , double K , const AadReal& T , const AadReal& r , const AadReal& q , const AadReal& sigma ,
+                      bool call , const BinomialTree::Config& config){
+    int n = std::max(config.num_steps , 1);
+    if (config.tree == AmericanOption::TreeType::LEISEN_REIMER && n % 2 == 0){
+        ++n;
+    }
+    const AadReal dt = T / static_cast<double>(n);
+    const AadReal growth = exp((r - q) * dt);
+    const AadReal disc = exp(-r * dt);
+
+    AadReal u , d , p;
+    if (config.tree == AmericanOption::TreeType::LEISEN_REIMER){
+        const AadReal sig_sqrt_T = sigma * sqrt(T);
+        const AadReal d1 = (log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / sig_sqrt_T;
+        p = peizer_pratt(d1 - sig_sqrt_T , n);
+        u = growth * peizer_pratt(d1 , n) / p;
+        d = (growth - p * u) / (1.0 - p);
+    }
+    else{
+        u = exp(sigma * sqrt(dt));
+        d = 1.0 / u;
+        p = (growth - d) / (u - d);
+    }
+    return rollback(S , u , d , disc * p , disc * (1.0 - p) , K , call , n);
+}
+
+} // namespace
+
+Sensitivities BinomialTree::sensitivities(const Option& option , const MarketData& marketdata) const {
+    PRICING_TIME(BINOMIAL_TREE , CALL);
+    PRICING_COUNT(BINOMIAL_TREE , OPTIONS , 1);
+    AadTape& tape = AadTape::local();
+    const AadTape::Mark start = tape.mark();
+    const AadReal S = AadReal::input(marketdata.spot_);
+    const AadReal sigma = AadReal::input(marketdata.volatility_);
+    const AadReal r = AadReal::input(marketdata.rate_);
+    const AadReal q = AadReal::input(marketdata.dividend_);
+    const AadReal T = AadReal::input(option.expiry_);
+
+    Config config = config_;
+    if (config.tolerance > 0.0){
+        config.num_steps = converge(option.strike_ , option.expiry_ , option.type_ , marketdata).steps;
+    }
+    const AadReal value = taped_lattice(S , option.strike_ , T , r , q , sigma , option.type_ == Option::Type::CALL , config);
+    value.seed();
+    tape.propagate(tape.mark() , start);
+
+    Sensitivities out;
+    out.price = value.value();
+    out.spot = S.adjoint();
+    out.volatility = sigma.adjoint();
+    out.rate = r.adjoint();
+    out.dividend = q.adjoint();
+    out.expiry = T.adjoint();
+    tape.rewind(start);
+    return out;
+}
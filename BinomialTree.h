@@ -0,0 +1,64 @@
+#pragma once
+#include "PricingMain.h"
+#include "AmericanOptionp.hpp"
+
+/*
+ * American exercise on the binomial lattices of AmericanOptionp.hpp , behind the PricingModel batch interface
+ * - one AmericanOption is set up per contract on the stack , no heap , and priced through its concrete type
+ *   so the lattice calls are not virtual
+ * - greeks come off the lattice (delta , gamma , theta) plus the vega / rho bumps , same units as the other models
+ * - marketdata.dividend_ is a continuous yield: the lattices grow at r - q and discount at r , so American calls on
+ *   dividend payers exercise early
+ * - tolerance > 0 picks the step count per contract: starting from num_steps it prices N and 2N steps and doubles until
+ *   the Richardson estimate of the error of the 2N price , |P(2N) - P(N)| / (2N / N - 1) , is within tolerance or
+ *   max_steps is reached , greeks and sensitivities use the step count found
+ * - the estimate takes first order convergence: early exercise makes Leisen-Reimer first order too (its 1/N^2 is for
+ *   the European) , the CRR estimate is rougher since its error oscillates with N
+ * - sensitivities() tapes one lattice of the same tree (Aad.h) and sweeps it once , q is a taped input like r
+ */
+
+class BinomialTree : public PricingModel{
+
+public:
+    struct Config {
+        int num_steps;
+        AmericanOption::TreeType tree;
+        double tolerance;       // 0 = always num_steps , > 0 = double the steps until the price error estimate is within it
+        int max_steps;          // cap on the steps tolerance may grow to
+
+        Config() : num_steps(200) , tree(AmericanOption::TreeType::LEISEN_REIMER) , tolerance(0.0) , max_steps(8192){}
+    };
+
+    // price of the last lattice , its Richardson error estimate (infinite when not even one doubling fit) and steps
+    struct Result {
+        double price;
+        double error;
+        int steps;
+    };
+
+    BinomialTree() = default;
+    explicit BinomialTree(const Config& config);
+
+    double price(const Option& option, const MarketData& marketdata) const override;
+    Greeks greeks(const Option& option, const MarketData& marketdata) const override;
+    Valuation evaluate(const Option& option , const MarketData& marketdata , unsigned request = Valuation::PRICE | Valuation::GREEKS) const override;
+    Sensitivities sensitivities(const Option& option , const MarketData& marketdata) const override;
+
+    // the step count search of tolerance , run whatever tolerance is (a tolerance of 0 doubles up to max_steps)
+    Result run(const Option& option , const MarketData& marketdata) const;
+
+    void price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const override;
+    void price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const override;
+
+    const Config& config() const {return config_;}
+
+private:
+    Config config_;
+
+    AmericanOption lattice(double K , double T , Option::Type type , const MarketData& marketdata , int steps) const;
+    AmericanOption lattice(double K , double T , Option::Type type , const MarketData& marketdata) const;
+    Result converge(double K , double T , Option::Type type , const MarketData& marketdata) const;
+    double value(double K , double T , Option::Type type , const MarketData& marketdata) const;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <cmath>
+#include "OptionMain.h"
+#include "NormalCdf.h"
+
+/*
+ * Black Scholes with the contract traits fixed at compile time
+ * - Call: call or put , Dividend: false drops every e^-qT and q term , Request: Valuation::Request mask of what to compute,
+ *   Accuracy: which N(x) of NormalCdf.h
+ * - all four are template parameters , so the branches on them are if constexpr and vanish,
+ *   a price only kernel never touches n(d1) , a delta/gamma kernel never computes e^-rT
+ * - batch callers partition their rows by traits once and then run one instantiation per partition
+ * - POLYNOMIAL takes N(d1) , N(d2) and n(d1) off one exp through K e^-rT n(d2) = S e^-qT n(d1) (polynomial_cdf_pair),
+ *   two exps and two divisions a row would lose to the exact erfc pair
+ * - the per expiry terms overload takes sqrt(T) , sigma sqrt(T) and both discount factors from the caller
+ *   (MarketSnapshot's cache) , every scalar Black Scholes value of BlackScholes goes through these formulas
+ */
+
+template <bool Call , bool Dividend , unsigned Request , CdfAccuracy Accuracy = CdfAccuracy::EXACT>
+struct BlackScholesKernel {
+
+    static constexpr bool want(unsigned bits) {return (Request & bits) != 0;}
+
+    static constexpr bool NEED_CDF = want(Valuation::PRICE | Valuation::DELTA | Valuation::THETA | Valuation::RHO | Valuation::CHARM);
+    static constexpr bool NEED_PDF = want(Valuation::GAMMA | Valuation::VEGA | Valuation::THETA | Valuation::SECOND_ORDER);
+    static constexpr bool NEED_EXP_RT = want(Valuation::PRICE | Valuation::THETA | Valuation::RHO);
+    static constexpr double W = Call ? 1.0 : -1.0;
+    // N(d2) is only read next to e^-rT , POLYNOMIAL then gets both N (and n(d1)) off one gaussian
+    static constexpr bool SHARED_GAUSSIAN = NEED_CDF && NEED_EXP_RT && Accuracy == CdfAccuracy::POLYNOMIAL;
+
+    static double cdf(double x) {return normal_cdf<Accuracy>(x);}
+    static double pdf(double x) {return 0.3989422804014327 * std::exp(-0.5 * x * x);}
+
+    static Valuation evaluate(double S , double K , double T , double r , double q , double sigma){
+        const double sqrt_T = std::sqrt(T);
+        const double exp_qT = Dividend ? std::exp(-q * T) : 1.0;
+        double exp_rT = 0.0;
+        if constexpr (NEED_EXP_RT){
+            exp_rT = std::exp(-r * T);
+        }
+        return evaluate(S , K , r , q , sigma , T , sqrt_T , sigma * sqrt_T , exp_qT , exp_rT);
+    }
+
+    // exp_qT is only read with Dividend , exp_rT only when the request needs e^-rT
+    static Valuation evaluate(double S , double K , double r , double q , double sigma ,
+                              double T , double sqrt_T , double sig_sqrt_T , double exp_qT , double exp_rT){
+        const double carry = Dividend ? r - q : r;
+        const double d1 = (std::log(S / K) + (carry + 0.5 * sigma * sigma) * T) / sig_sqrt_T;
+        const double d2 = d1 - sig_sqrt_T;
+        if constexpr (!Dividend){
+            exp_qT = 1.0;
+        }
+        const double S_q = Dividend ? S * exp_qT : S;
+
+        double Nw1 = 0.0;
+        double Nw2 = 0.0;
+        double npd1 = 0.0;
+        if constexpr (SHARED_GAUSSIAN){
+            // exp(-d2^2/2) = exp(-d1^2/2) S e^-qT / (K e^-rT) , one exp and one division for both N and n(d1)
+            const double g1 = std::exp(-0.5 * d1 * d1);
+            polynomial_cdf_pair(W * d1 , W * d2 , g1 , S_q , K * exp_rT , Nw1 , Nw2);
+            npd1 = 0.3989422804014327 * g1;
+        }
+        else{
+            if constexpr (NEED_CDF){
+                Nw1 = cdf(W * d1);
+                Nw2 = cdf(W * d2);
+            }
+            if constexpr (NEED_PDF){
+                npd1 = pdf(d1);
+            }
+        }
+
+        Valuation v;
+        if constexpr (want(Valuation::PRICE)){
+            v.price = W * (S_q * Nw1 - K * exp_rT * Nw2);
+        }
+        if constexpr (want(Valuation::DELTA)){
+            v.greeks.delta = W * exp_qT * Nw1;
+        }
+        if constexpr (want(Valuation::GAMMA)){
+            v.greeks.gamma = exp_qT * npd1 / (S * sig_sqrt_T);
+        }
+        if constexpr (want(Valuation::VEGA)){
+            v.greeks.vega = S_q * npd1 * sqrt_T / 100.0;
+        }
+        if constexpr (want(Valuation::THETA)){
+            double theta_annual = -S_q * npd1 * sigma / (2.0 * sqrt_T) - W * r * K * exp_rT * Nw2;
+            if constexpr (Dividend){
+                theta_annual += W * q * S_q * Nw1;
+            }
+            v.greeks.theta = theta_annual / 365.0;
+        }
+        if constexpr (want(Valuation::RHO)){
+            v.greeks.rho = W * K * T * exp_rT * Nw2 / 100.0;
+        }
+        if constexpr (want(Valuation::VANNA)){
+            v.vanna = -exp_qT * npd1 * d2 / sigma / 100.0;
+        }
+        if constexpr (want(Valuation::VOLGA)){
+            v.volga = S_q * npd1 * sqrt_T * d1 * d2 / sigma / 10000.0;
+        }
+        if constexpr (want(Valuation::CHARM)){
+            double charm_annual = -exp_qT * npd1 * (2.0 * carry * T - d2 * sig_sqrt_T) / (2.0 * T * sig_sqrt_T);
+            if constexpr (Dividend){
+                charm_annual += W * q * exp_qT * Nw1;
+            }
+            v.charm = charm_annual / 365.0;
+        }
+        return v;
+    }
+
+    static double price(double S , double K , double T , double r , double q , double sigma){
+        return BlackScholesKernel<Call , Dividend , Valuation::PRICE , Accuracy>::evaluate(S , K , T , r , q , sigma).price;
+    }
+};
@@ -0,0 +1,187 @@
+#include "BlackScholesSimd.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BS_SIMD_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define BS_SIMD_NEON 1
+#endif
+
+// vectors wider than the default target only ever live inside their own target region below,
+// and gcc 12 flags the _mm512_undefined_pd() inside its own _mm512_sqrt_pd as maybe uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#define BS_INLINE inline __attribute__((always_inline))
+
+/*
+ * The kernel in BlackScholesSimdKernel.h is written once with GCC vector extensions
+ * and stamped out per instruction set , each copy in its own namespace and compiled for its own target.
+ */
+
+namespace {
+
+#define BS_SIMD_WIDTH 1
+#define BS_SIMD_SQRT(x) vd{std::sqrt((x)[0])}
+namespace simd_generic {
+#include "BlackScholesSimdKernel.h"
+}
+#undef BS_SIMD_WIDTH
+#undef BS_SIMD_SQRT
+
+#if BS_SIMD_X86
+#define BS_SIMD_WIDTH 2
+#define BS_SIMD_SQRT(x) (vd)_mm_sqrt_pd((__m128d)(x))
+namespace simd_sse2 {
+#include "BlackScholesSimdKernel.h"
+}
+#undef BS_SIMD_WIDTH
+#undef BS_SIMD_SQRT
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define BS_SIMD_WIDTH 4
+#define BS_SIMD_SQRT(x) (vd)_mm256_sqrt_pd((__m256d)(x))
+namespace simd_avx2 {
+#include "BlackScholesSimdKernel.h"
+}
+#undef BS_SIMD_WIDTH
+#undef BS_SIMD_SQRT
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#define BS_SIMD_WIDTH 8
+#define BS_SIMD_SQRT(x) (vd)_mm512_sqrt_pd((__m512d)(x))
+namespace simd_avx512 {
+#include "BlackScholesSimdKernel.h"
+}
+#undef BS_SIMD_WIDTH
+#undef BS_SIMD_SQRT
+#pragma GCC pop_options
+#endif
+
+#if BS_SIMD_NEON
+#define BS_SIMD_WIDTH 2
+#define BS_SIMD_SQRT(x) (vd)vsqrtq_f64((float64x2_t)(x))
+namespace simd_neon {
+#include "BlackScholesSimdKernel.h"
+}
+#undef BS_SIMD_WIDTH
+#undef BS_SIMD_SQRT
+#endif
+
+bool supported(BlackScholesSimd::Isa isa){
+    switch (isa){
+    case BlackScholesSimd::Isa::SCALAR:
+        return true;
+#if BS_SIMD_X86
+    case BlackScholesSimd::Isa::SSE2:
+        return true;
+    case BlackScholesSimd::Isa::AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case BlackScholesSimd::Isa::AVX512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+#if BS_SIMD_NEON
+    case BlackScholesSimd::Isa::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+
+BlackScholesSimd::Isa BlackScholesSimd::detect(){
+    static const Isa best = [](){
+        const Isa order[] = {Isa::AVX512 , Isa::AVX2 , Isa::NEON , Isa::SSE2};
+        for (Isa isa : order){
+            if (supported(isa)){
+                return isa;
+            }
+        }
+        return Isa::SCALAR;
+    }();
+    return best;
+}
+
+const char* BlackScholesSimd::name(Isa isa){
+    switch (isa){
+    case Isa::SSE2: return "sse2";
+    case Isa::NEON: return "neon";
+    case Isa::AVX2: return "avx2";
+    case Isa::AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+size_t BlackScholesSimd::width(Isa isa){
+    switch (isa){
+    case Isa::SSE2: return 2;
+    case Isa::NEON: return 2;
+    case Isa::AVX2: return 4;
+    case Isa::AVX512: return 8;
+    default: return 1;
+    }
+}
+
+// an isa the cpu cannot run falls back to the best one it can
+
+void BlackScholesSimd::price(const OptionBatch& batch , const Market& market , double* out , Isa isa , CdfAccuracy accuracy){
+    if (!supported(isa)){
+        isa = detect();
+    }
+    switch (isa){
+#if BS_SIMD_X86
+    case Isa::AVX512: simd_avx512::price(batch , market , out , accuracy); return;
+    case Isa::AVX2: simd_avx2::price(batch , market , out , accuracy); return;
+    case Isa::SSE2: simd_sse2::price(batch , market , out , accuracy); return;
+#endif
+#if BS_SIMD_NEON
+    case Isa::NEON: simd_neon::price(batch , market , out , accuracy); return;
+#endif
+    default: simd_generic::price(batch , market , out , accuracy); return;
+    }
+}
+
+void BlackScholesSimd::greeks(const OptionBatch& batch , const Market& market , const GreeksBatch& out , Isa isa , CdfAccuracy accuracy){
+    if (!supported(isa)){
+        isa = detect();
+    }
+    switch (isa){
+#if BS_SIMD_X86
+    case Isa::AVX512: simd_avx512::greeks(batch , market , out , accuracy); return;
+    case Isa::AVX2: simd_avx2::greeks(batch , market , out , accuracy); return;
+    case Isa::SSE2: simd_sse2::greeks(batch , market , out , accuracy); return;
+#endif
+#if BS_SIMD_NEON
+    case Isa::NEON: simd_neon::greeks(batch , market , out , accuracy); return;
+#endif
+    default: simd_generic::greeks(batch , market , out , accuracy); return;
+    }
+}
+
+void BlackScholesSimd::implied_vol(const OptionBatch& batch , const Market& market , const double* prices , double* out , Isa isa){
+    if (!supported(isa)){
+        isa = detect();
+    }
+    switch (isa){
+#if BS_SIMD_X86
+    case Isa::AVX512: simd_avx512::implied_vol(batch , market , prices , out); return;
+    case Isa::AVX2: simd_avx2::implied_vol(batch , market , prices , out); return;
+    case Isa::SSE2: simd_sse2::implied_vol(batch , market , prices , out); return;
+#endif
+#if BS_SIMD_NEON
+    case Isa::NEON: simd_neon::implied_vol(batch , market , prices , out); return;
+#endif
+    default: simd_generic::implied_vol(batch , market , prices , out); return;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "OptionBook.h"
+#include "NormalCdf.h"
+
+/*
+ * - Vectorized Black Scholes kernel for the batch API
+ * - d1/d2 , N(d) , n(d) , price and all five Greeks for a full register of options at once
+ *   (2 doubles with SSE2/NEON , 4 with AVX2 , 8 with AVX-512)
+ * - exp , log and erfc are evaluated with our own vector approximations (Cody's rational erfc),
+ *   accurate to a few ulp so results track the scalar std::erf path to ~1e-12 relative
+ * - instruction set is picked at runtime from what the cpu supports
+ * - price / greeks take a CdfAccuracy tier (NormalCdf.h) , cheaper tiers swap Cody's erfc for the matching vector formula
+ */
+
+class BlackScholesSimd {
+
+public:
+    enum class Isa {SCALAR , SSE2 , NEON , AVX2 , AVX512};
+
+    // market inputs seen by the kernel, stride 0 means one value shared by every row
+    // otherwise row i reads spot[i*stride] (used to walk an array of MarketData in place)
+    // volatility has its own stride so a per row vol column (e.g. off a VolSurface) can ride on a shared market
+    struct Market {
+        const double* spot;
+        const double* rate;
+        const double* dividend;
+        const double* volatility;
+        size_t stride;
+        size_t volatility_stride;
+    };
+
+    // best instruction set available on this cpu , detected once
+    static Isa detect();
+    static const char* name(Isa isa);
+    static size_t width(Isa isa);
+
+    static void price(const OptionBatch& batch , const Market& market , double* out , Isa isa = detect() ,
+                      CdfAccuracy accuracy = CdfAccuracy::EXACT);
+    static void greeks(const OptionBatch& batch , const Market& market , const GreeksBatch& out , Isa isa = detect() ,
+                       CdfAccuracy accuracy = CdfAccuracy::EXACT);
+
+    // implied vols of prices[i] , market.volatility is not read
+    static void implied_vol(const OptionBatch& batch , const Market& market , const double* prices , double* out , Isa isa = detect());
+
+};
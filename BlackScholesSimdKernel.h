@@ -0,0 +1,525 @@
+// no include guard on purpose: BlackScholesSimd.cpp includes this once per instruction set,
+// each time inside its own namespace and under a matching #pragma GCC target , with
+//  - BS_SIMD_WIDTH           doubles per register
+//  - BS_SIMD_SQRT(x)         full precision vector sqrt for that isa
+// so the kernel is written once and compiled natively for every isa we dispatch to
+
+static const int W = BS_SIMD_WIDTH;
+
+typedef double vd __attribute__((vector_size(W * 8)));
+typedef long long vi __attribute__((vector_size(W * 8)));
+typedef int vi32 __attribute__((vector_size(W * 4)));
+
+static BS_INLINE vd splat(double x){return vd{} + x;}
+
+static BS_INLINE vd select(vi mask , vd a , vd b){return mask ? a : b;}
+
+static BS_INLINE vd abs(vd x){
+    return (vd)((vi)x & (vi{} + 0x7FFFFFFFFFFFFFFFLL));
+}
+
+// round to nearest through the 1.5*2^52 trick , valid for |x| < 2^51
+static BS_INLINE vd round(vd x){
+    const vd magic = splat(6755399441055744.0);
+    return (x + magic) - magic;
+}
+
+static BS_INLINE vd floor(vd x){
+    vd r = round(x);
+    return select(r > x , r - 1.0 , r);
+}
+
+// exp: x = n*ln2 + r with |r| <= ln2/2 , degree 13 Taylor on r (truncation ~4e-18) , scale by 2^n through the exponent bits
+static BS_INLINE vd exp(vd x){
+    const vd magic = splat(6755399441055744.0);
+    const double LOG2E = 1.4426950408889634074;
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+
+    vi underflow = x < -708.0;
+    x = select(x > 709.0 , splat(709.0) , x);
+    x = select(underflow , splat(-708.0) , x);
+
+    vd kn = x * LOG2E + magic;
+    vd n = kn - magic;
+    vd r = (x - n * LN2_HI) - n * LN2_LO;
+
+    vd p = splat(1.0 / 6227020800.0);
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    vi ni = (vi)kn - (vi)magic;
+    vd scale = (vd)((ni + 1023) << 52);
+    return select(underflow , splat(0.0) , p * scale);
+}
+
+// log for positive normal x: x = 2^e * m with m in [sqrt(1/2) , sqrt(2)) , log(m) = 2 atanh((m-1)/(m+1)) as a series in s^2
+static BS_INLINE vd log(vd x){
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+
+    vi bits = (vi)x;
+    vi e = (bits >> 52) - 1023;
+    vd m = (vd)((bits & 0x000FFFFFFFFFFFFFLL) | 0x3FF0000000000000LL);
+
+    vi big = m > 1.4142135623730951;
+    m = select(big , m * 0.5 , m);
+    e = e - big;
+
+    // integer to double without a 64 bit convert instruction (not in AVX2)
+    const vd magic = splat(4503599627370496.0 + 1024.0);
+    vd ed = (vd)((e + 1024) | 0x4330000000000000LL) - magic;
+
+    vd f = m - 1.0;
+    vd s = f / (m + 1.0);
+    vd s2 = s * s;
+
+    vd p = splat(1.0 / 23.0);
+    p = p * s2 + 1.0 / 21.0;
+    p = p * s2 + 1.0 / 19.0;
+    p = p * s2 + 1.0 / 17.0;
+    p = p * s2 + 1.0 / 15.0;
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+
+    vd logm = 2.0 * s + 2.0 * s * s2 * p;
+    return ed * LN2_HI + (logm + ed * LN2_LO);
+}
+
+// W. J. Cody , "Rational Chebyshev approximations for the error function" (CALERF) , three regions blended per lane
+static BS_INLINE vd erfc(vd z){
+    static const double a[5] = {3.16112374387056560e00, 1.13864154151050156e02, 3.77485237685302021e02,
+                                3.20937758913846947e03, 1.85777706184603153e-1};
+    static const double b[4] = {2.36012909523441209e01, 2.44024637934444173e02, 1.28261652607737228e03,
+                                2.84423683343917062e03};
+    static const double c[9] = {5.64188496988670089e-1, 8.88314979438837594e00, 6.61191906371416295e01,
+                                2.98635138197400131e02, 8.81952221241769090e02, 1.71204761263407058e03,
+                                2.05107837782607147e03, 1.23033935479799725e03, 2.15311535474403846e-8};
+    static const double d[8] = {1.57449261107098347e01, 1.17693950891312499e02, 5.37181101862009858e02,
+                                1.62138957456669019e03, 3.29079923573345963e03, 4.36261909014324716e03,
+                                3.43936767414372164e03, 1.23033935480374942e03};
+    static const double p[6] = {3.05326634961232344e-1, 3.60344899949804439e-1, 1.25781726111229246e-1,
+                                1.60837851487422766e-2, 6.58749161529837803e-4, 1.63153871373020978e-2};
+    static const double q[5] = {2.56852019228982242e00, 1.87295284992346725e00, 5.27905102951428412e-1,
+                                6.05183413124413191e-2, 2.33520497626869185e-3};
+    const double SQRPI = 5.6418958354775628695e-1;
+
+    vd y = abs(z);
+
+    // |z| <= 0.46875 : erf(z) = z * R(z^2)
+    vd ysq = y * y;
+    vd xnum = a[4] * ysq;
+    vd xden = ysq;
+    for (int i = 0; i < 3; ++i){
+        xnum = (xnum + a[i]) * ysq;
+        xden = (xden + b[i]) * ysq;
+    }
+    vd small = 1.0 - z * (xnum + a[3]) / (xden + b[3]);
+
+    // 0.46875 < |z| <= 4 : erfc(y) = exp(-y^2) * R(y)
+    xnum = c[8] * y;
+    xden = y;
+    for (int i = 0; i < 7; ++i){
+        xnum = (xnum + c[i]) * y;
+        xden = (xden + d[i]) * y;
+    }
+    vd mid = (xnum + c[7]) / (xden + d[7]);
+
+    // |z| > 4 : erfc(y) = exp(-y^2)/y * (1/sqrt(pi) + R(1/y^2)/y^2)
+    vd inv = 1.0 / ysq;
+    xnum = p[5] * inv;
+    xden = inv;
+    for (int i = 0; i < 4; ++i){
+        xnum = (xnum + p[i]) * inv;
+        xden = (xden + q[i]) * inv;
+    }
+    vd tail = (SQRPI - inv * (xnum + p[4]) / (xden + q[4])) / y;
+
+    vd r = select(y <= 4.0 , mid , tail);
+
+    // exp(-y^2) split as exp(-h^2)*exp(-(y-h)(y+h)) with h = y rounded down to 1/16 so the exponent is exact
+    vd h = floor(y * 16.0) * 0.0625;
+    vd del = (y - h) * (y + h);
+    vd large = exp(-h * h) * exp(-del) * r;
+    large = select(z < 0.0 , 2.0 - large , large);
+
+    return select(y <= 0.46875 , small , large);
+}
+
+static BS_INLINE vd norm_cdf(vd x){return 0.5 * erfc(x * -0.70710678118654752440);}
+
+static BS_INLINE vd norm_pdf(vd x){return 0.3989422804014327 * exp(-0.5 * x * x);}
+
+// the cheaper tiers of NormalCdf.h , same formulas lane by lane , both signs computed and blended
+template <CdfAccuracy Accuracy>
+static BS_INLINE vd cdf(vd x){
+    if constexpr (Accuracy == CdfAccuracy::RATIONAL){
+        vd y = abs(x);
+        vd num = splat(3.52624965998911e-02);
+        num = num * y + 0.700383064443688;
+        num = num * y + 6.37396220353165;
+        num = num * y + 33.912866078383;
+        num = num * y + 112.079291497871;
+        num = num * y + 221.213596169931;
+        num = num * y + 220.206867912376;
+        vd den = splat(8.83883476483184e-02);
+        den = den * y + 1.75566716318264;
+        den = den * y + 16.064177579207;
+        den = den * y + 86.7807322029461;
+        den = den * y + 296.564248779674;
+        den = den * y + 637.333633378831;
+        den = den * y + 793.826512519948;
+        den = den * y + 440.413735824752;
+        vd tail = exp(-0.5 * y * y) * num / den;
+        return select(x > 0.0 , 1.0 - tail , tail);
+    }
+    else if constexpr (Accuracy == CdfAccuracy::POLYNOMIAL){
+        vd y = abs(x);
+        vd t = 1.0 / (1.0 + 0.2316419 * y);
+        vd poly = t * (0.319381530 + t * (-0.356563782 + t * (1.781477937 + t * (-1.821255978 + t * 1.330274429))));
+        vd tail = 0.3989422804014327 * exp(-0.5 * y * y) * poly;
+        return select(x > 0.0 , 1.0 - tail , tail);
+    }
+    else if constexpr (Accuracy == CdfAccuracy::TABLE){
+        const NormalCdfTable& table = NormalCdfTable::get();
+        vd clamped = select(x > NormalCdfTable::LO , x , splat(NormalCdfTable::LO));
+        clamped = select(clamped < NormalCdfTable::HI , clamped , splat(NormalCdfTable::HI));
+        vd u = (clamped - NormalCdfTable::LO) * NormalCdfTable::SCALE;
+        vd s , c0 , c1 , c2 , c3;
+        for (int i = 0; i < W; ++i){
+            int j = static_cast<int>(u[i]);
+            j = j < NormalCdfTable::INTERVALS - 1 ? j : NormalCdfTable::INTERVALS - 1;
+            const double* c = table.cubic[j].c;
+            s[i] = u[i] - j;
+            c0[i] = c[0];
+            c1[i] = c[1];
+            c2[i] = c[2];
+            c3[i] = c[3];
+        }
+        return select(x == x , c0 + s * (c1 + s * (c2 + s * c3)) , x);
+    }
+    else{
+        return norm_cdf(x);
+    }
+}
+
+static BS_INLINE vd load(const double* p){
+    vd v;
+    std::memcpy(&v , p , sizeof(v));
+    return v;
+}
+
+static BS_INLINE void store(double* p , vd v){std::memcpy(p , &v , sizeof(v));}
+
+static BS_INLINE vd load_market(const double* p , size_t stride){
+    if (stride == 0){
+        return splat(*p);
+    }
+    vd v;
+    for (int i = 0; i < W; ++i){
+        v[i] = p[i * stride];
+    }
+    return v;
+}
+
+// +1 for calls , -1 for puts so both payoffs share one formula: w*(S e^-qT N(w d1) - K e^-rT N(w d2))
+static BS_INLINE vd sign(const Option::Type* type){
+    vi32 t;
+    std::memcpy(&t , type , sizeof(t));
+    vi is_call = __builtin_convertvector(t == static_cast<int>(Option::Type::CALL) , vi);
+    return select(is_call , splat(1.0) , splat(-1.0));
+}
+
+// one register of options starting at row i , writes price or all greeks
+template<bool WantGreeks , CdfAccuracy Accuracy>
+static BS_INLINE void block(const double* Kp , const double* Tp , const Option::Type* typep ,
+                            const BlackScholesSimd::Market& m , size_t i ,
+                            double* price , const GreeksBatch& g , size_t o){
+    vd K = load(Kp);
+    vd T = load(Tp);
+    vd w = sign(typep);
+    vd S = load_market(m.spot + i * m.stride , m.stride);
+    vd r = load_market(m.rate + i * m.stride , m.stride);
+    vd q = load_market(m.dividend + i * m.stride , m.stride);
+    vd sigma = load_market(m.volatility + i * m.volatility_stride , m.volatility_stride);
+
+    vd sqrt_T = BS_SIMD_SQRT(T);
+    vd sst = sigma * sqrt_T;
+    vd d1 = (log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / sst;
+    vd d2 = d1 - sst;
+    vd exp_qT = exp(-q * T);
+    vd exp_rT = exp(-r * T);
+    vd Nw1 = cdf<Accuracy>(w * d1);
+    vd Nw2 = cdf<Accuracy>(w * d2);
+
+    if (!WantGreeks){
+        store(price + o , w * (S * exp_qT * Nw1 - K * exp_rT * Nw2));
+        return;
+    }
+
+    vd npd1 = norm_pdf(d1);
+    store(g.delta + o , w * exp_qT * Nw1);
+    store(g.gamma + o , exp_qT * npd1 / (S * sst));
+    store(g.vega + o , S * exp_qT * npd1 * sqrt_T / 100.0);
+    vd theta_annual = -S * npd1 * sigma * exp_qT / (2.0 * sqrt_T)
+                      - w * r * K * exp_rT * Nw2
+                      + w * q * S * exp_qT * Nw1;
+    store(g.theta + o , theta_annual / 365.0);
+    store(g.rho + o , w * K * T * exp_rT * Nw2 / 100.0);
+}
+
+template<bool WantGreeks , CdfAccuracy Accuracy>
+static void run(const OptionBatch& batch , const BlackScholesSimd::Market& m ,
+                double* price , const GreeksBatch& g){
+    const size_t n = batch.size();
+    size_t i = 0;
+    for (; i + W <= n; i += W){
+        block<WantGreeks , Accuracy>(batch.strike_ + i , batch.expiry_ + i , batch.type_ + i , m , i , price , g , i);
+    }
+    if (i == n){
+        return;
+    }
+
+    // tail: pad one register with harmless rows so the remainder goes through the same arithmetic
+    double K[W] , T[W];
+    Option::Type type[W];
+    double S[W] , r[W] , q[W] , sigma[W];
+    double out[5][W];
+    const size_t rest = n - i;
+    for (size_t j = 0; j < static_cast<size_t>(W); ++j){
+        const bool live = j < rest;
+        const size_t src = i + (live ? j : 0);
+        const size_t row = src * m.stride;
+        K[j] = live ? batch.strike_[i + j] : 1.0;
+        T[j] = live ? batch.expiry_[i + j] : 1.0;
+        type[j] = live ? batch.type_[i + j] : Option::Type::CALL;
+        S[j] = m.spot[row];
+        r[j] = m.rate[row];
+        q[j] = m.dividend[row];
+        sigma[j] = m.volatility[src * m.volatility_stride];
+    }
+    BlackScholesSimd::Market padded = {S , r , q , sigma , 1 , 1};
+    GreeksBatch tmp(out[0] , out[1] , out[2] , out[3] , out[4]);
+    block<WantGreeks , Accuracy>(K , T , type , padded , 0 , out[0] , tmp , 0);
+
+    for (size_t j = 0; j < rest; ++j){
+        if (!WantGreeks){
+            price[i + j] = out[0][j];
+            continue;
+        }
+        g.delta[i + j] = out[0][j];
+        g.gamma[i + j] = out[1][j];
+        g.vega[i + j] = out[2][j];
+        g.theta[i + j] = out[3][j];
+        g.rho[i + j] = out[4][j];
+    }
+}
+
+template<bool WantGreeks>
+static void run(const OptionBatch& batch , const BlackScholesSimd::Market& m , double* price , const GreeksBatch& g , CdfAccuracy accuracy){
+    switch (accuracy){
+    case CdfAccuracy::RATIONAL: run<WantGreeks , CdfAccuracy::RATIONAL>(batch , m , price , g); return;
+    case CdfAccuracy::POLYNOMIAL: run<WantGreeks , CdfAccuracy::POLYNOMIAL>(batch , m , price , g); return;
+    case CdfAccuracy::TABLE: run<WantGreeks , CdfAccuracy::TABLE>(batch , m , price , g); return;
+    default: run<WantGreeks , CdfAccuracy::EXACT>(batch , m , price , g); return;
+    }
+}
+
+void price(const OptionBatch& batch , const BlackScholesSimd::Market& market , double* out , CdfAccuracy accuracy){
+    run<false>(batch , market , out , GreeksBatch() , accuracy);
+}
+
+void greeks(const OptionBatch& batch , const BlackScholesSimd::Market& market , const GreeksBatch& out , CdfAccuracy accuracy){
+    run<true>(batch , market , nullptr , out , accuracy);
+}
+
+static BS_INLINE bool all(vi mask){
+    for (int i = 0; i < W; ++i){
+        if (!mask[i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+static BS_INLINE bool any(vi mask){
+    for (int i = 0; i < W; ++i){
+        if (mask[i]){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Acklam's inverse normal cdf (see Random.h) , central and tail rational forms blended per lane
+static BS_INLINE vd inverse_normal_cdf(vd p){
+    static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                3.754408661907416e+00};
+
+    vd q = p - 0.5;
+    vd r = q * q;
+    vd central = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5]) * q /
+                 (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+
+    vi low = p < 0.5;
+    vd t = BS_SIMD_SQRT(-2.0 * log(select(low , p , 1.0 - p)));
+    vd tail = (((((c[0]*t + c[1])*t + c[2])*t + c[3])*t + c[4])*t + c[5]) /
+              ((((d[0]*t + d[1])*t + d[2])*t + d[3])*t + 1.0);
+    tail = select(low , tail , -tail);
+    return select(abs(q) <= 0.5 - 0.02425 , central , tail);
+}
+
+// implied vols of one register , same normalised Householder scheme as BlackScholes::implied_vol ,
+// every lane steps until all of them have converged (finished lanes are frozen)
+static BS_INLINE void implied_vol_block(const double* Kp , const double* Tp , const Option::Type* typep ,
+                                        const BlackScholesSimd::Market& m , size_t i , const double* pricep , double* out){
+    const int MAX_ITERATIONS = 16;
+    const double INF = __builtin_inf();
+
+    vd K = load(Kp);
+    vd T = load(Tp);
+    vd w = sign(typep);
+    vd S = load_market(m.spot + i * m.stride , m.stride);
+    vd r = load_market(m.rate + i * m.stride , m.stride);
+    vd q = load_market(m.dividend + i * m.stride , m.stride);
+    vd price = load(pricep);
+
+    vi expired = !(T > 0.0);
+    T = select(expired , splat(1.0) , T);
+    vd F = S * exp((r - q) * T);
+    vd x = log(F / K);
+    vd ex = exp(0.5 * x);
+    vd emx = 1.0 / ex;
+    vd beta = price / (exp(-r * T) * BS_SIMD_SQRT(F * K)) - select(w * (ex - emx) > 0.0 , w * (ex - emx) , splat(0.0));
+
+    // out of the money side: x <= 0 , e^(x/2) <= 1
+    vi itm = x > 0.0;
+    x = -abs(x);
+    vd t_ex = select(itm , emx , ex);
+    emx = select(itm , ex , emx);
+    ex = t_ex;
+
+    vi at_intrinsic = beta == 0.0;
+    vi invalid = expired | !(beta > 0.0) | !(beta < ex);
+    // park invalid lanes on a harmless problem so they cannot hold up the others
+    x = select(invalid , splat(-1.0) , x);
+    ex = select(invalid , splat(0.60653065971263342) , ex);
+    emx = select(invalid , splat(1.6487212707001282) , emx);
+    beta = select(invalid , splat(0.1) , beta);
+
+    // initial guess by region against the inflection point , see BlackScholes::implied_vol
+    // (regions no lane falls in are skipped)
+    vi has_inflection = x < 0.0;
+    vd sc = BS_SIMD_SQRT(-2.0 * x);
+    vd bc = 0.5 * ex - emx * norm_cdf(-sc);
+    vi low = has_inflection & (beta < 0.1 * bc);
+    vi mid = has_inflection & (beta < bc + 0.7 * (ex - bc));
+    vi logarithmic = has_inflection & (beta < bc);
+
+    vd s = splat(1.0);
+    if (any(~mid)){
+        s = -2.0 * inverse_normal_cdf((ex - beta) / (ex + emx));
+    }
+    if (any(mid & ~low)){
+        vd s_mid = sc + (beta - bc) / (0.3989422804014327 * ex);
+        s = select(mid , select(s_mid > 0.1 * sc , s_mid , 0.1 * sc) , s);
+    }
+    vd log_beta = any(logarithmic) ? log(beta) : splat(0.0);
+    if (any(low)){
+        vd s_low = -x / BS_SIMD_SQRT(-2.0 * log_beta);
+        for (int k = 0; k < 2; ++k){
+            vd arg = 2.0 * (log(s_low * s_low * s_low / (x * x)) - 0.91893853320467274 - log_beta);
+            s_low = select(arg > 0.0 , -x / BS_SIMD_SQRT(arg) , s_low);
+        }
+        s = select(low , s_low , s);
+    }
+    const bool any_logarithmic = any(logarithmic);
+
+    vd lo = splat(0.0);
+    vd hi = splat(INF);
+    vi done = invalid;
+    for (int it = 0; it < MAX_ITERATIONS && !all(done); ++it){
+        vd inv_s = 1.0 / s;
+        vd xs = x * inv_s;
+        vd d1 = xs + 0.5 * s;
+        vd b = ex * norm_cdf(d1) - emx * norm_cdf(d1 - s);
+        vd vega = 0.3989422804014327 * exp(0.5 * x - 0.5 * d1 * d1);
+        vd h = xs * xs * inv_s - 0.25 * s;
+        vd dh = -3.0 * xs * xs * inv_s * inv_s - 0.25;
+        vd L = vega / b;
+
+        vd f = any_logarithmic ? select(logarithmic , log(b) - log_beta , b - beta) : b - beta;
+        vd df = select(logarithmic , L , vega);
+        vd a = select(logarithmic , h - L , h);
+        vd c = select(logarithmic , a * a + dh - L * a , h * h + dh);
+        lo = select(f < 0.0 , s , lo);
+        hi = select(f < 0.0 , hi , s);
+
+        vd ratio = -f / df;
+        vd step = ratio * (1.0 + 0.5 * a * ratio) / (1.0 + a * ratio + c * ratio * ratio * (1.0 / 6.0));
+        vd next = s + step;
+        vi converged = abs(step) <= 1e-3 * s;
+        vi inside = (next > lo) & (next < hi);
+        next = select(~inside & ~converged , select(hi < INF , 0.5 * (lo + hi) , 2.0 * s) , next);
+        s = select(done , s , next);
+        done = done | converged;
+    }
+
+    vd sigma = s / BS_SIMD_SQRT(T);
+    sigma = select(invalid , splat(__builtin_nan("")) , sigma);
+    store(out , select(at_intrinsic & !expired , splat(0.0) , sigma));
+}
+
+void implied_vol(const OptionBatch& batch , const BlackScholesSimd::Market& m , const double* prices , double* out){
+    const size_t n = batch.size();
+    size_t i = 0;
+    for (; i + W <= n; i += W){
+        implied_vol_block(batch.strike_ + i , batch.expiry_ + i , batch.type_ + i , m , i , prices + i , out + i);
+    }
+    if (i == n){
+        return;
+    }
+
+    // tail: pad with copies of its first row so the padding converges with it
+    double K[W] , T[W] , price[W] , res[W];
+    Option::Type type[W];
+    double S[W] , r[W] , q[W] , sigma[W];
+    const size_t rest = n - i;
+    for (size_t j = 0; j < static_cast<size_t>(W); ++j){
+        const size_t src = i + (j < rest ? j : 0);
+        K[j] = batch.strike_[src];
+        T[j] = batch.expiry_[src];
+        type[j] = batch.type_[src];
+        price[j] = prices[src];
+        S[j] = m.spot[src * m.stride];
+        r[j] = m.rate[src * m.stride];
+        q[j] = m.dividend[src * m.stride];
+        sigma[j] = m.volatility[src * m.volatility_stride];
+    }
+    BlackScholesSimd::Market padded = {S , r , q , sigma , 1 , 1};
+    implied_vol_block(K , T , type , padded , 0 , price , res);
+    for (size_t j = 0; j < rest; ++j){
+        out[i + j] = res[j];
+    }
+}
@@ -1,4 +1,97 @@
 #include "BlackScholesmain.h"
+#include "BlackScholesSimd.h"
+#include "BlackScholesKernel.h"
+#include "Aad.h"
+#include "Instrumentation.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// instrumentation counts per row: log , sqrt , two discount exps and two N(x) , the greeks add the density's exp
+// (the implied vol solver iterates to convergence and is timed , not counted)
+static const unsigned PRICE_TRANSCENDENTALS = 6;
+static const unsigned GREEKS_TRANSCENDENTALS = 7;
+// the snapshot overloads read sqrt(T) and both discounts from the expiry cache: log and two N(x) , plus the density's exp
+static const unsigned CACHED_PRICE_TRANSCENDENTALS = 3;
+static const unsigned CACHED_GREEKS_TRANSCENDENTALS = 4;
+
+// count of a request mask: the greeks count when any bit reads n(d1) , the price count otherwise
+static inline unsigned transcendentals(unsigned request , unsigned price , unsigned greeks){
+    return (request & (Valuation::GAMMA | Valuation::VEGA | Valuation::THETA | Valuation::SECOND_ORDER)) != 0 ? greeks : price;
+}
+
+// the simd kernel walks an array of MarketData in place with a stride of one MarketData
+static_assert(sizeof(MarketData) == 4 * sizeof(double), "MarketData must be four packed doubles");
+
+static BlackScholesSimd::Market shared_market(const MarketData& m){
+    return {&m.spot_, &m.rate_, &m.dividend_, &m.volatility_, 0, 0};
+}
+
+static BlackScholesSimd::Market surface_market(const MarketData& m , const double* vols){
+    return {&m.spot_, &m.rate_, &m.dividend_, vols, 0, 1};
+}
+
+// one vol column per thread , grows to the biggest batch priced on that thread and is then reused
+static double* vol_scratch(size_t n){
+    thread_local std::vector<double> buffer;
+    if (buffer.size() < n){
+        buffer.resize(n);
+    }
+    return buffer.data();
+}
+
+// per row market data with the zero rates to each row's expiry , the curves are read once per distinct expiry of the
+// whole batch (the expiry column sorted and deduplicated once) , a row finds its expiry by binary search unless it
+// repeats the previous row's , so an unsorted book reuses its lookups too
+static const MarketData* curve_rows(const OptionBatch& batch , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends){
+    thread_local std::vector<MarketData> buffer;
+    thread_local std::vector<double> expiries;
+    thread_local std::vector<double> zero_r;
+    thread_local std::vector<double> zero_q;
+    if (buffer.size() < batch.size()){
+        buffer.resize(batch.size() , marketdata);
+    }
+    // NaN expiries stay out of the sort , they go to the curves directly
+    expiries.clear();
+    for (size_t i = 0; i < batch.size(); ++i){
+        if (batch.expiry_[i] == batch.expiry_[i]){
+            expiries.push_back(batch.expiry_[i]);
+        }
+    }
+    std::sort(expiries.begin(), expiries.end());
+    expiries.erase(std::unique(expiries.begin(), expiries.end()), expiries.end());
+    zero_r.resize(expiries.size());
+    zero_q.resize(expiries.size());
+    for (size_t k = 0; k < expiries.size(); ++k){
+        zero_r[k] = rates.zero_rate(expiries[k]);
+        zero_q[k] = dividends.zero_rate(expiries[k]);
+    }
+
+    size_t k = 0;
+    for (size_t i = 0; i < batch.size(); ++i){
+        const double expiry = batch.expiry_[i];
+        MarketData& m = buffer[i];
+        m.spot_ = marketdata.spot_;
+        m.volatility_ = marketdata.volatility_;
+        if (expiry != expiry){
+            m.rate_ = rates.zero_rate(expiry);
+            m.dividend_ = dividends.zero_rate(expiry);
+            continue;
+        }
+        if (expiries[k] != expiry){
+            k = static_cast<size_t>(std::lower_bound(expiries.begin(), expiries.end(), expiry) - expiries.begin());
+        }
+        m.rate_ = zero_r[k];
+        m.dividend_ = zero_q[k];
+    }
+    return buffer.data();
+}
+
+static BlackScholesSimd::Market per_row_market(const MarketData* m){
+    return {&m->spot_, &m->rate_, &m->dividend_, &m->volatility_, sizeof(MarketData) / sizeof(double), sizeof(MarketData) / sizeof(double)};
+}
 
 
 double BlackScholes::calculate_d1(double S, double K, double T,double r, double q, double sigma) const {
@@ -10,7 +103,7 @@ double BlackScholes::calculate_d2(double d1 , double sigma , double T) const{
 }
 
 double BlackScholes::norm_cdf(double x) const {
-    return 0.5*(1.0 + std::erf(x/std::sqrt(2.0)));
+    return normal_cdf(x , accuracy_);
 }
 
 double BlackScholes::norm_pdf(double x) const {
@@ -19,73 +112,651 @@ double BlackScholes::norm_pdf(double x) const {
     return inv_sqrt_2pi*std::exp(-0.5*x*x);
 }
 
-double BlackScholes::price(const Option& option, const MarketData& marketdata) const
+// one instantiation per (type , dividend , accuracy) , see BlackScholesKernel.h
+template <unsigned Request, CdfAccuracy Accuracy>
+static inline Valuation dispatch_traits(double S, double K, double T, double r, double q, double sigma, Option::Type type)
+{
+    const bool call = type == Option::Type::CALL;
+    if (q == 0.0){
+        return call ? BlackScholesKernel<true, false, Request, Accuracy>::evaluate(S, K, T, r, q, sigma)
+                    : BlackScholesKernel<false, false, Request, Accuracy>::evaluate(S, K, T, r, q, sigma);
+    }
+    return call ? BlackScholesKernel<true, true, Request, Accuracy>::evaluate(S, K, T, r, q, sigma)
+                : BlackScholesKernel<false, true, Request, Accuracy>::evaluate(S, K, T, r, q, sigma);
+}
+
+template <unsigned Request>
+static inline Valuation dispatch_kernel(double S, double K, double T, double r, double q, double sigma, Option::Type type, CdfAccuracy accuracy)
+{
+    switch (accuracy){
+    case CdfAccuracy::RATIONAL: return dispatch_traits<Request, CdfAccuracy::RATIONAL>(S, K, T, r, q, sigma, type);
+    case CdfAccuracy::POLYNOMIAL: return dispatch_traits<Request, CdfAccuracy::POLYNOMIAL>(S, K, T, r, q, sigma, type);
+    case CdfAccuracy::TABLE: return dispatch_traits<Request, CdfAccuracy::TABLE>(S, K, T, r, q, sigma, type);
+    default: return dispatch_traits<Request, CdfAccuracy::EXACT>(S, K, T, r, q, sigma, type);
+    }
+}
+
+inline double BlackScholes::price_one(double S, double K, double T, double r, double q, double sigma, Option::Type type) const
+{
+    return dispatch_kernel<Valuation::PRICE>(S, K, T, r, q, sigma, type, accuracy_).price;
+}
+
+// rows of a shared market batch split by type once , each side then runs its own kernel with no per row branch
+// (the dividend trait is the same for every row and is picked once)
+static void split_by_type(const OptionBatch& batch , std::vector<size_t>& calls , std::vector<size_t>& puts)
 {
-    double S = marketdata.spot_;
-    double K = option.strike_;
-    double T = option.expiry_;
-    double sigma = marketdata.volatility_;
-    double r = marketdata.rate_;
-    double q = marketdata.dividend_;
+    calls.clear();
+    puts.clear();
+    for (size_t i = 0; i < batch.size(); ++i){
+        (batch.type_[i] == Option::Type::CALL ? calls : puts).push_back(i);
+    }
+}
 
-    double d1  = calculate_d1(S,K,T,r,q,sigma);
-    double d2 = calculate_d2(d1,sigma,T);
+template <bool Call, bool Dividend, unsigned Request, CdfAccuracy Accuracy, typename Out>
+static void run_side(const std::vector<size_t>& rows , const OptionBatch& batch , const MarketData& m , Out& out)
+{
+    for (size_t i : rows){
+        out(i, BlackScholesKernel<Call, Dividend, Request, Accuracy>::evaluate(m.spot_, batch.strike_[i], batch.expiry_[i],
+                                                                                m.rate_, m.dividend_, m.volatility_));
+    }
+}
 
-    if (option.type_ == Option::Type::CALL)
-    {
-        return S*std::exp(-q*T)*norm_cdf(d1) - K*std::exp(-r*T)*norm_cdf(d2);
+template <unsigned Request, CdfAccuracy Accuracy, typename Out>
+static void run_sides(const std::vector<size_t>& calls , const std::vector<size_t>& puts , const OptionBatch& batch , const MarketData& m , Out& out)
+{
+    if (m.dividend_ == 0.0){
+        run_side<true, false, Request, Accuracy>(calls, batch, m, out);
+        run_side<false, false, Request, Accuracy>(puts, batch, m, out);
     }
     else{
-        return K*std::exp(-r*T)*norm_cdf(-d2) - S*std::exp(-q*T)*norm_cdf(-d1);
+        run_side<true, true, Request, Accuracy>(calls, batch, m, out);
+        run_side<false, true, Request, Accuracy>(puts, batch, m, out);
+    }
+}
+
+template <unsigned Request, typename Out>
+static void run_partitioned(const OptionBatch& batch , const MarketData& m , CdfAccuracy accuracy , Out out)
+{
+    thread_local std::vector<size_t> calls;
+    thread_local std::vector<size_t> puts;
+    split_by_type(batch, calls, puts);
+    switch (accuracy){
+    case CdfAccuracy::RATIONAL: run_sides<Request, CdfAccuracy::RATIONAL>(calls, puts, batch, m, out); return;
+    case CdfAccuracy::POLYNOMIAL: run_sides<Request, CdfAccuracy::POLYNOMIAL>(calls, puts, batch, m, out); return;
+    case CdfAccuracy::TABLE: run_sides<Request, CdfAccuracy::TABLE>(calls, puts, batch, m, out); return;
+    default: run_sides<Request, CdfAccuracy::EXACT>(calls, puts, batch, m, out); return;
+    }
+}
+
+static const unsigned NEED_EXP_RT = Valuation::PRICE | Valuation::THETA | Valuation::RHO;
+
+// BlackScholesKernel on cached per expiry terms , one instantiation per (type , dividend , accuracy) like dispatch_traits
+template <unsigned Request, CdfAccuracy Accuracy>
+static inline Valuation dispatch_terms_traits(double S, double K, double r, double q, double sigma, const ExpiryTerms& t, Option::Type type)
+{
+    const bool call = type == Option::Type::CALL;
+    if (q == 0.0){
+        return call ? BlackScholesKernel<true, false, Request, Accuracy>::evaluate(S, K, r, q, sigma, t.expiry, t.sqrt_t, t.sigma_sqrt_t, t.dividend_discount, t.discount)
+                    : BlackScholesKernel<false, false, Request, Accuracy>::evaluate(S, K, r, q, sigma, t.expiry, t.sqrt_t, t.sigma_sqrt_t, t.dividend_discount, t.discount);
+    }
+    return call ? BlackScholesKernel<true, true, Request, Accuracy>::evaluate(S, K, r, q, sigma, t.expiry, t.sqrt_t, t.sigma_sqrt_t, t.dividend_discount, t.discount)
+                : BlackScholesKernel<false, true, Request, Accuracy>::evaluate(S, K, r, q, sigma, t.expiry, t.sqrt_t, t.sigma_sqrt_t, t.dividend_discount, t.discount);
+}
+
+template <unsigned Request>
+static inline Valuation dispatch_terms(double S, double K, double r, double q, double sigma, const ExpiryTerms& t, Option::Type type, CdfAccuracy accuracy)
+{
+    switch (accuracy){
+    case CdfAccuracy::RATIONAL: return dispatch_terms_traits<Request, CdfAccuracy::RATIONAL>(S, K, r, q, sigma, t, type);
+    case CdfAccuracy::POLYNOMIAL: return dispatch_terms_traits<Request, CdfAccuracy::POLYNOMIAL>(S, K, r, q, sigma, t, type);
+    case CdfAccuracy::TABLE: return dispatch_terms_traits<Request, CdfAccuracy::TABLE>(S, K, r, q, sigma, t, type);
+    default: return dispatch_terms_traits<Request, CdfAccuracy::EXACT>(S, K, r, q, sigma, t, type);
+    }
+}
+
+// what a runtime request did not ask for is left at 0 , as if the kernel had been instantiated for exactly that mask
+static inline Valuation masked(Valuation v, unsigned request)
+{
+    if (!(request & Valuation::PRICE)) v.price = 0.0;
+    if (!(request & Valuation::DELTA)) v.greeks.delta = 0.0;
+    if (!(request & Valuation::GAMMA)) v.greeks.gamma = 0.0;
+    if (!(request & Valuation::VEGA)) v.greeks.vega = 0.0;
+    if (!(request & Valuation::THETA)) v.greeks.theta = 0.0;
+    if (!(request & Valuation::RHO)) v.greeks.rho = 0.0;
+    if (!(request & Valuation::VANNA)) v.vanna = 0.0;
+    if (!(request & Valuation::VOLGA)) v.volga = 0.0;
+    if (!(request & Valuation::CHARM)) v.charm = 0.0;
+    return v;
+}
+
+inline Valuation BlackScholes::evaluate_one(double S, double K, double T, double r, double q, double sigma, Option::Type type, unsigned request) const
+{
+    ExpiryTerms t;
+    t.expiry = T;
+    t.sqrt_t = std::sqrt(T);
+    t.sigma_sqrt_t = sigma * t.sqrt_t;
+    t.dividend_discount = q != 0.0 ? std::exp(-q * T) : 1.0;
+    t.discount = (request & NEED_EXP_RT) ? std::exp(-r * T) : 0.0;
+    t.forward = 0.0;
+    return evaluate_terms(S, K, r, q, sigma, t, type, request);
+}
+
+/*
+ * The runtime request mask runs the smallest of four kernel instantiations that covers it (price , greeks,
+ * price and greeks , everything) , t.discount only has to be set when the request needs e^-rT , t.forward is not read
+ */
+inline Valuation BlackScholes::evaluate_terms(double S, double K, double r, double q, double sigma, const ExpiryTerms& t, Option::Type type, unsigned request) const
+{
+    const unsigned first_order = Valuation::PRICE | Valuation::GREEKS;
+    if (request == Valuation::PRICE){
+        return dispatch_terms<Valuation::PRICE>(S, K, r, q, sigma, t, type, accuracy_);
+    }
+    if (request == Valuation::GREEKS){
+        return dispatch_terms<Valuation::GREEKS>(S, K, r, q, sigma, t, type, accuracy_);
+    }
+    if (request & ~first_order){
+        return masked(dispatch_terms<Valuation::ALL>(S, K, r, q, sigma, t, type, accuracy_), request);
+    }
+    if (request & Valuation::PRICE){
+        return masked(dispatch_terms<first_order>(S, K, r, q, sigma, t, type, accuracy_), request);
+    }
+    return masked(dispatch_terms<Valuation::GREEKS>(S, K, r, q, sigma, t, type, accuracy_), request);
+}
+
+/*
+ * Implied volatility in normalised Black coordinates: x = ln(F/K) , beta = price / (e^-rT sqrt(F K)) , s = sigma sqrt(T)
+ * - in the money quotes are turned into the out of the money one by parity , then b(x , s) is the call with x <= 0
+ *   b(x , s) = e^(x/2) N(x/s + s/2) - e^(-x/2) N(x/s - s/2) , rising from 0 to e^(x/2) , inflection at s_c = sqrt(-2x)
+ * - initial guess by where beta sits against b_c = b(x , s_c):
+ *   far below , the leading asymptotics b ~ s^3/x^2 phi(x/s) solved by fixed point ,
+ *   around b_c , the tangent at the inflection (b is nearly linear there) ,
+ *   far above , the large s asymptote b ~ e^(x/2) - (e^(x/2) + e^(-x/2)) N(-s/2)
+ * - then third order Householder steps using vega b' , b'' = b' h , b''' = b' (h^2 + h') with h = x^2/s^3 - s/4 ,
+ *   on ln b - ln beta below b_c (b falls off like exp(-x^2/2s^2) there) and on b - beta above it
+ * - a bracket [lo , hi] on s catches any step that overshoots , typically 2 iterations to full precision
+ */
+static const int IV_MAX_ITERATIONS = 16;
+static const double IV_LOW_REGION = 0.1;     // beta < 0.1 b_c
+static const double IV_HIGH_REGION = 0.7;    // beta > b_c + 0.7 (e^(x/2) - b_c)
+
+static double tail_cdf(double x){
+    return 0.5 * std::erfc(-x * 0.70710678118654752440);
+}
+
+static double normalised_implied_vol(double x , double beta){
+    const double ex = std::exp(0.5 * x);
+    const double emx = 1.0 / ex;
+
+    const double log_beta = std::log(beta);
+
+    double s = -2.0 * inverse_normal_cdf((ex - beta) / (ex + emx));
+    bool logarithmic = false;
+    if (x < 0.0){
+        const double sc = std::sqrt(-2.0 * x);
+        // at the inflection d1 = 0 and d2 = -s_c
+        const double bc = 0.5 * ex - emx * tail_cdf(-sc);
+        logarithmic = beta < bc;
+        if (beta < IV_LOW_REGION * bc){
+            s = -x / std::sqrt(-2.0 * log_beta);
+            for (int k = 0; k < 2; ++k){
+                double arg = 2.0 * (std::log(s * s * s / (x * x)) - 0.91893853320467274 - log_beta);
+                if (arg > 0.0){
+                    s = -x / std::sqrt(arg);
+                }
+            }
+        }
+        else if (beta < bc + IV_HIGH_REGION * (ex - bc)){
+            s = std::max(sc + (beta - bc) / (0.3989422804014327 * ex) , 0.1 * sc);
+        }
     }
+
+    double lo = 0.0;
+    double hi = std::numeric_limits<double>::infinity();
+    for (int it = 0; it < IV_MAX_ITERATIONS; ++it){
+        const double inv_s = 1.0 / s;
+        const double xs = x * inv_s;
+        const double d1 = xs + 0.5 * s;
+        const double b = ex * tail_cdf(d1) - emx * tail_cdf(d1 - s);
+        const double vega = 0.3989422804014327 * std::exp(0.5 * x - 0.5 * d1 * d1);
+        const double h = xs * xs * inv_s - 0.25 * s;
+        const double dh = -3.0 * xs * xs * inv_s * inv_s - 0.25;
+
+        double f , df , a , c;
+        if (!logarithmic){
+            f = b - beta;
+            df = vega;
+            a = h;
+            c = h * h + dh;
+        }
+        else{
+            f = std::log(b) - log_beta;
+            df = vega / b;
+            a = h - df;
+            c = a * a + dh - df * a;
+        }
+        if (f < 0.0){
+            lo = s;
+        }
+        else{
+            hi = s;
+        }
+
+        const double r = -f / df;
+        const double step = r * (1.0 + 0.5 * a * r) / (1.0 + a * r + c * r * r * (1.0 / 6.0));
+        double next = s + step;
+        // cubic convergence: once a step is this small the error left after it is below double precision
+        if (std::abs(step) <= 1e-3 * s){
+            return next;
+        }
+        if (!(next > lo && next < hi)){
+            next = hi < std::numeric_limits<double>::infinity() ? 0.5 * (lo + hi) : 2.0 * s;
+        }
+        s = next;
+    }
+    return s;
+}
+
+inline double BlackScholes::implied_vol_one(double S, double K, double T, double r, double q, double price, Option::Type type) const
+{
+    if (!(T > 0.0)){
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const double forward = S * std::exp((r - q) * T);
+    const double x = std::log(forward / K);
+    const double w = type == Option::Type::CALL ? 1.0 : -1.0;
+    const double ex = std::exp(0.5 * x);
+    double beta = price / (std::exp(-r * T) * std::sqrt(forward * K));
+
+    // out of the money by parity: b(x , s , w) - intrinsic = b(-|x| , s , call)
+    beta -= std::max(w * (ex - 1.0 / ex) , 0.0);
+    const double otm = -std::abs(x);
+    if (beta == 0.0){
+        return 0.0;
+    }
+    if (!(beta > 0.0 && beta < std::exp(0.5 * otm))){
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return normalised_implied_vol(otm , beta) / std::sqrt(T);
+}
+
+inline Greeks BlackScholes::greeks_one(double S, double K, double T, double r, double q, double sigma, Option::Type type) const
+{
+    return dispatch_kernel<Valuation::GREEKS>(S, K, T, r, q, sigma, type, accuracy_).greeks;
+}
+
+double BlackScholes::price(const Option& option, const MarketData& marketdata) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , PRICE_TRANSCENDENTALS);
+    return price_one(marketdata.spot_, option.strike_, option.expiry_, marketdata.rate_,
+                     marketdata.dividend_, marketdata.volatility_, option.type_);
 }
 
 Greeks BlackScholes::greeks(const Option& option, const MarketData& marketdata) const {
-    double S = marketdata.spot_;
-    double K = option.strike_;
-    double T = option.expiry_;
-    double sigma = marketdata.volatility_;
-    double r = marketdata.rate_;
-    double q = marketdata.dividend_;
-
-    double d1  = calculate_d1(S,K,T,r,q,sigma);
-    double d2 = calculate_d2(d1,sigma,T);
-    double Nd1 = norm_cdf(d1);
-    double Nd2 = norm_cdf(d2);
-    double npd1 = norm_pdf(d1);
-    double sqrt_T = std::sqrt(T);
-    double exp_qT = std::exp(-q * T);
-    double exp_rT = std::exp(-r * T);
-    Greeks g;
-
-    if (option.type_ == Option::Type::CALL)
-    {
-        g.delta = exp_qT * Nd1;
-        g.gamma = exp_qT * npd1 / (S * sigma * sqrt_T);
-        g.vega = S * exp_qT * npd1 * sqrt_T / 100.0;
-        
-        double theta_annual = -S * npd1 * sigma * exp_qT / (2.0 * sqrt_T)
-                              - r * K * exp_rT * Nd2
-                              + q * S * exp_qT * Nd1;
-        g.theta = theta_annual / 365.0;
-        
-        g.rho = K * T * exp_rT * Nd2 / 100.0;
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , GREEKS_TRANSCENDENTALS);
+    return greeks_one(marketdata.spot_, option.strike_, option.expiry_, marketdata.rate_,
+                      marketdata.dividend_, marketdata.volatility_, option.type_);
+}
+
+Valuation BlackScholes::evaluate(const Option& option, const MarketData& marketdata, unsigned request) const {
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , transcendentals(request , PRICE_TRANSCENDENTALS , GREEKS_TRANSCENDENTALS));
+    return evaluate_one(marketdata.spot_, option.strike_, option.expiry_, marketdata.rate_,
+                        marketdata.dividend_, marketdata.volatility_, option.type_, request);
+}
+
+// about twenty nodes , recorded after a mark and rewound so a caller's own recording is left alone
+Sensitivities BlackScholes::sensitivities(const Option& option, const MarketData& marketdata) const {
+    AadTape& tape = AadTape::local();
+    const AadTape::Mark start = tape.mark();
+    const AadReal S = AadReal::input(marketdata.spot_);
+    const AadReal sigma = AadReal::input(marketdata.volatility_);
+    const AadReal r = AadReal::input(marketdata.rate_);
+    const AadReal q = AadReal::input(marketdata.dividend_);
+    const AadReal T = AadReal::input(option.expiry_);
+    const double K = option.strike_;
+
+    const AadReal vol = sigma * sqrt(T);
+    const AadReal forward = S * exp(-q * T);
+    const AadReal discount = K * exp(-r * T);
+    AadReal value;
+    if (K > 0.0){
+        const AadReal d1 = (log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / vol;
+        const AadReal d2 = d1 - vol;
+        value = option.type_ == Option::Type::CALL ? forward * normal_cdf(d1) - discount * normal_cdf(d2)
+                                                   : discount * normal_cdf(-d2) - forward * normal_cdf(-d1);
     }
-    else{
-        double N_minus_d1 = norm_cdf(-d1);
-        double N_minus_d2 = norm_cdf(-d2);
-        
-        g.delta = exp_qT * (Nd1 - 1.0);
-        g.gamma = exp_qT * npd1 / (S * sigma * sqrt_T);
-        g.vega = S * exp_qT * npd1 * sqrt_T / 100.0;
-        
-        double theta_annual = -S * npd1 * sigma * exp_qT / (2.0 * sqrt_T)
-                              + r * K * exp_rT * N_minus_d2
-                              - q * S * exp_qT * N_minus_d1;
-        g.theta = theta_annual / 365.0;
-        
-        g.rho = -K * T * exp_rT * N_minus_d2 / 100.0;
-    }
-
-    return g;
-}
\ No newline at end of file
+    else if (option.type_ == Option::Type::CALL){
+        value = forward;
+    }
+    value.seed();
+    tape.propagate(tape.mark() , start);
+
+    Sensitivities out;
+    out.price = value.value();
+    out.spot = S.adjoint();
+    out.volatility = sigma.adjoint();
+    out.rate = r.adjoint();
+    out.dividend = q.adjoint();
+    out.expiry = T.adjoint();
+    tape.rewind(start);
+    return out;
+}
+
+// batch pricing: market inputs are loaded once, the loop only touches the book columns
+
+void BlackScholes::price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * PRICE_TRANSCENDENTALS);
+    if (kernel_ == Kernel::SIMD){
+        BlackScholesSimd::price(batch, shared_market(marketdata), out, BlackScholesSimd::detect(), accuracy_);
+        return;
+    }
+
+    run_partitioned<Valuation::PRICE>(batch, marketdata, accuracy_, [out](size_t i, const Valuation& v){out[i] = v.price;});
+}
+
+void BlackScholes::price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * PRICE_TRANSCENDENTALS);
+    if (kernel_ == Kernel::SIMD){
+        BlackScholesSimd::price(batch, per_row_market(marketdata), out, BlackScholesSimd::detect(), accuracy_);
+        return;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i){
+        const MarketData& m = marketdata[i];
+        out[i] = price_one(m.spot_, batch.strike_[i], batch.expiry_[i], m.rate_, m.dividend_, m.volatility_, batch.type_[i]);
+    }
+}
+
+void BlackScholes::greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * GREEKS_TRANSCENDENTALS);
+    if (kernel_ == Kernel::SIMD){
+        BlackScholesSimd::greeks(batch, shared_market(marketdata), out, BlackScholesSimd::detect(), accuracy_);
+        return;
+    }
+
+    run_partitioned<Valuation::GREEKS>(batch, marketdata, accuracy_, [&out](size_t i, const Valuation& v){store(v.greeks, out, i);});
+}
+
+void BlackScholes::greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * GREEKS_TRANSCENDENTALS);
+    if (kernel_ == Kernel::SIMD){
+        BlackScholesSimd::greeks(batch, per_row_market(marketdata), out, BlackScholesSimd::detect(), accuracy_);
+        return;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i){
+        const MarketData& m = marketdata[i];
+        store(greeks_one(m.spot_, batch.strike_[i], batch.expiry_[i], m.rate_, m.dividend_, m.volatility_, batch.type_[i]), out, i);
+    }
+}
+
+// implied vols: the scalar kernel iterates each quote to its own tolerance ,
+// the simd kernel iterates a whole register until every lane has converged
+// - a batch of more than one chunk is split over ThreadPool::global() , each task runs the selected kernel on its
+//   slice of the columns , quotes are independent so the result does not depend on the split
+// - a chunk of 512 quotes is ~100 us of scalar work , enough to pay for the dispatch
+
+static const size_t IMPLIED_VOL_CHUNK = 512;
+
+template <class Rows>
+static void run_chunked(size_t n , const Rows& rows){
+    ThreadPool& pool = ThreadPool::global();
+    const size_t chunks = (n + IMPLIED_VOL_CHUNK - 1) / IMPLIED_VOL_CHUNK;
+    if (chunks < 2 || pool.size() < 2){
+        rows(0, n);
+        return;
+    }
+    pool.parallel_for(chunks, [&rows, n](size_t c){
+        const size_t begin = c * IMPLIED_VOL_CHUNK;
+        rows(begin, std::min(n, begin + IMPLIED_VOL_CHUNK));
+    });
+}
+
+double BlackScholes::implied_vol(const Option& option , const MarketData& marketdata , double price) const
+{
+    PRICING_TIME(BLACK_SCHOLES , IMPLIED_VOL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    return implied_vol_one(marketdata.spot_, option.strike_, option.expiry_, marketdata.rate_,
+                           marketdata.dividend_, price, option.type_);
+}
+
+void BlackScholes::implied_vol_batch(const OptionBatch& batch , const MarketData& marketdata , const double* prices , double* out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , IMPLIED_VOL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    const double S = marketdata.spot_;
+    const double r = marketdata.rate_;
+    const double q = marketdata.dividend_;
+
+    run_chunked(batch.size(), [&](size_t begin , size_t end){
+        if (kernel_ == Kernel::SIMD){
+            BlackScholesSimd::implied_vol(batch.slice(begin, end), shared_market(marketdata), prices + begin, out + begin);
+            return;
+        }
+        for (size_t i = begin; i < end; ++i){
+            out[i] = implied_vol_one(S, batch.strike_[i], batch.expiry_[i], r, q, prices[i], batch.type_[i]);
+        }
+    });
+}
+
+void BlackScholes::implied_vol_batch(const OptionBatch& batch , const MarketData* marketdata , const double* prices , double* out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , IMPLIED_VOL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    run_chunked(batch.size(), [&](size_t begin , size_t end){
+        if (kernel_ == Kernel::SIMD){
+            BlackScholesSimd::implied_vol(batch.slice(begin, end), per_row_market(marketdata + begin), prices + begin, out + begin);
+            return;
+        }
+        for (size_t i = begin; i < end; ++i){
+            const MarketData& m = marketdata[i];
+            out[i] = implied_vol_one(m.spot_, batch.strike_[i], batch.expiry_[i], m.rate_, m.dividend_, prices[i], batch.type_[i]);
+        }
+    });
+}
+
+// snapshot pricing: sqrt(T) , sigma sqrt(T) and both discount factors come from the underlying's cached expiry terms,
+// the batch loops only look an expiry up again when it differs from the previous row's
+
+double BlackScholes::price(const Option& option , MarketSnapshot::Underlying& underlying) const
+{
+    return evaluate(option, underlying, Valuation::PRICE).price;
+}
+
+Valuation BlackScholes::evaluate(const Option& option , MarketSnapshot::Underlying& underlying , unsigned request) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , transcendentals(request , CACHED_PRICE_TRANSCENDENTALS , CACHED_GREEKS_TRANSCENDENTALS));
+    const MarketData& m = underlying.market();
+    return evaluate_terms(m.spot_, option.strike_, m.rate_, m.dividend_, m.volatility_,
+                          underlying.terms(option.expiry_), option.type_, request);
+}
+
+void BlackScholes::price_batch(const OptionBatch& batch , MarketSnapshot::Underlying& underlying , double* out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * CACHED_PRICE_TRANSCENDENTALS);
+    const MarketData& m = underlying.market();
+    const ExpiryTerms* t = nullptr;
+    for (size_t i = 0; i < batch.size(); ++i){
+        if (!t || t->expiry != batch.expiry_[i]){
+            t = &underlying.terms(batch.expiry_[i]);
+        }
+        out[i] = evaluate_terms(m.spot_, batch.strike_[i], m.rate_, m.dividend_, m.volatility_, *t, batch.type_[i], Valuation::PRICE).price;
+    }
+}
+
+void BlackScholes::greeks_batch(const OptionBatch& batch , MarketSnapshot::Underlying& underlying , const GreeksBatch& out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * CACHED_GREEKS_TRANSCENDENTALS);
+    const MarketData& m = underlying.market();
+    const ExpiryTerms* t = nullptr;
+    for (size_t i = 0; i < batch.size(); ++i){
+        if (!t || t->expiry != batch.expiry_[i]){
+            t = &underlying.terms(batch.expiry_[i]);
+        }
+        store(evaluate_terms(m.spot_, batch.strike_[i], m.rate_, m.dividend_, m.volatility_, *t, batch.type_[i], Valuation::GREEKS).greeks, out, i);
+    }
+}
+
+// surface pricing
+
+double BlackScholes::price(const Option& option , const MarketData& marketdata , const VolSurface& surface) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , PRICE_TRANSCENDENTALS);
+    return price_one(marketdata.spot_, option.strike_, option.expiry_, marketdata.rate_, marketdata.dividend_,
+                     surface.volatility(option.strike_, option.expiry_), option.type_);
+}
+
+Greeks BlackScholes::greeks(const Option& option , const MarketData& marketdata , const VolSurface& surface) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , GREEKS_TRANSCENDENTALS);
+    return greeks_one(marketdata.spot_, option.strike_, option.expiry_, marketdata.rate_, marketdata.dividend_,
+                      surface.volatility(option.strike_, option.expiry_), option.type_);
+}
+
+void BlackScholes::price_batch(const OptionBatch& batch , const MarketData& marketdata , const VolSurface& surface , double* out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * PRICE_TRANSCENDENTALS);
+    double* vols = vol_scratch(batch.size());
+    surface.volatility_batch(batch, vols);
+    if (kernel_ == Kernel::SIMD){
+        BlackScholesSimd::price(batch, surface_market(marketdata, vols), out, BlackScholesSimd::detect(), accuracy_);
+        return;
+    }
+
+    const double S = marketdata.spot_;
+    const double r = marketdata.rate_;
+    const double q = marketdata.dividend_;
+    for (size_t i = 0; i < batch.size(); ++i){
+        out[i] = price_one(S, batch.strike_[i], batch.expiry_[i], r, q, vols[i], batch.type_[i]);
+    }
+}
+
+void BlackScholes::greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const VolSurface& surface , const GreeksBatch& out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , batch.size());
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , batch.size() * GREEKS_TRANSCENDENTALS);
+    double* vols = vol_scratch(batch.size());
+    surface.volatility_batch(batch, vols);
+    if (kernel_ == Kernel::SIMD){
+        BlackScholesSimd::greeks(batch, surface_market(marketdata, vols), out, BlackScholesSimd::detect(), accuracy_);
+        return;
+    }
+
+    const double S = marketdata.spot_;
+    const double r = marketdata.rate_;
+    const double q = marketdata.dividend_;
+    for (size_t i = 0; i < batch.size(); ++i){
+        store(greeks_one(S, batch.strike_[i], batch.expiry_[i], r, q, vols[i], batch.type_[i]), out, i);
+    }
+}
+
+// curve pricing
+
+double BlackScholes::price(const Option& option , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , PRICE_TRANSCENDENTALS);
+    return price_one(marketdata.spot_, option.strike_, option.expiry_, rates.zero_rate(option.expiry_),
+                     dividends.zero_rate(option.expiry_), marketdata.volatility_, option.type_);
+}
+
+Greeks BlackScholes::greeks(const Option& option , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    PRICING_COUNT(BLACK_SCHOLES , OPTIONS , 1);
+    PRICING_COUNT(BLACK_SCHOLES , TRANSCENDENTALS , GREEKS_TRANSCENDENTALS);
+    return greeks_one(marketdata.spot_, option.strike_, option.expiry_, rates.zero_rate(option.expiry_),
+                      dividends.zero_rate(option.expiry_), marketdata.volatility_, option.type_);
+}
+
+// the per row batch underneath counts the options , this scope's time also covers the curve lookups (curve_rows)
+void BlackScholes::price_batch(const OptionBatch& batch , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends , double* out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    price_batch(batch, curve_rows(batch, marketdata, rates, dividends), out);
+}
+
+void BlackScholes::greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends , const GreeksBatch& out) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    greeks_batch(batch, curve_rows(batch, marketdata, rates, dividends), out);
+}
+
+void BlackScholes::rho_ladder(const OptionBatch& batch , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends ,
+                              double* out , double shift) const
+{
+    PRICING_TIME(BLACK_SCHOLES , CALL);
+    if (!(shift != 0.0) || !std::isfinite(shift)){
+        throw std::invalid_argument("rho ladder shift must be non zero and finite");
+    }
+    const size_t n = batch.size();
+    std::vector<double> base(n);
+    price_batch(batch, marketdata, rates, dividends, base.data());
+
+    // rows past each bucket's start are gathered into their own columns and repriced against the bumped curve
+    std::vector<double> K , T , bumped;
+    std::vector<Option::Type> type;
+    std::vector<size_t> rows;
+    K.reserve(n);
+    T.reserve(n);
+    type.reserve(n);
+    rows.reserve(n);
+    bumped.resize(n);
+
+    for (size_t j = 0; j < rates.buckets(); ++j){
+        double* ladder = out + j * n;
+        const double start = rates.bucket_start(j);
+        K.clear();
+        T.clear();
+        type.clear();
+        rows.clear();
+        for (size_t i = 0; i < n; ++i){
+            ladder[i] = 0.0;
+            if (batch.expiry_[i] > start){
+                K.push_back(batch.strike_[i]);
+                T.push_back(batch.expiry_[i]);
+                type.push_back(batch.type_[i]);
+                rows.push_back(i);
+            }
+        }
+        if (rows.empty()){
+            continue;
+        }
+        OptionBatch affected(K.data(), T.data(), type.data(), rows.size());
+        price_batch(affected, marketdata, rates.bumped(j, shift), dividends, bumped.data());
+        for (size_t k = 0; k < rows.size(); ++k){
+            ladder[rows[k]] = (bumped[k] - base[rows[k]]) / shift / 100.0;
+        }
+    }
+}
@@ -1,16 +1,87 @@
 #pragma once
 
 # include "PricingMain.h"
+# include "MarketSnapshot.h"
+# include "VolSurface.h"
+# include "RateCurve.h"
+# include "NormalCdf.h"
 
 class BlackScholes : public PricingModel{
 public:
+    // batch kernel: SCALAR runs price_one/greeks_one per row , SIMD runs the vectorized kernel in BlackScholesSimd.cpp
+    enum class Kernel {SCALAR , SIMD};
+
+    // accuracy picks the N(x) tier of NormalCdf.h for every price and greek this engine computes
+    // (implied vol always inverts with the exact N)
     BlackScholes() = default;
+    explicit BlackScholes(Kernel kernel , CdfAccuracy accuracy = CdfAccuracy::EXACT) : kernel_(kernel) , accuracy_(accuracy){}
+
+    Kernel kernel() const {return kernel_;}
+    CdfAccuracy accuracy() const {return accuracy_;}
     double price(const Option& option, const MarketData& marketdata) const override;
     Greeks greeks(const Option& option, const MarketData& marketdata) const override;
+
+    // one pass: d1/d2 , sqrt(T) , both discount factors and N(d1)/N(d2) are computed once and shared,
+    // anything the request mask does not need is skipped
+    Valuation evaluate(const Option& option , const MarketData& marketdata , unsigned request = Valuation::PRICE | Valuation::GREEKS) const override;
+
+    // the closed form taped once (Aad.h) , all five first order sensitivities from one adjoint sweep , always the exact N
+    Sensitivities sensitivities(const Option& option , const MarketData& marketdata) const override;
+
+    // batch versions run the same formulas as price/greeks over the book columns with no virtual call per row
+    void price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const override;
+    void price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const override;
+
+    // implied volatility that reproduces `price` , marketdata.volatility_ is ignored
+    // NaN when no volatility does (price outside the no arbitrage bounds , expiry <= 0) , 0 for a price at intrinsic
+    double implied_vol(const Option& option , const MarketData& marketdata , double price) const;
+    // batches bigger than one chunk of quotes are split over ThreadPool::global() , each chunk runs the selected kernel
+    void implied_vol_batch(const OptionBatch& batch , const MarketData& marketdata , const double* prices , double* out) const;
+    void implied_vol_batch(const OptionBatch& batch , const MarketData* marketdata , const double* prices , double* out) const;
+
+    // against a snapshot entry , the per expiry work (sqrt(T) , sigma sqrt(T) , discount factors) is read from its cache
+    // runs the scalar formulas whatever the kernel
+    double price(const Option& option , MarketSnapshot::Underlying& underlying) const;
+    Valuation evaluate(const Option& option , MarketSnapshot::Underlying& underlying , unsigned request = Valuation::PRICE | Valuation::GREEKS) const;
+    void price_batch(const OptionBatch& batch , MarketSnapshot::Underlying& underlying , double* out) const;
+    void greeks_batch(const OptionBatch& batch , MarketSnapshot::Underlying& underlying , const GreeksBatch& out) const;
+
+    // vol of each contract read off a surface at (strike , expiry) , marketdata.volatility_ is ignored
+    // the batch versions fill one vol column and run the selected kernel over it
+    double price(const Option& option , const MarketData& marketdata , const VolSurface& surface) const;
+    Greeks greeks(const Option& option , const MarketData& marketdata , const VolSurface& surface) const;
+    void price_batch(const OptionBatch& batch , const MarketData& marketdata , const VolSurface& surface , double* out) const;
+    void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const VolSurface& surface , const GreeksBatch& out) const;
+
+    // rate and dividend yield off curves: each contract uses the zero rates to its expiry , marketdata.rate_ and dividend_ are ignored
+    // the batch versions look the curves up once per distinct expiry of the batch , in any row order , and then run the
+    // per row kernel (which still takes its own e^-rT and e^-qT of the looked up zero rates)
+    double price(const Option& option , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends) const;
+    Greeks greeks(const Option& option , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends) const;
+    void price_batch(const OptionBatch& batch , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends , double* out) const;
+    void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends , const GreeksBatch& out) const;
+
+    // bucketed rho: out[j * batch.size() + i] is the change in the price of row i per 1% on the forward of rate bucket j,
+    // by bumping that bucket by `shift` , only the rows expiring after the bucket starts are repriced
+    void rho_ladder(const OptionBatch& batch , const MarketData& marketdata , const RateCurve& rates , const RateCurve& dividends ,
+                    double* out , double shift = 1e-4) const;
+
 private:
+    Kernel kernel_ = Kernel::SCALAR;
+    CdfAccuracy accuracy_ = CdfAccuracy::EXACT;
+
     double calculate_d1(double S, double K, double T,double r, double q, double sigma) const;
     double calculate_d2(double d1 , double sigma , double T) const;
     double norm_cdf(double x) const;
     double norm_pdf(double x) const;
 
-};
\ No newline at end of file
+    // single contract kernels shared by the scalar and batch paths
+    double price_one(double S, double K, double T, double r, double q, double sigma, Option::Type type) const;
+    Greeks greeks_one(double S, double K, double T, double r, double q, double sigma, Option::Type type) const;
+    Valuation evaluate_one(double S, double K, double T, double r, double q, double sigma, Option::Type type, unsigned request) const;
+    Valuation evaluate_terms(double S, double K, double r, double q, double sigma, const ExpiryTerms& terms, Option::Type type, unsigned request) const;
+    double implied_vol_one(double S, double K, double T, double r, double q, double price, Option::Type type) const;
+
+};
@@ -0,0 +1,391 @@
+#include "BookFile.h"
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BOOK_FILE_MMAP 1
+#else
+#define BOOK_FILE_MMAP 0
+#endif
+
+static_assert(std::is_trivially_copyable<MarketData>::value && sizeof(MarketData) == 4 * sizeof(double) ,
+              "MarketData columns are mapped as 4 doubles per row");
+static_assert(std::is_trivially_copyable<Option::Type>::value , "type columns are mapped as Option::Type");
+
+namespace {
+
+const char MAGIC[8] = {'D' , 'P' , 'L' , 'B' , 'O' , 'O' , 'K' , '\0'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const size_t ALIGN = 64;
+const size_t COLUMNS = static_cast<size_t>(BookColumn::COUNT);
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t rows;
+    uint32_t columns;
+    uint32_t reserved[9];
+};
+
+struct ColumnEntry {
+    uint32_t id;
+    uint32_t width;
+    uint64_t rows;
+    uint64_t offset;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 64 && sizeof(ColumnEntry) == 32 , "on disk header layout");
+
+size_t align_up(size_t n){return (n + ALIGN - 1) / ALIGN * ALIGN;}
+
+uint32_t column_width(BookColumn column){
+    switch (column){
+        case BookColumn::TYPE: return sizeof(Option::Type);
+        case BookColumn::MARKET: return sizeof(MarketData);
+        default: return sizeof(double);
+    }
+}
+
+// header , then the column table , then each column on its own 64 byte boundary
+struct Layout {
+    FileHeader header;
+    std::vector<ColumnEntry> entries;
+    size_t bytes;
+
+    Layout(size_t rows) : bytes(0){
+        std::memset(&header , 0 , sizeof(header));
+        std::memcpy(header.magic , MAGIC , sizeof(MAGIC));
+        header.version = BOOK_FILE_VERSION;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.rows = rows;
+    }
+
+    void add(BookColumn column , size_t rows){
+        entries.push_back(ColumnEntry{static_cast<uint32_t>(column) , column_width(column) , rows , 0 , 0});
+    }
+
+    void finish(){
+        header.columns = static_cast<uint32_t>(entries.size());
+        size_t at = align_up(sizeof(FileHeader) + entries.size() * sizeof(ColumnEntry));
+        for (ColumnEntry& e : entries){
+            e.offset = at;
+            at = align_up(at + e.rows * e.width);
+        }
+        bytes = at;
+    }
+
+    // header and table into the first bytes of a buffer
+    void store(char* out) const {
+        std::memcpy(out , &header , sizeof(header));
+        std::memcpy(out + sizeof(header) , entries.data() , entries.size() * sizeof(ColumnEntry));
+    }
+};
+
+[[noreturn]] void fail(const std::string& path , const char* what){
+    throw std::runtime_error("book file " + path + ": " + what);
+}
+
+#if !BOOK_FILE_MMAP
+char* aligned_buffer(size_t bytes){
+    return static_cast<char*>(::operator new(bytes , std::align_val_t(ALIGN)));
+}
+#endif
+
+void free_buffer(const char* p){
+    ::operator delete(const_cast<char*>(p) , std::align_val_t(ALIGN));
+}
+
+} // namespace
+
+void write_book(const std::string& path , const OptionBatch& batch , const MarketData* markets , size_t market_rows){
+    if (markets != nullptr && market_rows != 1 && market_rows != batch.size()){
+        throw std::invalid_argument("write_book needs 1 market row or one per contract");
+    }
+    const size_t n = batch.size();
+    Layout layout(n);
+    layout.add(BookColumn::STRIKE , n);
+    layout.add(BookColumn::EXPIRY , n);
+    layout.add(BookColumn::TYPE , n);
+    if (markets != nullptr){
+        layout.add(BookColumn::MARKET , market_rows);
+    }
+    layout.finish();
+
+    std::vector<char> head(layout.entries[0].offset , 0);
+    layout.store(head.data());
+    std::ofstream file(path , std::ios::binary | std::ios::trunc);
+    if (!file){
+        fail(path , "cannot open for writing");
+    }
+    file.write(head.data() , static_cast<std::streamsize>(head.size()));
+    const void* data[] = {batch.strike_ , batch.expiry_ , batch.type_ , markets};
+    const char zeros[ALIGN] = {};
+    for (size_t c = 0; c < layout.entries.size(); ++c){
+        const ColumnEntry& e = layout.entries[c];
+        const size_t bytes = e.rows * e.width;
+        file.write(static_cast<const char*>(data[c]) , static_cast<std::streamsize>(bytes));
+        file.write(zeros , static_cast<std::streamsize>(align_up(e.offset + bytes) - (e.offset + bytes)));
+    }
+    if (!file.flush()){
+        fail(path , "write failed");
+    }
+}
+
+MappedBook::MappedBook(const std::string& path) : data_(nullptr) , bytes_(0) , mapped_(false) , rows_(0) , market_rows_(0) , version_(0){
+    for (const void*& c : columns_){
+        c = nullptr;
+    }
+#if BOOK_FILE_MMAP
+    const int fd = ::open(path.c_str() , O_RDONLY);
+    if (fd < 0){
+        fail(path , "cannot open");
+    }
+    struct stat st;
+    if (::fstat(fd , &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))){
+        ::close(fd);
+        fail(path , "too short for a header");
+    }
+    bytes_ = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr , bytes_ , PROT_READ , MAP_PRIVATE , fd , 0);
+    ::close(fd);
+    if (p == MAP_FAILED){
+        fail(path , "mmap failed");
+    }
+    data_ = static_cast<const char*>(p);
+    mapped_ = true;
+#else
+    std::ifstream file(path , std::ios::binary | std::ios::ate);
+    if (!file){
+        fail(path , "cannot open");
+    }
+    bytes_ = static_cast<size_t>(file.tellg());
+    if (bytes_ < sizeof(FileHeader)){
+        fail(path , "too short for a header");
+    }
+    char* buffer = aligned_buffer(bytes_);
+    data_ = buffer;
+    file.seekg(0);
+    if (!file.read(buffer , static_cast<std::streamsize>(bytes_))){
+        release();
+        fail(path , "read failed");
+    }
+#endif
+
+    // a bad header leaves nothing mapped behind the exception
+    try {
+        FileHeader header;
+        std::memcpy(&header , data_ , sizeof(header));
+        if (std::memcmp(header.magic , MAGIC , sizeof(MAGIC)) != 0){
+            fail(path , "not a book file");
+        }
+        if (header.byte_order != BYTE_ORDER_MARK){
+            fail(path , "written with the other byte order");
+        }
+        if (header.version == 0 || header.version > BOOK_FILE_VERSION){
+            fail(path , "unsupported version");
+        }
+        if (header.columns > COLUMNS || sizeof(FileHeader) + header.columns * sizeof(ColumnEntry) > bytes_){
+            fail(path , "bad column table");
+        }
+        version_ = header.version;
+        rows_ = static_cast<size_t>(header.rows);
+        for (uint32_t c = 0; c < header.columns; ++c){
+            ColumnEntry e;
+            std::memcpy(&e , data_ + sizeof(FileHeader) + c * sizeof(ColumnEntry) , sizeof(e));
+            if (e.id >= COLUMNS || columns_[e.id] != nullptr || e.width != column_width(static_cast<BookColumn>(e.id))){
+                fail(path , "bad column descriptor");
+            }
+            // a result file closed early has fewer rows than its columns hold , never more
+            const bool market = static_cast<BookColumn>(e.id) == BookColumn::MARKET;
+            if (market ? (e.rows != 1 && e.rows != rows_) : e.rows < rows_){
+                fail(path , "column shorter than the book");
+            }
+            if (e.offset % ALIGN != 0 || e.offset > bytes_ || e.rows > (bytes_ - e.offset) / e.width){
+                fail(path , "column outside the file");
+            }
+            columns_[e.id] = data_ + e.offset;
+            if (market){
+                market_rows_ = static_cast<size_t>(e.rows);
+            }
+        }
+        const bool contracts = has(BookColumn::STRIKE) || has(BookColumn::EXPIRY) || has(BookColumn::TYPE);
+        if (contracts && !(has(BookColumn::STRIKE) && has(BookColumn::EXPIRY) && has(BookColumn::TYPE))){
+            fail(path , "incomplete contract columns");
+        }
+    }
+    catch (...){
+        release();
+        throw;
+    }
+}
+
+MappedBook::~MappedBook(){
+    release();
+}
+
+MappedBook::MappedBook(MappedBook&& other) noexcept : data_(nullptr) , bytes_(0) , mapped_(false){
+    *this = std::move(other);
+}
+
+MappedBook& MappedBook::operator=(MappedBook&& other) noexcept {
+    if (this != &other){
+        release();
+        data_ = other.data_;
+        bytes_ = other.bytes_;
+        mapped_ = other.mapped_;
+        rows_ = other.rows_;
+        market_rows_ = other.market_rows_;
+        version_ = other.version_;
+        std::memcpy(columns_ , other.columns_ , sizeof(columns_));
+        other.data_ = nullptr;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MappedBook::release(){
+    if (data_ == nullptr){
+        return;
+    }
+#if BOOK_FILE_MMAP
+    if (mapped_){
+        ::munmap(const_cast<char*>(data_) , bytes_);
+    }
+    else
+#endif
+    {
+        free_buffer(data_);
+    }
+    data_ = nullptr;
+}
+
+OptionBatch MappedBook::batch() const {
+    if (!has(BookColumn::STRIKE)){
+        throw std::runtime_error("book file has no contract columns");
+    }
+    return OptionBatch(static_cast<const double*>(columns_[static_cast<size_t>(BookColumn::STRIKE)]) ,
+                       static_cast<const double*>(columns_[static_cast<size_t>(BookColumn::EXPIRY)]) ,
+                       static_cast<const Option::Type*>(columns_[static_cast<size_t>(BookColumn::TYPE)]) , rows_);
+}
+
+const double* MappedBook::column(BookColumn column) const {
+    if (column == BookColumn::TYPE || column == BookColumn::MARKET || column == BookColumn::COUNT){
+        throw std::invalid_argument("MappedBook::column is for the double columns");
+    }
+    return static_cast<const double*>(columns_[static_cast<size_t>(column)]);
+}
+
+ResultWriter::ResultWriter(const std::string& path , size_t rows , bool greeks) :
+                    path_(path) , data_(nullptr) , bytes_(0) , mapped_(false) , fd_(-1) , capacity_(rows) , written_(0) , prices_(nullptr){
+    Layout layout(0);
+    layout.add(BookColumn::PRICE , rows);
+    if (greeks){
+        for (BookColumn c : {BookColumn::DELTA , BookColumn::GAMMA , BookColumn::VEGA , BookColumn::THETA , BookColumn::RHO}){
+            layout.add(c , rows);
+        }
+    }
+    layout.finish();
+    bytes_ = layout.bytes;
+
+#if BOOK_FILE_MMAP
+    fd_ = ::open(path.c_str() , O_RDWR | O_CREAT | O_TRUNC , 0644);
+    if (fd_ < 0){
+        fail(path , "cannot open for writing");
+    }
+    // sized up front , the columns are sparse until written
+    void* p = ::ftruncate(fd_ , static_cast<off_t>(bytes_)) == 0 ?
+                  ::mmap(nullptr , bytes_ , PROT_READ | PROT_WRITE , MAP_SHARED , fd_ , 0) : MAP_FAILED;
+    if (p == MAP_FAILED){
+        ::close(fd_);
+        fail(path , "cannot size or map for writing");
+    }
+    data_ = static_cast<char*>(p);
+    mapped_ = true;
+#else
+    data_ = aligned_buffer(bytes_);
+    std::memset(data_ , 0 , bytes_);
+#endif
+    // rows = 0 until close()
+    layout.store(data_);
+    double* col[6] = {};
+    for (size_t c = 0; c < layout.entries.size(); ++c){
+        col[c] = reinterpret_cast<double*>(data_ + layout.entries[c].offset);
+    }
+    prices_ = col[0];
+    if (greeks){
+        greeks_ = GreeksBatch(col[1] , col[2] , col[3] , col[4] , col[5]);
+    }
+}
+
+ResultWriter::~ResultWriter(){
+    try {
+        close();
+    }
+    catch (...){
+        // a destructor cannot report the failed flush , close() explicitly to see it
+    }
+}
+
+void ResultWriter::append(const double* price , const GreeksBatch* greeks , size_t n){
+    if (data_ == nullptr){
+        throw std::invalid_argument("ResultWriter is closed");
+    }
+    if (n > capacity_ - written_){
+        throw std::invalid_argument("ResultWriter append past its capacity");
+    }
+    const size_t bytes = n * sizeof(double);
+    std::memcpy(prices_ + written_ , price , bytes);
+    if (greeks != nullptr && greeks_.delta != nullptr){
+        std::memcpy(greeks_.delta + written_ , greeks->delta , bytes);
+        std::memcpy(greeks_.gamma + written_ , greeks->gamma , bytes);
+        std::memcpy(greeks_.vega + written_ , greeks->vega , bytes);
+        std::memcpy(greeks_.theta + written_ , greeks->theta , bytes);
+        std::memcpy(greeks_.rho + written_ , greeks->rho , bytes);
+    }
+    written_ += n;
+}
+
+void ResultWriter::mark_written(size_t rows){
+    if (rows > capacity_){
+        throw std::invalid_argument("ResultWriter rows past its capacity");
+    }
+    written_ = rows;
+}
+
+// columns reach the file before the row count that makes them visible
+void ResultWriter::close(){
+    if (data_ == nullptr){
+        return;
+    }
+    const uint64_t rows = written_;
+    char* data = data_;
+    data_ = nullptr;
+#if BOOK_FILE_MMAP
+    bool ok = ::msync(data , bytes_ , MS_SYNC) == 0;
+    std::memcpy(data + offsetof(FileHeader , rows) , &rows , sizeof(rows));
+    ok = ::msync(data , sizeof(FileHeader) , MS_SYNC) == 0 && ok;
+    ok = ::munmap(data , bytes_) == 0 && ok;
+    ok = ::close(fd_) == 0 && ok;
+    if (!ok){
+        fail(path_ , "flush failed");
+    }
+#else
+    std::memcpy(data + offsetof(FileHeader , rows) , &rows , sizeof(rows));
+    std::ofstream file(path_ , std::ios::binary | std::ios::trunc);
+    file.write(data , static_cast<std::streamsize>(bytes_));
+    free_buffer(data);
+    if (!file.flush()){
+        fail(path_ , "write failed");
+    }
+#endif
+}
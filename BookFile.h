@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "OptionBook.h"
+
+/*
+ * Versioned binary columnar files for option books , market snapshots and pricing results
+ * - layout: a 64 byte header (magic "DPLBOOK" , version , byte order mark , row count , column count) , a table of
+ *   column descriptors , then every column as one contiguous native array starting on a 64 byte boundary
+ * - columns: strike , expiry (double) , type (Option::Type) , market (MarketData records , 1 row shared by the book or
+ *   one per contract) , price and the five greeks (double) , each column present at most once
+ * - MappedBook maps the file read only and hands out the columns in place: batch() and markets() feed price_batch /
+ *   ParallelPricer directly , nothing is parsed or copied and pages are only read when a pricer touches them
+ * - the header and column table are checked on open (magic , version , byte order , every column inside the file),
+ *   the rows are not: files written by write_book come from validated OptionBook / MarketData rows , run validate()
+ *   (Ingest.h) over batch() for files from anywhere else
+ * - ResultWriter sizes a result file for a row capacity and maps it writable , pricers write into prices() / greeks()
+ *   in place or stream chunks through append() , the header row count is only set on close() so a run that dies part way
+ *   leaves a file that reads as empty rather than one with garbage rows
+ * - I/O and format errors throw std::runtime_error , bad arguments std::invalid_argument
+ * - memory mapped on POSIX , elsewhere the file is read into (or written from) one heap buffer with the same layout
+ */
+
+enum class BookColumn : uint32_t {
+    STRIKE,
+    EXPIRY,
+    TYPE,
+    MARKET,
+    PRICE,
+    DELTA,
+    GAMMA,
+    VEGA,
+    THETA,
+    RHO,
+    COUNT
+};
+
+const uint32_t BOOK_FILE_VERSION = 1;
+
+// markets = nullptr writes no market column , otherwise market_rows must be 1 or batch.size()
+void write_book(const std::string& path , const OptionBatch& batch , const MarketData* markets = nullptr , size_t market_rows = 0);
+
+class MappedBook {
+
+public:
+    explicit MappedBook(const std::string& path);
+    ~MappedBook();
+
+    MappedBook(MappedBook&& other) noexcept;
+    MappedBook& operator=(MappedBook&& other) noexcept;
+    MappedBook(const MappedBook&) = delete;
+    MappedBook& operator=(const MappedBook&) = delete;
+
+    size_t size() const {return rows_;}
+    uint32_t version() const {return version_;}
+
+    bool has(BookColumn column) const {return columns_[static_cast<size_t>(column)] != nullptr;}
+
+    // the contract columns in place , throws std::runtime_error when the file has none
+    OptionBatch batch() const;
+
+    // market records in place , nullptr without a market column , market_rows() is 1 (shared) or size()
+    const MarketData* markets() const {return static_cast<const MarketData*>(columns_[static_cast<size_t>(BookColumn::MARKET)]);}
+    size_t market_rows() const {return market_rows_;}
+
+    // price or greek column in place , nullptr when absent
+    const double* column(BookColumn column) const;
+    const double* prices() const {return column(BookColumn::PRICE);}
+
+private:
+    void release();
+
+    const char* data_;
+    size_t bytes_;
+    bool mapped_;
+    size_t rows_;
+    size_t market_rows_;
+    uint32_t version_;
+    const void* columns_[static_cast<size_t>(BookColumn::COUNT)];
+};
+
+class ResultWriter {
+
+public:
+    // a result file for up to `rows` rows: a price column , plus the five greek columns when greeks is set
+    ResultWriter(const std::string& path , size_t rows , bool greeks = true);
+    ~ResultWriter();
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    // whole columns in the file , for pricers that write all rows in place , then mark_written(rows)
+    double* prices() {return prices_;}
+    GreeksBatch greeks() {return greeks_;}
+
+    // rows [written() , written() + n) , greeks = nullptr leaves the greek columns as they are
+    void append(const double* price , const GreeksBatch* greeks , size_t n);
+
+    void mark_written(size_t rows);
+    size_t written() const {return written_;}
+    size_t capacity() const {return capacity_;}
+
+    // records written() rows in the header and flushes , the destructor closes a writer still open
+    void close();
+
+private:
+    std::string path_;
+    char* data_;
+    size_t bytes_;
+    bool mapped_;
+    int fd_;
+    size_t capacity_;
+    size_t written_;
+    double* prices_;
+    GreeksBatch greeks_;
+};
@@ -0,0 +1,127 @@
+#include "BookPricer.h"
+#include <type_traits>
+
+BookPricer::BookPricer() : engines_{BlackScholes() , BinomialTree()}{}
+
+BookPricer::BookPricer(Engine european , Engine american) : engines_{std::move(european) , std::move(american)}{}
+
+// partition results land in contiguous scratch columns and are scattered back through rows()
+namespace {
+
+struct Scratch {
+    std::vector<double> price;
+    std::vector<double> greeks[5];
+    std::vector<MarketData> market;
+
+    GreeksBatch columns(size_t n){
+        for (int k = 0; k < 5; ++k){
+            if (greeks[k].size() < n){
+                greeks[k].resize(n);
+            }
+        }
+        return GreeksBatch(greeks[0].data() , greeks[1].data() , greeks[2].data() , greeks[3].data() , greeks[4].data());
+    }
+
+    const MarketData* gather(const MarketData* marketdata , const std::vector<size_t>& rows){
+        market.clear();
+        for (size_t i = 0; i < rows.size(); ++i){
+            market.push_back(marketdata[rows[i]]);
+        }
+        return market.data();
+    }
+};
+
+Scratch& scratch(){
+    thread_local Scratch s;
+    return s;
+}
+
+// the qualified call names the engine's own override , so it is bound at compile time inside each visit branch
+template <typename Markets>
+void price_partition(const BookPricer::Engine& engine , const OptionBatch& batch , const Markets& markets , double* out){
+    std::visit([&](const auto& model){
+        using Model = std::decay_t<decltype(model)>;
+        model.Model::price_batch(batch , markets , out);
+    } , engine);
+}
+
+template <typename Markets>
+void greeks_partition(const BookPricer::Engine& engine , const OptionBatch& batch , const Markets& markets , const GreeksBatch& out){
+    std::visit([&](const auto& model){
+        using Model = std::decay_t<decltype(model)>;
+        model.Model::greeks_batch(batch , markets , out);
+    } , engine);
+}
+
+void scatter(const GreeksBatch& from , const std::vector<size_t>& rows , const GreeksBatch& out){
+    for (size_t i = 0; i < rows.size(); ++i){
+        const size_t r = rows[i];
+        out.delta[r] = from.delta[i];
+        out.gamma[r] = from.gamma[i];
+        out.vega[r] = from.vega[i];
+        out.theta[r] = from.theta[i];
+        out.rho[r] = from.rho[i];
+    }
+}
+
+}
+
+void BookPricer::price(const MixedBook& book , const MarketData& marketdata , double* out) const {
+    Scratch& s = scratch();
+    for (int k = 0; k < MixedBook::STYLES; ++k){
+        const Exercise e = static_cast<Exercise>(k);
+        const std::vector<size_t>& rows = book.rows(e);
+        if (rows.empty()){
+            continue;
+        }
+        s.price.resize(rows.size());
+        price_partition(engines_[k] , book.book(e).batch() , marketdata , s.price.data());
+        for (size_t i = 0; i < rows.size(); ++i){
+            out[rows[i]] = s.price[i];
+        }
+    }
+}
+
+void BookPricer::price(const MixedBook& book , const MarketData* marketdata , double* out) const {
+    Scratch& s = scratch();
+    for (int k = 0; k < MixedBook::STYLES; ++k){
+        const Exercise e = static_cast<Exercise>(k);
+        const std::vector<size_t>& rows = book.rows(e);
+        if (rows.empty()){
+            continue;
+        }
+        s.price.resize(rows.size());
+        price_partition(engines_[k] , book.book(e).batch() , s.gather(marketdata , rows) , s.price.data());
+        for (size_t i = 0; i < rows.size(); ++i){
+            out[rows[i]] = s.price[i];
+        }
+    }
+}
+
+void BookPricer::greeks(const MixedBook& book , const MarketData& marketdata , const GreeksBatch& out) const {
+    Scratch& s = scratch();
+    for (int k = 0; k < MixedBook::STYLES; ++k){
+        const Exercise e = static_cast<Exercise>(k);
+        const std::vector<size_t>& rows = book.rows(e);
+        if (rows.empty()){
+            continue;
+        }
+        GreeksBatch tmp = s.columns(rows.size());
+        greeks_partition(engines_[k] , book.book(e).batch() , marketdata , tmp);
+        scatter(tmp , rows , out);
+    }
+}
+
+void BookPricer::greeks(const MixedBook& book , const MarketData* marketdata , const GreeksBatch& out) const {
+    Scratch& s = scratch();
+    for (int k = 0; k < MixedBook::STYLES; ++k){
+        const Exercise e = static_cast<Exercise>(k);
+        const std::vector<size_t>& rows = book.rows(e);
+        if (rows.empty()){
+            continue;
+        }
+        GreeksBatch tmp = s.columns(rows.size());
+        greeks_partition(engines_[k] , book.book(e).batch() , s.gather(marketdata , rows) , tmp);
+        scatter(tmp , rows , out);
+    }
+}
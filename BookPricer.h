@@ -0,0 +1,92 @@
+#pragma once
+#include <variant>
+#include <vector>
+#include "BlackScholesmain.h"
+#include "BinomialTree.h"
+#include "LSMC.h"
+
+/*
+ * One pass pricing of books that mix exercise styles
+ * - MixedBook keeps one structure of arrays OptionBook per exercise style plus , for every row , where it went,
+ *   so results come back in the order the contracts were added
+ * - BookPricer holds one engine per style by value in a std::variant , std::visit resolves the engine once per style
+ *   and its batch entry point is called non virtually on the whole partition , nothing is dispatched per contract
+ * - any engine can sit on any style: BlackScholes on the american side prices them as european, LSMC is the Monte Carlo
+ *   alternative to the tree
+ */
+
+enum class Exercise {EUROPEAN , AMERICAN};
+
+class MixedBook {
+
+public:
+    static const int STYLES = 2;
+
+    MixedBook() = default;
+
+    void reserve(size_t n){
+        style_.reserve(n);
+        index_.reserve(n);
+    }
+
+    void add(const Option& option , Exercise exercise){
+        const int s = static_cast<int>(exercise);
+        books_[s].add(option);
+        rows_[s].push_back(size());
+        index_.push_back(books_[s].size() - 1);
+        style_.push_back(exercise);
+    }
+
+    void add(double strike , double expiry , Option::Type type , Exercise exercise){
+        add(Option(strike , expiry , type) , exercise);
+    }
+
+    void clear(){
+        style_.clear();
+        index_.clear();
+        for (int s = 0; s < STYLES; ++s){
+            books_[s].clear();
+            rows_[s].clear();
+        }
+    }
+
+    size_t size() const {return index_.size();}
+    bool empty() const {return index_.empty();}
+
+    Exercise exercise(size_t i) const {return style_[i];}
+    Option at(size_t i) const {return books_[static_cast<int>(style_[i])].at(index_[i]);}
+
+    // the rows of one style as a batch , plus each row's position in the mixed book
+    const OptionBook& book(Exercise exercise) const {return books_[static_cast<int>(exercise)];}
+    const std::vector<size_t>& rows(Exercise exercise) const {return rows_[static_cast<int>(exercise)];}
+
+private:
+    std::vector<Exercise> style_;
+    std::vector<size_t> index_;
+    OptionBook books_[STYLES];
+    std::vector<size_t> rows_[STYLES];
+};
+
+
+class BookPricer {
+
+public:
+    using Engine = std::variant<BlackScholes , BinomialTree , LSMC>;
+
+    // black scholes for the european rows , the leisen reimer tree for the american ones
+    BookPricer();
+    BookPricer(Engine european , Engine american);
+
+    const Engine& engine(Exercise exercise) const {return engines_[static_cast<int>(exercise)];}
+    void set_engine(Exercise exercise , Engine engine) {engines_[static_cast<int>(exercise)] = std::move(engine);}
+
+    // out[i] / row i of out is the result for row i of the book , in the order rows were added
+    // the per row overloads take marketdata[i] for row i
+    void price(const MixedBook& book , const MarketData& marketdata , double* out) const;
+    void price(const MixedBook& book , const MarketData* marketdata , double* out) const;
+    void greeks(const MixedBook& book , const MarketData& marketdata , const GreeksBatch& out) const;
+    void greeks(const MixedBook& book , const MarketData* marketdata , const GreeksBatch& out) const;
+
+private:
+    Engine engines_[MixedBook::STYLES];
+};
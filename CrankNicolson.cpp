@@ -0,0 +1,398 @@
+#include "CrankNicolson.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// everything a solve touches , sized on first use and kept per thread
+struct Workspace {
+    std::vector<double> v;          // current time level
+    std::vector<double> prev;       // level one step before expiry of the solve , for theta
+    std::vector<double> payoff;
+    std::vector<double> rhs;        // right hand side , then the eliminated f of the Thomas sweep
+    std::vector<double> e;          // elimination multipliers , fixed per (theta , dt)
+    std::vector<double> inv;        // 1 / pivots , fixed per (theta , dt)
+
+    // rows of the strip being priced , for the batch grouping
+    std::vector<size_t> rows;
+    std::vector<double> strikes;
+    std::vector<double> values;
+    std::vector<double> greeks[5];
+};
+
+Workspace& workspace(){
+    thread_local Workspace w;
+    return w;
+}
+
+struct Grid {
+    double x0;
+    double dx;
+    size_t last;        // index of the last node , nodes 0 .. last
+    double last_dt;     // length of the final time step , theta divides by it
+};
+
+struct Problem {
+    double T;
+    double r;
+    double q;
+    double sigma;
+    bool call;
+    bool american;
+};
+
+// value , d/dx , d2/dx2 of the cubic through the four nodes around x
+struct Local {
+    double value;
+    double first;
+    double second;
+};
+
+Local interpolate(const std::vector<double>& v , const Grid& g , double x){
+    const double u = (x - g.x0) / g.dx;
+    size_t j = static_cast<size_t>(u);
+    j = std::min(std::max<size_t>(j , 1) , g.last - 2);
+    const double t = u - static_cast<double>(j);
+    const double fm = v[j - 1] , f0 = v[j] , f1 = v[j + 1] , f2 = v[j + 2];
+    const double a1 = -fm / 3.0 - f0 / 2.0 + f1 - f2 / 6.0;
+    const double a2 = 0.5 * (fm + f1) - f0;
+    const double a3 = (f2 - fm) / 6.0 + 0.5 * (f0 - f1);
+    Local out;
+    out.value = f0 + t * (a1 + t * (a2 + t * a3));
+    out.first = (a1 + t * (2.0 * a2 + 3.0 * t * a3)) / g.dx;
+    out.second = (2.0 * a2 + 6.0 * t * a3) / (g.dx * g.dx);
+    return out;
+}
+
+// unit strike boundary values at time to expiry tau
+void boundaries(const Problem& p , const Grid& g , double tau , double& lo , double& hi){
+    const double x_lo = g.x0;
+    const double x_hi = g.x0 + g.dx * static_cast<double>(g.last);
+    if (p.call){
+        lo = 0.0;
+        hi = std::exp(x_hi - p.q * tau) - std::exp(-p.r * tau);
+        if (p.american){
+            hi = std::max(hi , std::exp(x_hi) - 1.0);
+        }
+    }
+    else{
+        lo = std::exp(-p.r * tau) - std::exp(x_lo - p.q * tau);
+        if (p.american){
+            lo = std::max(lo , 1.0 - std::exp(x_lo));
+        }
+        hi = 0.0;
+    }
+}
+
+/*
+ * steps of one theta scheme phase: (1 - theta dt L) v_new = (1 + (1 - theta) dt L) v_old over the interior nodes,
+ * L v_i = alpha v_i-1 + beta v_i + gamma v_i+1
+ * puts eliminate from the top down and sweep up from the exercise region (calls the mirror image) , projecting on the way
+ */
+void run_phase(const Problem& p , const Grid& g , Workspace& w , double theta , double dt , size_t steps , double& tau , bool keep_prev){
+    const size_t N = g.last;
+    const double a = 0.5 * p.sigma * p.sigma / (g.dx * g.dx);
+    const double b = (p.r - p.q - 0.5 * p.sigma * p.sigma) / (2.0 * g.dx);
+    const double alpha = a - b , beta = -2.0 * a - p.r , gamma = a + b;
+    const double l = -theta * dt * alpha , d = 1.0 - theta * dt * beta , u = -theta * dt * gamma;
+    const double el = (1.0 - theta) * dt * alpha , ed = 1.0 + (1.0 - theta) * dt * beta , eu = (1.0 - theta) * dt * gamma;
+
+    double* e = w.e.data();
+    double* inv = w.inv.data();
+    if (p.call){
+        inv[1] = 1.0 / d;
+        e[1] = u * inv[1];
+        for (size_t i = 2; i < N; ++i){
+            inv[i] = 1.0 / (d - l * e[i - 1]);
+            e[i] = u * inv[i];
+        }
+    }
+    else{
+        inv[N - 1] = 1.0 / d;
+        e[N - 1] = l * inv[N - 1];
+        for (size_t i = N - 1; i-- > 1;){
+            inv[i] = 1.0 / (d - u * e[i + 1]);
+            e[i] = l * inv[i];
+        }
+    }
+
+    double* v = w.v.data();
+    double* f = w.rhs.data();
+    const double* payoff = w.payoff.data();
+    for (size_t s = 0; s < steps; ++s){
+        if (keep_prev && s + 1 == steps){
+            w.prev = w.v;
+        }
+        tau += dt;
+        double lo , hi;
+        boundaries(p , g , tau , lo , hi);
+        for (size_t i = 1; i < N; ++i){
+            f[i] = el * v[i - 1] + ed * v[i] + eu * v[i + 1];
+        }
+        f[1] -= l * lo;
+        f[N - 1] -= u * hi;
+        if (p.call){
+            f[1] *= inv[1];
+            for (size_t i = 2; i < N; ++i){
+                f[i] = (f[i] - l * f[i - 1]) * inv[i];
+            }
+            v[N] = hi;
+            for (size_t i = N - 1; i >= 1; --i){
+                const double x = f[i] - e[i] * v[i + 1];
+                v[i] = p.american ? std::max(x , payoff[i]) : x;
+            }
+            v[0] = lo;
+        }
+        else{
+            f[N - 1] *= inv[N - 1];
+            for (size_t i = N - 1; i-- > 1;){
+                f[i] = (f[i] - u * f[i + 1]) * inv[i];
+            }
+            v[0] = lo;
+            for (size_t i = 1; i < N; ++i){
+                const double x = f[i] - e[i] * v[i - 1];
+                v[i] = p.american ? std::max(x , payoff[i]) : x;
+            }
+            v[N] = hi;
+        }
+    }
+}
+
+// one unit strike solve covering x in [x_lo , x_hi] , leaves v at tau = T and prev one step earlier in w
+Grid solve(const CrankNicolson::Config& c , const Problem& p , double x_lo , double x_hi , Workspace& w){
+    PRICING_TIME(CRANK_NICOLSON , PDE_SOLVE);
+    const double band = c.width * p.sigma * std::sqrt(p.T);
+    Grid g;
+    g.dx = 2.0 * band / static_cast<double>(c.space_steps);
+    const double i0 = std::floor((x_lo - band) / g.dx);
+    const double i1 = std::ceil((x_hi + band) / g.dx);
+    g.x0 = i0 * g.dx;
+    g.last = std::max<size_t>(static_cast<size_t>(i1 - i0) , 4);
+
+    const size_t nodes = g.last + 1;
+    PRICING_COUNT(CRANK_NICOLSON , ALLOCATIONS , w.v.capacity() < nodes ? 5 : 0);
+    PRICING_COUNT(CRANK_NICOLSON , TRANSCENDENTALS , nodes);
+    w.v.resize(nodes);
+    w.payoff.resize(nodes);
+    w.rhs.resize(nodes);
+    w.e.resize(nodes);
+    w.inv.resize(nodes);
+    for (size_t i = 0; i < nodes; ++i){
+        const double S = std::exp(g.x0 + g.dx * static_cast<double>(i));
+        w.payoff[i] = std::max(p.call ? S - 1.0 : 1.0 - S , 0.0);
+        w.v[i] = w.payoff[i];
+    }
+
+    const size_t M = c.time_steps;
+    const double dt = p.T / static_cast<double>(M);
+    const size_t R = std::min(c.rannacher_steps , M);
+    double tau = 0.0;
+    if (R == M){
+        run_phase(p , g , w , 1.0 , 0.5 * dt , 2 * R , tau , true);
+        g.last_dt = 0.5 * dt;
+    }
+    else{
+        run_phase(p , g , w , 1.0 , 0.5 * dt , 2 * R , tau , false);
+        run_phase(p , g , w , 0.5 , dt , M - R , tau , true);
+        g.last_dt = dt;
+    }
+    return g;
+}
+
+// the strip's moneyness range , zero strikes are priced in closed form and left out
+bool strip_range(const double* strikes , size_t n , double S , double& x_lo , double& x_hi){
+    bool any = false;
+    for (size_t j = 0; j < n; ++j){
+        if (strikes[j] > 0.0){
+            const double x = std::log(S / strikes[j]);
+            x_lo = any ? std::min(x_lo , x) : x;
+            x_hi = any ? std::max(x_hi , x) : x;
+            any = true;
+        }
+    }
+    return any;
+}
+
+// a zero strike call is the stock (delivered now if american , forward discounted otherwise) , a zero strike put is worthless
+double zero_strike(const Problem& p , double S){
+    return p.call ? (p.american ? S : S * std::exp(-p.q * p.T)) : 0.0;
+}
+
+void strip_values(const CrankNicolson::Config& c , const Problem& p , const double* strikes , size_t n , double S , double* out){
+    double x_lo = 0.0 , x_hi = 0.0;
+    Workspace& w = workspace();
+    Grid g = {};
+    const bool grid = strip_range(strikes , n , S , x_lo , x_hi);
+    if (grid){
+        g = solve(c , p , x_lo , x_hi , w);
+    }
+    for (size_t j = 0; j < n; ++j){
+        out[j] = strikes[j] > 0.0 ? strikes[j] * interpolate(w.v , g , std::log(S / strikes[j])).value : zero_strike(p , S);
+    }
+}
+
+const double BUMP = 1e-3;
+
+// strips of one batch: rows sorted by (type , expiry) , runs of equal keys priced together
+template <typename F>
+void for_strips(const OptionBatch& batch , Workspace& w , const F& fn){
+    w.rows.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i){
+        w.rows[i] = i;
+    }
+    std::sort(w.rows.begin() , w.rows.end() , [&](size_t a , size_t b){
+        if (batch.type_[a] != batch.type_[b]){
+            return batch.type_[a] < batch.type_[b];
+        }
+        return batch.expiry_[a] < batch.expiry_[b];
+    });
+    size_t begin = 0;
+    while (begin < w.rows.size()){
+        const size_t first = w.rows[begin];
+        size_t end = begin + 1;
+        while (end < w.rows.size() && batch.type_[w.rows[end]] == batch.type_[first] && batch.expiry_[w.rows[end]] == batch.expiry_[first]){
+            ++end;
+        }
+        fn(begin , end , batch.expiry_[first] , batch.type_[first]);
+        begin = end;
+    }
+}
+
+} // namespace
+
+
+CrankNicolson::CrankNicolson() : CrankNicolson(Config()){}
+
+CrankNicolson::CrankNicolson(const Config& config) : config_(config){
+    if (config_.space_steps < 4){
+        throw std::invalid_argument("space_steps must be at least 4");
+    }
+    if (config_.time_steps == 0){
+        throw std::invalid_argument("time_steps must be positive");
+    }
+    if (!(config_.width > 0.0)){
+        throw std::invalid_argument("width must be positive");
+    }
+}
+
+double CrankNicolson::price(const Option& option, const MarketData& marketdata) const {
+    PRICING_TIME(CRANK_NICOLSON , CALL);
+    double out;
+    price_strip(&option.strike_ , 1 , option.expiry_ , option.type_ , marketdata , &out);
+    return out;
+}
+
+Greeks CrankNicolson::greeks(const Option& option, const MarketData& marketdata) const {
+    PRICING_TIME(CRANK_NICOLSON , CALL);
+    double d , g , v , t , r;
+    greeks_strip(&option.strike_ , 1 , option.expiry_ , option.type_ , marketdata , GreeksBatch(&d , &g , &v , &t , &r));
+    Greeks out;
+    out.delta = d;
+    out.gamma = g;
+    out.vega = v;
+    out.theta = t;
+    out.rho = r;
+    return out;
+}
+
+void CrankNicolson::price_strip(const double* strikes , size_t n , double expiry , Option::Type type , const MarketData& marketdata , double* out) const {
+    PRICING_TIME(CRANK_NICOLSON , CALL);
+    PRICING_COUNT(CRANK_NICOLSON , OPTIONS , n);
+    const Problem p = {expiry , marketdata.rate_ , marketdata.dividend_ , marketdata.volatility_ , type == Option::Type::CALL , config_.american};
+    strip_values(config_ , p , strikes , n , marketdata.spot_ , out);
+}
+
+// one solve for delta , gamma and theta , then four bumped solves of the whole strip for vega and rho
+void CrankNicolson::greeks_strip(const double* strikes , size_t n , double expiry , Option::Type type , const MarketData& marketdata , const GreeksBatch& out) const {
+    PRICING_TIME(CRANK_NICOLSON , CALL);
+    PRICING_COUNT(CRANK_NICOLSON , OPTIONS , n);
+    const double S = marketdata.spot_;
+    const Problem p = {expiry , marketdata.rate_ , marketdata.dividend_ , marketdata.volatility_ , type == Option::Type::CALL , config_.american};
+    Workspace& w = workspace();
+
+    double x_lo = 0.0 , x_hi = 0.0;
+    if (strip_range(strikes , n , S , x_lo , x_hi)){
+        const Grid g = solve(config_ , p , x_lo , x_hi , w);
+        for (size_t j = 0; j < n; ++j){
+            if (strikes[j] > 0.0){
+                const double x = std::log(S / strikes[j]);
+                const Local now = interpolate(w.v , g , x);
+                out.delta[j] = strikes[j] * now.first / S;
+                out.gamma[j] = strikes[j] * (now.second - now.first) / (S * S);
+                out.theta[j] = strikes[j] * (interpolate(w.prev , g , x).value - now.value) / g.last_dt / 365.0;
+            }
+        }
+    }
+    for (size_t j = 0; j < n; ++j){
+        if (!(strikes[j] > 0.0)){
+            out.delta[j] = p.call ? (p.american ? 1.0 : std::exp(-p.q * p.T)) : 0.0;
+            out.gamma[j] = 0.0;
+            out.theta[j] = p.call && !p.american ? p.q * zero_strike(p , S) / 365.0 : 0.0;
+        }
+    }
+
+    // bumped values land in the vega / rho columns first , up minus down , then scaled to per 1%
+    std::vector<double>& down = w.values;
+    down.resize(n);
+    Problem bumped = p;
+    bumped.sigma = p.sigma + BUMP;
+    strip_values(config_ , bumped , strikes , n , S , out.vega);
+    bumped.sigma = p.sigma - BUMP;
+    strip_values(config_ , bumped , strikes , n , S , down.data());
+    for (size_t j = 0; j < n; ++j){
+        out.vega[j] = (out.vega[j] - down[j]) / (2.0 * BUMP) / 100.0;
+    }
+    bumped = p;
+    bumped.r = p.r + BUMP;
+    strip_values(config_ , bumped , strikes , n , S , out.rho);
+    bumped.r = p.r - BUMP;
+    strip_values(config_ , bumped , strikes , n , S , down.data());
+    for (size_t j = 0; j < n; ++j){
+        out.rho[j] = (out.rho[j] - down[j]) / (2.0 * BUMP) / 100.0;
+    }
+}
+
+void CrankNicolson::price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const {
+    PRICING_TIME(CRANK_NICOLSON , CALL);
+    Workspace& w = workspace();
+    for_strips(batch , w , [&](size_t begin , size_t end , double expiry , Option::Type type){
+        const size_t n = end - begin;
+        w.strikes.resize(n);
+        for (size_t j = 0; j < n; ++j){
+            w.strikes[j] = batch.strike_[w.rows[begin + j]];
+        }
+        w.greeks[0].resize(n);
+        price_strip(w.strikes.data() , n , expiry , type , marketdata , w.greeks[0].data());
+        for (size_t j = 0; j < n; ++j){
+            out[w.rows[begin + j]] = w.greeks[0][j];
+        }
+    });
+}
+
+void CrankNicolson::greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const {
+    PRICING_TIME(CRANK_NICOLSON , CALL);
+    Workspace& w = workspace();
+    for_strips(batch , w , [&](size_t begin , size_t end , double expiry , Option::Type type){
+        const size_t n = end - begin;
+        w.strikes.resize(n);
+        for (size_t j = 0; j < n; ++j){
+            w.strikes[j] = batch.strike_[w.rows[begin + j]];
+        }
+        for (std::vector<double>& column : w.greeks){
+            column.resize(n);
+        }
+        GreeksBatch tmp(w.greeks[0].data() , w.greeks[1].data() , w.greeks[2].data() , w.greeks[3].data() , w.greeks[4].data());
+        greeks_strip(w.strikes.data() , n , expiry , type , marketdata , tmp);
+        for (size_t j = 0; j < n; ++j){
+            const size_t i = w.rows[begin + j];
+            out.delta[i] = tmp.delta[j];
+            out.gamma[i] = tmp.gamma[j];
+            out.vega[i] = tmp.vega[j];
+            out.theta[i] = tmp.theta[j];
+            out.rho[i] = tmp.rho[j];
+        }
+    });
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "PricingMain.h"
+
+/*
+ * Crank-Nicolson finite differences for American (or European) options under Black Scholes
+ * - solves the unit strike problem in x = log(S/K): with constant r , q , sigma the price scales as V = K v(log(S/K)),
+ *   so one grid prices every strike of a strip with the same expiry and type , each strike is an interpolation at its own x
+ * - uniform x grid with x = 0 on a node , space_steps nodes across +-width standard deviations of one strike,
+ *   a strip spanning more moneyness gets proportionally more nodes so every strike sees the same spacing
+ * - Rannacher start: the first rannacher_steps time steps run as two implicit Euler half steps each to damp the payoff kink
+ * - early exercise by Brennan-Schwartz: the tridiagonal system is eliminated away from the exercise region and
+ *   projected onto the payoff during back substitution (exact for a put , and a call , with constant coefficients)
+ * - delta , gamma from the local cubic through the nodes around x , theta from the last two time levels,
+ *   vega and rho by central bumps (re-solving the strip) , same units as BlackScholes
+ * - grid and Thomas buffers live in a per thread workspace reused across calls , the model is safe to share
+ * - price_batch / greeks_batch on one market group the rows into strips by (type , expiry)
+ */
+
+class CrankNicolson : public PricingModel{
+
+public:
+    struct Config {
+        size_t space_steps;
+        size_t time_steps;
+        double width;
+        size_t rannacher_steps;
+        bool american;
+
+        Config() : space_steps(400) , time_steps(200) , width(5.0) , rannacher_steps(2) , american(true){}
+    };
+
+    CrankNicolson();
+    explicit CrankNicolson(const Config& config);
+
+    double price(const Option& option, const MarketData& marketdata) const override;
+    Greeks greeks(const Option& option, const MarketData& marketdata) const override;
+
+    void price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const override;
+    using PricingModel::price_batch;
+    using PricingModel::greeks_batch;
+
+    // n strikes of one expiry and type on one shared grid , out[j] / row j of out is strike j
+    void price_strip(const double* strikes , size_t n , double expiry , Option::Type type , const MarketData& marketdata , double* out) const;
+    void greeks_strip(const double* strikes , size_t n , double expiry , Option::Type type , const MarketData& marketdata , const GreeksBatch& out) const;
+
+    const Config& config() const {return config_;}
+
+private:
+    Config config_;
+};
@@ -1,15 +1,21 @@
 #pragma once
 #include<cmath>
-#include "Optionp.hpp"
+#include "Optionbase.hpp"
 
+// helper functions , declared ahead of EuropeanOption which uses them
 
-class EuropeanOption : public Option {
+inline double norm_cdf(double x) {return 0.5 * std::erfc(-x / std::sqrt(2));}
+
+inline double norm_pdf(double x) {return std::exp(-0.5 * x * x) / std::sqrt(2.0 * M_PI);}
+
+
+class EuropeanOption : public OptionBase {
 
 public:
     //constructor here but it should also call base class constructor 
 
     EuropeanOption(double spot , double strike , double rate , double T , double sigma , Optiontype type) : 
-                                                                    Option(spot , strike , rate , T , sigma , type) {}
+                                                                    OptionBase(spot , strike , rate , T , sigma , type) {}
 
     // Destructor for no memory leaks 
     ~EuropeanOption() = default ;
@@ -64,10 +70,3 @@ private:
 
     inline double d2() const { return d1() - sigma_*std::sqrt(T_);}
 };
-
-// helper functions 
-
-inline double norm_cdf(double x) {return 0.5 * std::erfc(-x / std::sqrt(2));}
-
-inline double norm_pdf(double x) {return std::exp(-0.5 * x * x) / std::sqrt(2.0 * M_PI);}
-
@@ -0,0 +1,53 @@
+#include "GpuBackend.h"
+
+// no device backend is built (GpuBackend.h) , every call below is the CPU engine's
+
+bool gpu_compiled(){
+    return false;
+}
+
+bool gpu_available(int device){
+    (void)device;
+    return false;
+}
+
+std::string gpu_device_name(int device){
+    (void)device;
+    return "";
+}
+
+GpuBlackScholes::GpuBlackScholes(const Config& config , const BlackScholes& cpu) : config_(config) , cpu_(cpu){
+    if (config_.chunk_rows == 0){
+        throw std::invalid_argument("chunk_rows must be positive");
+    }
+}
+
+GpuBlackScholes::~GpuBlackScholes() = default;
+
+void GpuBlackScholes::price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const {
+    cpu_.price_batch(batch , marketdata , out);
+}
+
+void GpuBlackScholes::price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const {
+    cpu_.price_batch(batch , marketdata , out);
+}
+
+void GpuBlackScholes::greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const {
+    cpu_.greeks_batch(batch , marketdata , out);
+}
+
+void GpuBlackScholes::greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const {
+    cpu_.greeks_batch(batch , marketdata , out);
+}
+
+GpuLSMC::GpuLSMC(const Config& config) : config_(config) , cpu_(config.lsmc){}
+
+GpuLSMC::~GpuLSMC() = default;
+
+bool GpuLSMC::supports(const LSMC::Config& config){
+    return config.chunk_size == 0 && config.target_error == 0.0 && !config.use_sobol;
+}
+
+LSMC::Result GpuLSMC::run(const Option& option , const MarketData& marketdata) const {
+    return cpu_.run(option , marketdata);
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <string>
+#include "BlackScholesmain.h"
+#include "LSMC.h"
+
+/*
+ * Interface of a GPU backend for the batch closed form and for LSMC path simulation
+ * - no device code is built: a CUDA implementation goes back in only once it has been compiled by nvcc and its
+ *   tolerance tests have passed on a device , until then every call below runs the CPU engine it wraps , so code
+ *   written against these classes runs anywhere and the CPU engines stay the reference
+ * - GpuBlackScholes: price_batch / greeks_batch of large batches (min_rows and up , chunk_rows per transfer) are what a
+ *   device would take , every single contract call stays on the CPU
+ * - GpuLSMC: supports() names the in sample Philox runs a device would take , the rest always runs the CPU engine
+ * - the tolerances are what a device run has to hold against the CPU: the closed form to GPU_BLACK_SCHOLES_TOLERANCE
+ *   relative (of max(1 , |cpu value|)) , LSMC prices to GPU_LSMC_TOLERANCE standard errors of the CPU run of the same config
+ */
+
+const double GPU_BLACK_SCHOLES_TOLERANCE = 1e-12;
+const double GPU_LSMC_TOLERANCE = 1e-2;
+
+// true when a device backend was compiled in and a device is present , always false in this build
+bool gpu_compiled();
+bool gpu_available(int device = 0);
+
+// "" without a device
+std::string gpu_device_name(int device = 0);
+
+class GpuBlackScholes : public PricingModel {
+
+public:
+    struct Config {
+        size_t chunk_rows;      // rows per transfer and kernel launch , two chunks are in flight
+        size_t min_rows;        // smaller batches run on the CPU , launch and copy latency would dominate
+        int device;
+
+        Config() : chunk_rows(1u << 18) , min_rows(1u << 14) , device(0){}
+    };
+
+    GpuBlackScholes() : GpuBlackScholes(Config()){}
+    explicit GpuBlackScholes(const Config& config , const BlackScholes& cpu = BlackScholes(BlackScholes::Kernel::SIMD));
+    ~GpuBlackScholes() override;
+
+    double price(const Option& option , const MarketData& marketdata) const override {return cpu_.price(option , marketdata);}
+    Greeks greeks(const Option& option , const MarketData& marketdata) const override {return cpu_.greeks(option , marketdata);}
+    Valuation evaluate(const Option& option , const MarketData& marketdata , unsigned request = Valuation::PRICE | Valuation::GREEKS) const override {
+        return cpu_.evaluate(option , marketdata , request);
+    }
+    Sensitivities sensitivities(const Option& option , const MarketData& marketdata) const override {
+        return cpu_.sensitivities(option , marketdata);
+    }
+
+    void price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const override;
+    void price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const override;
+
+    // whether a batch of `rows` rows runs on the device , never without one
+    bool on_device(size_t rows) const {return gpu_available(config_.device) && rows >= config_.min_rows;}
+
+    const BlackScholes& cpu() const {return cpu_;}
+    const Config& config() const {return config_;}
+
+private:
+    Config config_;
+    BlackScholes cpu_;
+};
+
+class GpuLSMC : public PricingModel {
+
+public:
+    struct Config {
+        LSMC::Config lsmc;
+        int device;
+
+        Config() : device(0){}
+        explicit Config(const LSMC::Config& config) : lsmc(config) , device(0){}
+    };
+
+    GpuLSMC() : GpuLSMC(Config()){}
+    explicit GpuLSMC(const Config& config);
+    ~GpuLSMC() override;
+
+    double price(const Option& option , const MarketData& marketdata) const override {return run(option , marketdata).price;}
+    Greeks greeks(const Option& option , const MarketData& marketdata) const override {return cpu_.greeks(option , marketdata);}
+    Sensitivities sensitivities(const Option& option , const MarketData& marketdata) const override {
+        return cpu_.sensitivities(option , marketdata);
+    }
+
+    LSMC::Result run(const Option& option , const MarketData& marketdata) const;
+
+    // the LSMC configurations the device runs: in sample , fixed path count , Philox normals
+    static bool supports(const LSMC::Config& config);
+    bool on_device() const {return gpu_available(config_.device) && supports(config_.lsmc);}
+
+    const LSMC& cpu() const {return cpu_;}
+    const Config& config() const {return config_;}
+
+private:
+    Config config_;
+    LSMC cpu_;
+};
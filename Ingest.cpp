@@ -0,0 +1,105 @@
+#include "Ingest.h"
+#include <cstring>
+
+// the same rules as the Option and MarketData constructors , as integer tests on the bit patterns:
+// no flags , no branches , so the checks of neighbouring rows overlap freely
+
+static const uint64_t SIGN = 0x8000000000000000ull;
+static const uint64_t EXPONENT = 0x7FF0000000000000ull;   // inf , anything at or above it (sign clear) is inf or NaN
+
+static inline uint64_t bits(double x){
+    uint64_t b;
+    std::memcpy(&b , &x , sizeof(b));
+    return b;
+}
+
+static inline bool finite_value(double x) {return (bits(x) & ~SIGN) < EXPONENT;}
+
+// x > 0 and finite , denormals included
+static inline bool finite_positive(double x) {return bits(x) - 1 < EXPONENT - 1;}
+
+// x >= 0 and finite , -0 included as x >= 0.0 does
+static inline bool finite_non_negative(double x) {return (bits(x) < EXPONENT) | (bits(x) == SIGN);}
+
+static inline bool bad_contract(double strike , double expiry , Option::Type type){
+    return !(finite_non_negative(strike) & finite_positive(expiry) &
+             ((type == Option::Type::CALL) | (type == Option::Type::PUT)));
+}
+
+static inline bool bad_market(const MarketRecord& m){
+    return !(finite_positive(m.spot) & finite_positive(m.volatility) & finite_value(m.rate) & finite_value(m.dividend));
+}
+
+// 64 rows to a word: flags go to one byte per row first (no loop carried dependency) ,
+// then every 8 bytes fold into 8 bits with one multiply
+template <typename Bad>
+static size_t fill_bitmap(size_t n , uint64_t* errors , Bad bad){
+    size_t count = 0;
+    for (size_t w = 0; w < error_words(n); ++w){
+        const size_t begin = w * 64;
+        const size_t rows = begin + 64 < n ? 64 : n - begin;
+        uint8_t flags[64] = {};
+        for (size_t j = 0; j < rows; ++j){
+            flags[j] = bad(begin + j);
+        }
+        uint64_t word = 0;
+        for (int k = 0; k < 8; ++k){
+            uint64_t x;
+            std::memcpy(&x , flags + 8 * k , sizeof(x));
+            word |= ((x * 0x0102040810204080ull) >> 56) << (8 * k);
+        }
+        errors[w] = word;
+        count += static_cast<size_t>(__builtin_popcountll(word));
+    }
+    return count;
+}
+
+size_t validate(const OptionBatch& batch , uint64_t* errors){
+    return fill_bitmap(batch.size() , errors , [&](size_t i){
+        return bad_contract(batch.strike_[i] , batch.expiry_[i] , batch.type_[i]);
+    });
+}
+
+size_t validate(const ContractRecord* records , size_t n , uint64_t* errors){
+    return fill_bitmap(n , errors , [&](size_t i){
+        return bad_contract(records[i].strike , records[i].expiry , records[i].type);
+    });
+}
+
+size_t validate(const MarketRecord* records , size_t n , uint64_t* errors){
+    return fill_bitmap(n , errors , [&](size_t i){
+        return bad_market(records[i]);
+    });
+}
+
+// 64 rows at a time: the good rows of a word are gathered into columns and handed to the book in one go
+size_t append(OptionBook& book , const ContractRecord* records , size_t n , const uint64_t* errors){
+    double strike[64] , expiry[64];
+    Option::Type type[64];
+    size_t added = 0;
+    for (size_t w = 0; w < error_words(n); ++w){
+        const size_t begin = w * 64;
+        const size_t end = begin + 64 < n ? begin + 64 : n;
+        const uint64_t word = errors ? errors[w] : 0;
+        size_t m = 0;
+        for (size_t i = begin; i < end; ++i){
+            strike[m] = records[i].strike;
+            expiry[m] = records[i].expiry;
+            type[m] = records[i].type;
+            m += !((word >> (i - begin)) & 1u);
+        }
+        book.add_unchecked(strike , expiry , type , m);
+        added += m;
+    }
+    return added;
+}
+
+void to_market(const MarketRecord* records , size_t n , const uint64_t* errors , MarketData* out){
+    for (size_t i = 0; i < n; ++i){
+        if (errors && has_error(errors , i)){
+            continue;
+        }
+        const MarketRecord& m = records[i];
+        out[i] = MarketData(MarketData::Unchecked() , m.spot , m.rate , m.volatility , m.dividend);
+    }
+}
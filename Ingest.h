@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include "OptionBook.h"
+
+/*
+ * Bulk ingestion path for feed handlers
+ * - ContractRecord and MarketRecord are plain trivially copyable records , no constructor , no validation , no vtable,
+ *   so they can be filled straight from a wire buffer
+ * - validate() checks a whole column batch or record array against the same rules as the Option / MarketData constructors,
+ *   never throws and reports bad rows in an error bitmap: bit (i % 64) of errors[i / 64] is set when row i is invalid
+ * - append() / to_market() then move the good rows into the batch pricers' inputs through the Unchecked constructors,
+ *   nothing is allocated as long as the book has reserved capacity
+ */
+
+struct ContractRecord {
+    double strike;
+    double expiry;
+    Option::Type type;
+};
+
+struct MarketRecord {
+    double spot;
+    double rate;
+    double volatility;
+    double dividend;
+};
+
+static_assert(std::is_trivially_copyable<ContractRecord>::value && std::is_standard_layout<ContractRecord>::value, "ContractRecord must stay a plain record");
+static_assert(std::is_trivially_copyable<MarketRecord>::value && std::is_standard_layout<MarketRecord>::value, "MarketRecord must stay a plain record");
+static_assert(std::is_trivially_copyable<Option>::value && std::is_trivially_copyable<MarketData>::value, "contracts must copy as plain memory");
+
+// words of bitmap needed for n rows
+inline size_t error_words(size_t n) {return (n + 63) / 64;}
+
+inline bool has_error(const uint64_t* errors , size_t i) {return (errors[i / 64] >> (i % 64)) & 1u;}
+
+// fill errors[error_words(n)] , returns the number of invalid rows
+size_t validate(const OptionBatch& batch , uint64_t* errors);
+size_t validate(const ContractRecord* records , size_t n , uint64_t* errors);
+size_t validate(const MarketRecord* records , size_t n , uint64_t* errors);
+
+// appends the rows whose error bit is clear (errors = nullptr appends all of them) , returns the rows appended
+size_t append(OptionBook& book , const ContractRecord* records , size_t n , const uint64_t* errors);
+
+// records to MarketData for the per row batch pricers , rows with their error bit set are left as they were
+void to_market(const MarketRecord* records , size_t n , const uint64_t* errors , MarketData* out);
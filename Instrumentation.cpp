@@ -0,0 +1,139 @@
+#include "Instrumentation.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+
+uint64_t now_ns(){
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// CALL scopes open on this thread , only the outermost one records
+thread_local int call_depth = 0;
+
+void append(std::string& out , const char* format , ...) __attribute__((format(printf , 2 , 3)));
+
+void append(std::string& out , const char* format , ...){
+    char buffer[256];
+    va_list args;
+    va_start(args , format);
+    const int n = std::vsnprintf(buffer , sizeof(buffer) , format , args);
+    va_end(args);
+    if (n > 0){
+        out.append(buffer , static_cast<size_t>(n) < sizeof(buffer) ? static_cast<size_t>(n) : sizeof(buffer) - 1);
+    }
+}
+
+} // namespace
+
+Instrumentation& Instrumentation::global(){
+    static Instrumentation registry;
+    return registry;
+}
+
+bool Instrumentation::enabled(){
+#if PRICING_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+Instrumentation::Instrumentation(){
+    reset();
+}
+
+void Instrumentation::reset(){
+    for (Engine& e : engines_){
+        for (std::atomic<uint64_t>& c : e.counters){
+            c.store(0 , std::memory_order_relaxed);
+        }
+        for (LatencyHistogram& h : e.phases){
+            h.reset();
+        }
+    }
+}
+
+const char* Instrumentation::name(InstrumentEngine engine){
+    switch (engine){
+        case InstrumentEngine::BLACK_SCHOLES: return "black_scholes";
+        case InstrumentEngine::BINOMIAL_TREE: return "binomial_tree";
+        case InstrumentEngine::CRANK_NICOLSON: return "crank_nicolson";
+        case InstrumentEngine::LSMC: return "lsmc";
+        default: return "unknown";
+    }
+}
+
+const char* Instrumentation::name(InstrumentPhase phase){
+    switch (phase){
+        case InstrumentPhase::CALL: return "call";
+        case InstrumentPhase::PATH_GENERATION: return "path_generation";
+        case InstrumentPhase::REGRESSION: return "regression";
+        case InstrumentPhase::FORWARD: return "forward";
+        case InstrumentPhase::INDUCTION: return "induction";
+        case InstrumentPhase::PDE_SOLVE: return "pde_solve";
+        case InstrumentPhase::IMPLIED_VOL: return "implied_vol";
+        default: return "unknown";
+    }
+}
+
+const char* Instrumentation::name(InstrumentCounter counter){
+    switch (counter){
+        case InstrumentCounter::OPTIONS: return "options";
+        case InstrumentCounter::TRANSCENDENTALS: return "transcendentals";
+        case InstrumentCounter::ALLOCATIONS: return "allocations";
+        default: return "unknown";
+    }
+}
+
+std::string Instrumentation::to_json() const {
+    std::string out;
+    append(out , "{\"enabled\": %s, \"engines\": {" , enabled() ? "true" : "false");
+    for (size_t e = 0; e < ENGINES; ++e){
+        const InstrumentEngine engine = static_cast<InstrumentEngine>(e);
+        append(out , "%s\"%s\": {\"calls\": %llu" , e > 0 ? ", " : "" , name(engine) ,
+               static_cast<unsigned long long>(calls(engine)));
+        for (size_t c = 0; c < COUNTERS; ++c){
+            const InstrumentCounter k = static_cast<InstrumentCounter>(c);
+            append(out , ", \"%s\": %llu" , name(k) , static_cast<unsigned long long>(counter(engine , k)));
+        }
+        out += ", \"phases\": {";
+        bool first = true;
+        for (size_t p = 0; p < PHASES; ++p){
+            const LatencyHistogram& h = engines_[e].phases[p];
+            if (h.count() == 0){
+                continue;
+            }
+            append(out , "%s\"%s\": {\"count\": %llu, \"mean_ns\": %.1f, \"p50_ns\": %llu, \"p90_ns\": %llu, "
+                         "\"p99_ns\": %llu, \"max_ns\": %llu}" ,
+                   first ? "" : ", " , name(static_cast<InstrumentPhase>(p)) , static_cast<unsigned long long>(h.count()) ,
+                   h.mean() , static_cast<unsigned long long>(h.quantile(0.5)) , static_cast<unsigned long long>(h.quantile(0.9)) ,
+                   static_cast<unsigned long long>(h.quantile(0.99)) , static_cast<unsigned long long>(h.max()));
+            first = false;
+        }
+        out += "}}";
+    }
+    out += "}}";
+    return out;
+}
+
+InstrumentScope::InstrumentScope(InstrumentEngine engine , InstrumentPhase phase) :
+                    engine_(engine) , phase_(phase) , active_(phase != InstrumentPhase::CALL || call_depth == 0) , start_(0){
+    if (phase_ == InstrumentPhase::CALL){
+        ++call_depth;
+    }
+    if (active_){
+        start_ = now_ns();
+    }
+}
+
+InstrumentScope::~InstrumentScope(){
+    if (active_){
+        Instrumentation::global().record(engine_ , phase_ , now_ns() - start_);
+    }
+    if (phase_ == InstrumentPhase::CALL){
+        --call_depth;
+    }
+}
@@ -0,0 +1,838 @@
+#include "LSMC.h"
+#include "Aad.h"
+#include "BlackScholesmain.h"
+#include "Instrumentation.h"
+#include "LsmcRegression.h"
+#include "QuasiRandom.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <vector>
+#include <algorithm>
+
+namespace {
+
+using lsmc::Continuation;
+using lsmc::NormalEquations;
+using lsmc::solve;
+
+// Sobol points and the bridge that turns them into paths , built once per run when use_sobol is set
+struct Quasi {
+    Sobol sobol;
+    BrownianBridge bridge;
+
+    explicit Quasi(size_t steps) : sobol(steps) , bridge(steps){}
+};
+
+std::unique_ptr<Quasi> make_quasi(const LSMC::Config& config){
+    PRICING_COUNT(LSMC , ALLOCATIONS , config.use_sobol ? 1 : 0);
+    return config.use_sobol ? std::unique_ptr<Quasi>(new Quasi(config.num_timesteps)) : nullptr;
+}
+
+// everything about one contract the simulation needs , computed once per run
+struct Setup {
+    double S0;
+    double K;
+    double w;        // +1 call , -1 put
+    double dt;
+    double disc;     // one step discount factor
+    double drift;    // (r - q - sigma^2/2) dt
+    double vol;      // sigma sqrt(dt)
+    double sigma;
+    double rate;
+    double mu;       // r - q - sigma^2/2
+    double T;
+    size_t steps;
+    bool antithetic;
+    bool control;           // control variate: the european payoff of every path , against its closed form value
+    double final_disc;      // e^(-rT)
+    double european;
+    int basis;
+    const Quasi* quasi;     // null = Philox normals
+
+    double payoff(double S) const {return std::max(w * (S - K) , 0.0);}
+
+    // regression variable , centred on the strike so the power sums stay well conditioned
+    double x(double S) const {return S / K - 1.0;}
+};
+
+Setup make_setup(const Option& option , const MarketData& marketdata , const LSMC::Config& config , const Quasi* quasi){
+    if (!(option.strike_ > 0.0)){
+        throw std::invalid_argument("LSMC needs a positive strike , the regression variable is S / K - 1");
+    }
+    Setup s;
+    s.S0 = marketdata.spot_;
+    s.K = option.strike_;
+    s.w = option.type_ == Option::Type::CALL ? 1.0 : -1.0;
+    s.steps = config.num_timesteps;
+    s.dt = option.expiry_ / static_cast<double>(s.steps);
+    s.disc = std::exp(-marketdata.rate_ * s.dt);
+    double sigma = marketdata.volatility_;
+    s.drift = (marketdata.rate_ - marketdata.dividend_ - 0.5 * sigma * sigma) * s.dt;
+    s.vol = sigma * std::sqrt(s.dt);
+    s.sigma = sigma;
+    s.rate = marketdata.rate_;
+    s.mu = marketdata.rate_ - marketdata.dividend_ - 0.5 * sigma * sigma;
+    s.T = option.expiry_;
+    s.antithetic = config.use_antithetic;
+    s.control = config.use_control_variate;
+    s.final_disc = std::exp(-marketdata.rate_ * option.expiry_);
+    s.european = s.control ? BlackScholes().price(option , marketdata) : 0.0;
+    s.basis = config.polynomial_degree + 1;
+    s.quasi = quasi;
+    return s;
+}
+
+const size_t BLOCK = 1024;   // paths per task , fixed so the reduction order never depends on the thread count
+
+size_t block_count(size_t n){return (n + BLOCK - 1) / BLOCK;}
+
+// runs fn(b) for every block , inline when there is no pool
+template <class F>
+void for_blocks(ThreadPool* pool , size_t blocks , const F& fn){
+    if (pool == nullptr || blocks == 1){
+        for (size_t b = 0; b < blocks; ++b){
+            fn(b);
+        }
+        return;
+    }
+    pool->parallel_for(blocks , std::function<void(size_t)>(fn));
+}
+
+// per thread scratch , grown on demand and reused across blocks and runs
+double* scratch(size_t n){
+    static thread_local std::vector<double> buffer;
+    if (buffer.size() < n){
+        PRICING_COUNT(LSMC , ALLOCATIONS , 1);
+        buffer.resize(n);
+    }
+    return buffer.data();
+}
+
+/*
+ * Quasi random version of normals(): path p is Sobol point p (p/2 with antithetic pairs) digitally shifted
+ * by (seed , stream) , mapped through the inverse normal cdf and laid out by the Brownian bridge
+ * consecutive points differ by one direction number so a block costs one seek and then one xor per point
+ */
+void quasi_normals(const Setup& s , uint32_t seed , uint32_t stream , uint64_t first , size_t m , double* z){
+    const Sobol& sobol = s.quasi->sobol;
+    const size_t d = s.steps;
+    PRICING_COUNT(LSMC , ALLOCATIONS , 2);
+    std::vector<uint32_t> state(2 * d);
+    uint32_t* shift = state.data() + d;
+    std::vector<double> u(2 * d);
+    double* w = u.data() + d;
+    sobol.shift(seed , stream , shift);
+
+    uint64_t point = 0;
+    for (size_t k = 0; k < m; ++k){
+        const uint64_t path = first + k;
+        const uint64_t index = s.antithetic ? path >> 1 : path;
+        if (k == 0 || index != point){
+            if (k == 0){
+                sobol.seek(index , state.data());
+            }
+            else{
+                sobol.advance(point , state.data());
+            }
+            point = index;
+            sobol.uniforms(state.data() , shift , u.data());
+            for (size_t t = 0; t < d; ++t){
+                u[t] = inverse_normal_cdf(u[t]);
+            }
+            s.quasi->bridge.transform(u.data() , w);
+        }
+        const double sign = s.antithetic && (path & 1) ? -1.0 : 1.0;
+        for (size_t t = 0; t < d; ++t){
+            z[t * m + k] = sign * w[t];
+        }
+    }
+}
+
+/*
+ * Normal increments of paths [first , first + m) for every step , step-major: z[t*m + k]
+ * antithetic paths come in adjacent pairs (2j , 2j+1) sharing draw j with opposite signs
+ */
+void normals(const Setup& s , uint32_t seed , uint32_t stream , uint64_t first , size_t m , double* z){
+    if (s.quasi != nullptr){
+        quasi_normals(s , seed , stream , first , m , z);
+        return;
+    }
+    for (size_t t = 0; t < s.steps; ++t){
+        double* row = z + t * m;
+        if (!s.antithetic){
+            for (size_t k = 0; k < m; ++k){
+                row[k] = counter_normal(seed , stream , first + k , t);
+            }
+            continue;
+        }
+        size_t k = 0;
+        if (first & 1){
+            row[k++] = -counter_normal(seed , stream , first >> 1 , t);
+        }
+        for (; k + 1 < m; k += 2){
+            double v = counter_normal(seed , stream , (first + k) >> 1 , t);
+            row[k] = v;
+            row[k + 1] = -v;
+        }
+        if (k < m){
+            row[k] = counter_normal(seed , stream , (first + k) >> 1 , t);
+        }
+    }
+}
+
+// fills a timestep-major arena with paths [0 , n) of the given stream
+void simulate(const Setup& s , ThreadPool* pool , uint32_t seed , uint32_t stream , size_t n , double* arena){
+    PRICING_TIME(LSMC , PATH_GENERATION);
+    PRICING_COUNT(LSMC , TRANSCENDENTALS , 2 * s.steps * n);
+    for_blocks(pool , block_count(n) , [&](size_t b){
+        const size_t p0 = b * BLOCK;
+        const size_t m = std::min(BLOCK , n - p0);
+        double* z = scratch(s.steps * m);
+        normals(s , seed , stream , p0 , m , z);
+
+        std::fill(arena + p0 , arena + p0 + m , s.S0);
+        for (size_t t = 1; t <= s.steps; ++t){
+            const double* prev = arena + (t - 1) * n + p0;
+            double* cur = arena + t * n + p0;
+            const double* dz = z + (t - 1) * m;
+            for (size_t k = 0; k < m; ++k){
+                cur[k] = prev[k] * std::exp(s.drift + s.vol * dz[k]);
+            }
+        }
+    });
+}
+
+/*
+ * Sample sums of the discounted cash flows x , and with the control variate of the discounted european payoffs y
+ * of the same paths: the estimate is mean(x) - beta (mean(y) - european) with beta = cov(x , y) / var(y) fitted on the
+ * sample , its variance var(x) (1 - corr(x , y)^2)
+ * - the second moments are over independent units: a path , or with antithetic draws the average of a pair
+ *   (2j , 2j+1) , whose two paths are not independent of each other
+ */
+struct Accumulator {
+    double sum = 0.0;           // over paths
+    double control = 0.0;
+    double sum_sq = 0.0;        // over units
+    double control_sq = 0.0;
+    double cross = 0.0;
+    size_t count = 0;           // paths
+    size_t units = 0;
+
+    void unit(double x , double y){
+        sum_sq += x * x;
+        control_sq += y * y;
+        cross += x * y;
+        ++units;
+    }
+
+    /*
+     * paths [0 , m) of a block , x their discounted cash flows and last their spots at expiry (only read with the control)
+     * blocks start at an even path , so with antithetic draws the pairs are (k , k+1) for even k , a trailing odd path is a unit alone
+     */
+    void add_paths(const Setup& s , size_t m , const double* x , const double* last){
+        auto y = [&](size_t k){return s.control ? s.final_disc * s.payoff(last[k]) : 0.0;};
+        size_t k = 0;
+        if (s.antithetic){
+            for (; k + 1 < m; k += 2){
+                const double x0 = x[k] , x1 = x[k + 1] , y0 = y(k) , y1 = y(k + 1);
+                sum += x0 + x1;
+                control += y0 + y1;
+                unit(0.5 * (x0 + x1) , 0.5 * (y0 + y1));
+            }
+        }
+        for (; k < m; ++k){
+            const double yk = y(k);
+            sum += x[k];
+            control += yk;
+            unit(x[k] , yk);
+        }
+        count += m;
+    }
+
+    void merge(const Accumulator& other){
+        sum += other.sum;
+        sum_sq += other.sum_sq;
+        control += other.control;
+        control_sq += other.control_sq;
+        cross += other.cross;
+        count += other.count;
+        units += other.units;
+    }
+
+    LSMC::Result result(const Setup& s) const {
+        const double n = static_cast<double>(count);
+        const double u = static_cast<double>(units);
+        const double dof = units > 1 ? u - 1.0 : 1.0;
+        double mean = sum / n;
+        double var = std::max((sum_sq - u * mean * mean) / dof , 0.0);
+        LSMC::Result r = {mean , std::sqrt(var / u) , count , std::sqrt(var / u)};
+        const double b = beta(s);
+        if (b != 0.0){
+            const double control_mean = control / n;
+            const double cov = (cross - u * mean * control_mean) / dof;
+            r.price = mean - b * (control_mean - s.european);
+            r.std_error = std::sqrt(std::max(var - b * cov , 0.0) / u);
+        }
+        return r;
+    }
+
+    // the fitted control coefficient cov(x , y) / var(y) , 0 without the control variate or when y is constant
+    double beta(const Setup& s) const {
+        if (!s.control){
+            return 0.0;
+        }
+        const double u = static_cast<double>(units);
+        const double dof = units > 1 ? u - 1.0 : 1.0;
+        const double mean = sum / static_cast<double>(count) , control_mean = control / static_cast<double>(count);
+        const double control_var = (control_sq - u * control_mean * control_mean) / dof;
+        return control_var > 0.0 ? (cross - u * mean * control_mean) / dof / control_var : 0.0;
+    }
+};
+
+/*
+ * Pathwise tangents of each path's discounted cash flow c = e^(-r t) w (S_t - K) , under the fixed exercise policy
+ * - with X = log(S_t / S0) = mu t + sigma W_t: dS_t/dS0 = S_t/S0 , dX/dsigma = (X - (mu + sigma^2) t) / sigma,
+ *   dX/dr = t , dX/dT = (X + mu t) / 2T (same step count , so t and W_t scale with T)
+ * - gamma mixes the pathwise delta with the likelihood ratio of the first step (z1 the first normal of the path):
+ *   E[ e^(-r t) w S_t (z1 / (sigma sqrt(dt)) - 1) ] / S0^2 , so the payoff kink never needs a second derivative
+ * - everything comes from the cash flow , its spot , its time and z1 , so the pass that prices fills it as it goes
+ */
+struct PathwiseSums {
+    double delta = 0.0;
+    double gamma = 0.0;
+    double vega = 0.0;
+    double rho = 0.0;
+    double expiry = 0.0;
+
+    void add(const Setup& s , double cash , double S , double t , double z1){
+        if (cash <= 0.0){
+            return;
+        }
+        const double ds = cash / (s.w * (S - s.K)) * s.w * S;     // S dc/dS
+        const double X = std::log(S / s.S0);
+        delta += ds;
+        gamma += ds * (z1 / s.vol - 1.0);
+        vega += ds * (X - (s.mu + s.sigma * s.sigma) * t) / s.sigma;
+        rho += t * (ds - cash);
+        expiry += -s.rate * t / s.T * cash + ds * (X + s.mu * t) / (2.0 * s.T);
+    }
+
+    void merge(const PathwiseSums& other){
+        delta += other.delta;
+        gamma += other.gamma;
+        vega += other.vega;
+        rho += other.rho;
+        expiry += other.expiry;
+    }
+
+    // per path means in the units of Greeks , floored like the price: below intrinsic it is the intrinsic's
+    Greeks greeks(const Setup& s , size_t paths , bool floored) const {
+        Greeks g;
+        if (floored){
+            g.delta = s.w;
+            return g;
+        }
+        const double inv = 1.0 / static_cast<double>(paths);
+        g.delta = delta * inv / s.S0;
+        g.gamma = gamma * inv / (s.S0 * s.S0);
+        g.vega = vega * inv / 100.0;
+        g.rho = rho * inv / 100.0;
+        g.theta = -expiry * inv / 365.0;
+        return g;
+    }
+};
+
+/*
+ * Backward Longstaff-Schwartz pass over a resident arena
+ * value[p] holds the cash flow of path p discounted to the current step , coeffs[t] gets the fit at step t
+ * one parallel sweep per step: apply the exercise decision of step t+1 , discount , accumulate the regression at t
+ * returns the in-sample estimate of the time 0 value
+ */
+Accumulator backward(const Setup& s , ThreadPool* pool , const double* arena , size_t n , double* value , Continuation* coeffs ,
+                     PathwiseSums* pathwise){
+    PRICING_TIME(LSMC , REGRESSION);
+    PRICING_COUNT(LSMC , ALLOCATIONS , 1);
+    const size_t blocks = block_count(n);
+    std::vector<NormalEquations> partial(blocks);
+    std::vector<Accumulator> sums(blocks);
+    std::vector<PathwiseSums> tangents(pathwise != nullptr ? blocks : 0);
+    // step of each path's cash flow , only kept for the pathwise greeks
+    std::vector<uint32_t> when(pathwise != nullptr ? n : 0 , static_cast<uint32_t>(s.steps));
+
+    for (size_t t = s.steps; t-- > 0;){
+        const double* spot = arena + t * n;
+        const double* next = arena + (t + 1) * n;
+        const Continuation* c = t + 1 < s.steps && coeffs[t + 1].valid ? &coeffs[t + 1] : nullptr;
+
+        for_blocks(pool , blocks , [&](size_t b){
+            const size_t p0 = b * BLOCK;
+            const size_t p1 = std::min(p0 + BLOCK , n);
+            if (t + 1 == s.steps){
+                for (size_t p = p0; p < p1; ++p){
+                    value[p] = s.payoff(next[p]);
+                }
+            }
+            else if (c != nullptr){
+                for (size_t p = p0; p < p1; ++p){
+                    double exercise = s.payoff(next[p]);
+                    if (exercise > 0.0 && exercise > (*c)(s.x(next[p]))){
+                        value[p] = exercise;
+                        if (pathwise != nullptr){
+                            when[p] = static_cast<uint32_t>(t + 1);
+                        }
+                    }
+                }
+            }
+            for (size_t p = p0; p < p1; ++p){
+                value[p] *= s.disc;
+            }
+
+            if (t == 0){
+                sums[b].add_paths(s , p1 - p0 , value + p0 , arena + s.steps * n + p0);
+                if (pathwise != nullptr){
+                    for (size_t p = p0; p < p1; ++p){
+                        const double z1 = (std::log(next[p] / s.S0) - s.drift) / s.vol;
+                        tangents[b].add(s , value[p] , arena[when[p] * n + p] , when[p] * s.dt , z1);
+                    }
+                }
+                return;
+            }
+            NormalEquations& ne = partial[b];
+            ne.reset(s.basis);
+            for (size_t p = p0; p < p1; ++p){
+                if (s.payoff(spot[p]) > 0.0){
+                    ne.add(s.x(spot[p]) , value[p]);
+                }
+            }
+        });
+
+        if (t > 0){
+            NormalEquations ne;
+            ne.reset(s.basis);
+            for (size_t b = 0; b < blocks; ++b){
+                ne.merge(partial[b]);
+            }
+            coeffs[t] = solve(ne);
+        }
+    }
+
+    Accumulator acc;
+    for (size_t b = 0; b < blocks; ++b){
+        acc.merge(sums[b]);
+    }
+    for (const PathwiseSums& t : tangents){
+        pathwise->merge(t);
+    }
+    return acc;
+}
+
+/*
+ * Forward pricing pass with fixed coefficients over paths [first , first + n) of a stream
+ * every block simulates its own paths step by step keeping only the current spot ,
+ * so memory is a few blocks of doubles per thread however many paths and steps there are
+ */
+Accumulator forward(const Setup& s , ThreadPool* pool , uint32_t seed , uint32_t stream , size_t first , size_t n , const Continuation* coeffs ,
+                    PathwiseSums* pathwise = nullptr){
+    PRICING_TIME(LSMC , FORWARD);
+    PRICING_COUNT(LSMC , ALLOCATIONS , 1);
+    PRICING_COUNT(LSMC , TRANSCENDENTALS , 2 * s.steps * n);
+    const size_t blocks = block_count(n);
+    std::vector<Accumulator> sums(blocks);
+    std::vector<PathwiseSums> tangents(pathwise != nullptr ? blocks : 0);
+
+    for_blocks(pool , blocks , [&](size_t b){
+        const size_t p0 = b * BLOCK;
+        const size_t m = std::min(BLOCK , n - p0);
+        double* z = scratch(s.steps * m + 4 * m);
+        double* spot = z + s.steps * m;
+        double* cash = spot + m;
+        double* hit = cash + m;        // spot and time of each cash flow , for the pathwise greeks
+        double* at = hit + m;
+        normals(s , seed , stream , first + p0 , m , z);
+
+        std::fill(spot , spot + m , s.S0);
+        std::fill(cash , cash + m , -1.0);     // negative = still alive , cash flows are never negative
+
+        double df = 1.0;
+        for (size_t t = 1; t <= s.steps; ++t){
+            const double* dz = z + (t - 1) * m;
+            for (size_t k = 0; k < m; ++k){
+                spot[k] *= std::exp(s.drift + s.vol * dz[k]);
+            }
+
+            df *= s.disc;
+            const double time = static_cast<double>(t) * s.dt;
+            if (t == s.steps){
+                for (size_t k = 0; k < m; ++k){
+                    if (cash[k] < 0.0){
+                        cash[k] = df * s.payoff(spot[k]);
+                        hit[k] = spot[k];
+                        at[k] = time;
+                    }
+                }
+                break;
+            }
+
+            const Continuation& c = coeffs[t];
+            if (!c.valid){
+                continue;
+            }
+            for (size_t k = 0; k < m; ++k){
+                double exercise = s.payoff(spot[k]);
+                if (cash[k] < 0.0 && exercise > 0.0 && exercise > c(s.x(spot[k]))){
+                    cash[k] = df * exercise;
+                    hit[k] = spot[k];
+                    at[k] = time;
+                }
+            }
+        }
+
+        sums[b].add_paths(s , m , cash , spot);
+        if (pathwise != nullptr){
+            for (size_t k = 0; k < m; ++k){
+                tangents[b].add(s , cash[k] , hit[k] , at[k] , z[k]);
+            }
+        }
+    });
+
+    Accumulator acc;
+    for (size_t b = 0; b < blocks; ++b){
+        acc.merge(sums[b]);
+    }
+    for (const PathwiseSums& t : tangents){
+        pathwise->merge(t);
+    }
+    return acc;
+}
+
+/*
+ * forward() recorded on the tape , for the sensitivities under a fixed policy
+ * - each block records its own copy of the inputs on its thread's tape , then one path at a time is recorded
+ *   (one node per step: S exp(drift + vol z) with its three partials written out) , swept back to the mark
+ *   after the inputs and rewound , the inputs' adjoints keep the block's sum over its paths
+ * - exercise is decided on values , so the boundary stays put and only each path's cash flow is differentiated
+ * - with the control variate each path also carries its discounted european payoff y to expiry , and x - beta y is
+ *   what gets seeded and summed (beta frozen at the value forward() fits on these paths)
+ * - block sums are reduced in block order like the price , the result does not depend on the thread count
+ */
+Sensitivities taped_forward(const Setup& s , const MarketData& marketdata , double expiry , ThreadPool* pool ,
+                            uint32_t seed , uint32_t stream , size_t n , const Continuation* coeffs , double beta){
+    const size_t blocks = block_count(n);
+    std::vector<Sensitivities> sums(blocks);
+
+    for_blocks(pool , blocks , [&](size_t b){
+        const size_t p0 = b * BLOCK;
+        const size_t m = std::min(BLOCK , n - p0);
+        double* z = scratch(s.steps * m);
+        normals(s , seed , stream , p0 , m , z);
+
+        AadTape& tape = AadTape::local();
+        const AadTape::Mark start = tape.mark();
+        const AadReal S0 = AadReal::input(marketdata.spot_);
+        const AadReal sigma = AadReal::input(marketdata.volatility_);
+        const AadReal r = AadReal::input(marketdata.rate_);
+        const AadReal q = AadReal::input(marketdata.dividend_);
+        const AadReal T = AadReal::input(expiry);
+        const AadReal dt = T / static_cast<double>(s.steps);
+        const AadReal drift = (r - q - 0.5 * sigma * sigma) * dt;
+        const AadReal vol = sigma * sqrt(dt);
+        const AadReal rdt = r * dt;
+        thread_local std::vector<AadReal> df;
+        df.resize(s.steps + 1);
+        for (size_t t = 1; t <= s.steps; ++t){
+            df[t] = exp(-static_cast<double>(t) * rdt);
+        }
+        const AadTape::Mark paths = tape.mark();
+
+        Sensitivities& sum = sums[b];
+        for (size_t k = 0; k < m; ++k){
+            AadReal S = S0;
+            AadReal cash;
+            bool alive = true;
+            for (size_t t = 1; t <= s.steps; ++t){
+                const double dz = z[(t - 1) * m + k];
+                const double next = S.value() * std::exp(drift.value() + vol.value() * dz);
+                const AadReal* args[3] = {&S , &drift , &vol};
+                const double partials[3] = {next / S.value() , next , next * dz};
+                S = AadReal::make(next , 3 , args , partials);
+
+                const double exercise = s.payoff(next);
+                if (alive && exercise > 0.0 && (t == s.steps || (coeffs[t].valid && exercise > coeffs[t](s.x(next))))){
+                    cash = df[t] * (s.w * (S - s.K));
+                    alive = false;
+                    if (!s.control){
+                        break;
+                    }
+                }
+            }
+            sum.price += cash.value();
+            cash.seed();
+            if (s.control && s.payoff(S.value()) > 0.0){
+                const AadReal european = df[s.steps] * (s.w * (S - s.K));
+                sum.price -= beta * european.value();
+                european.seed(-beta);
+            }
+            tape.propagate(tape.mark() , paths);
+            tape.rewind(paths);
+        }
+        tape.propagate(paths , start);
+        sum.spot = S0.adjoint();
+        sum.volatility = sigma.adjoint();
+        sum.rate = r.adjoint();
+        sum.dividend = q.adjoint();
+        sum.expiry = T.adjoint();
+        tape.rewind(start);
+    });
+
+    Sensitivities out;
+    for (size_t b = 0; b < blocks; ++b){
+        out.price += sums[b].price;
+        out.spot += sums[b].spot;
+        out.volatility += sums[b].volatility;
+        out.rate += sums[b].rate;
+        out.dividend += sums[b].dividend;
+        out.expiry += sums[b].expiry;
+    }
+    const double inv = 1.0 / static_cast<double>(n);
+    out.price *= inv;
+    out.spot *= inv;
+    out.volatility *= inv;
+    out.rate *= inv;
+    out.dividend *= inv;
+    out.expiry *= inv;
+    return out;
+}
+
+} // namespace
+
+
+LSMC::LSMC() : LSMC(Config()){}
+
+LSMC::LSMC(const Config& config) : config_(config) , pool_(nullptr){
+    if (config_.num_paths == 0){
+        throw std::invalid_argument("num_paths must be positive");
+    }
+    if (config_.num_timesteps == 0){
+        throw std::invalid_argument("num_timesteps must be positive");
+    }
+    if (config_.polynomial_degree < 1 || config_.polynomial_degree > MAX_DEGREE){
+        throw std::invalid_argument("polynomial_degree must be between 1 and LSMC::MAX_DEGREE");
+    }
+    if (config_.use_sobol && (config_.use_antithetic ? config_.num_paths / 2 : config_.num_paths) >> Sobol::BITS){
+        throw std::invalid_argument("use_sobol supports at most 2^32 Sobol points");
+    }
+    if (config_.num_threads == 0){
+        pool_ = &ThreadPool::global();
+    }
+    else if (config_.num_threads > 1){
+        own_pool_ = std::make_shared<ThreadPool>(config_.num_threads);
+        pool_ = own_pool_.get();
+    }
+}
+
+namespace {
+
+// paths of the fitting set and of the out of sample pricing set are separate Philox streams
+const uint32_t FIT_STREAM = 0;
+const uint32_t PRICE_STREAM = 1;
+
+// paths the policy is fitted on when target_error is set and chunk_size is not
+const size_t PILOT_PATHS = 16384;
+
+size_t fit_paths(const LSMC::Config& config){
+    if (config.chunk_size > 0){
+        return std::min(config.chunk_size , config.num_paths);
+    }
+    return config.target_error > 0.0 ? std::min(PILOT_PATHS , config.num_paths) : config.num_paths;
+}
+
+// fits the exercise policy into coeffs , returns the in-sample estimate when every path is resident
+LSMC::Result fit(const Setup& s , const LSMC::Config& config , ThreadPool* pool , Continuation* coeffs , PathwiseSums* pathwise = nullptr){
+    const size_t n = fit_paths(config);
+    PRICING_COUNT(LSMC , ALLOCATIONS , 2);
+    std::vector<double> arena((s.steps + 1) * n);
+    std::vector<double> value(n);
+    simulate(s , pool , config.seed , FIT_STREAM , n , arena.data());
+    return backward(s , pool , arena.data() , n , value.data() , coeffs , pathwise).result(s);
+}
+
+// exercising immediately is always an option
+LSMC::Result floor_intrinsic(const Setup& s , LSMC::Result r){
+    double intrinsic = s.payoff(s.S0);
+    if (intrinsic > r.price){
+        r.price = intrinsic;
+        r.std_error = 0.0;
+        r.std_error_plain = 0.0;
+    }
+    return r;
+}
+
+/*
+ * target_error: the pilot (fit set) estimate is returned when it already meets the target or is below intrinsic,
+ * otherwise out of sample rounds are priced , each sized from the latest error as n (error / target)^2 plus 10%
+ * (whole blocks , at most num_paths in all) , until the error of all rounds together meets the target
+ * the error estimates are deterministic , so the rounds and the result still do not depend on num_threads
+ */
+LSMC::Result adaptive_rounds(const Setup& s , const LSMC::Config& config , ThreadPool* pool , const Continuation* coeffs ,
+                             LSMC::Result r , PathwiseSums* pathwise){
+    Accumulator acc;
+    size_t done = 0;
+    while (done < config.num_paths){
+        const double ratio = r.std_error / config.target_error;
+        const double want = 1.1 * static_cast<double>(r.paths) * ratio * ratio - static_cast<double>(done);
+        size_t next = want > static_cast<double>(BLOCK) ? block_count(static_cast<size_t>(want)) * BLOCK : BLOCK;
+        next = std::min(next , config.num_paths - done);
+        acc.merge(forward(s , pool , config.seed , PRICE_STREAM , done , next , coeffs , pathwise));
+        done += next;
+        r = acc.result(s);
+        if (r.std_error <= config.target_error){
+            break;
+        }
+    }
+    return r;
+}
+
+// the price , plus the pathwise greeks of the paths that priced it when greeks is set
+LSMC::Result price_run(const Setup& s , const LSMC::Config& config , ThreadPool* pool , Greeks* greeks){
+    PRICING_COUNT(LSMC , ALLOCATIONS , 1);
+    std::vector<Continuation> coeffs(s.steps + 1);
+    PathwiseSums tangents;
+    PathwiseSums* pathwise = greeks != nullptr ? &tangents : nullptr;
+    const bool adaptive = config.target_error > 0.0;
+    const bool chunked = fit_paths(config) < config.num_paths;
+
+    LSMC::Result r = fit(s , config , pool , coeffs.data() , chunked && !adaptive ? nullptr : pathwise);
+    if (adaptive){
+        if (chunked && r.std_error > config.target_error && s.payoff(s.S0) <= r.price){
+            tangents = PathwiseSums();
+            r = adaptive_rounds(s , config , pool , coeffs.data() , r , pathwise);
+        }
+    }
+    else if (chunked){
+        // out of sample: fresh paths under the policy fitted on the first chunk
+        r = forward(s , pool , config.seed , PRICE_STREAM , 0 , config.num_paths , coeffs.data() , pathwise).result(s);
+    }
+    LSMC::Result floored = floor_intrinsic(s , r);
+    if (greeks != nullptr){
+        *greeks = tangents.greeks(s , r.paths , floored.price != r.price);
+    }
+    return floored;
+}
+
+} // namespace
+
+LSMC::Result LSMC::run(const Option& option, const MarketData& marketdata) const {
+    PRICING_TIME(LSMC , CALL);
+    PRICING_COUNT(LSMC , OPTIONS , 1);
+    std::unique_ptr<Quasi> quasi = make_quasi(config_);
+    return price_run(make_setup(option , marketdata , config_ , quasi.get()) , config_ , pool_ , nullptr);
+}
+
+// with PATHWISE the price and every greek come out of one run
+Valuation LSMC::evaluate(const Option& option , const MarketData& marketdata , unsigned request) const {
+    PRICING_TIME(LSMC , CALL);
+    if (config_.greeks_method != GreeksMethod::PATHWISE || !(request & Valuation::GREEKS)){
+        return PricingModel::evaluate(option , marketdata , request);
+    }
+    PRICING_COUNT(LSMC , OPTIONS , 1);
+    std::unique_ptr<Quasi> quasi = make_quasi(config_);
+    Valuation v;
+    v.price = price_run(make_setup(option , marketdata , config_ , quasi.get()) , config_ , pool_ , &v.greeks).price;
+    return v;
+}
+
+double LSMC::price(const Option& option, const MarketData& marketdata) const {
+    PRICING_TIME(LSMC , CALL);
+    return run(option , marketdata).price;
+}
+
+namespace {
+
+/*
+ * the taped pass over the paths the bumps reprice , floored like the price: below intrinsic it is the intrinsic's slope
+ * with the control variate it is the derivative of forward().result() with beta frozen: the taped mean of x - beta y
+ * plus beta times the closed form european's own sensitivities
+ */
+Sensitivities taped(const Setup& s , const Option& option , const MarketData& marketdata , const LSMC::Config& config ,
+                    ThreadPool* pool , const Continuation* coeffs){
+    const double beta = s.control ? forward(s , pool , config.seed , FIT_STREAM , 0 , config.num_paths , coeffs).beta(s) : 0.0;
+    Sensitivities out = taped_forward(s , marketdata , option.expiry_ , pool , config.seed , FIT_STREAM , config.num_paths , coeffs , beta);
+    if (beta != 0.0){
+        const Sensitivities e = BlackScholes().sensitivities(option , marketdata);
+        out.price += beta * s.european;
+        out.spot += beta * e.spot;
+        out.volatility += beta * e.volatility;
+        out.rate += beta * e.rate;
+        out.dividend += beta * e.dividend;
+        out.expiry += beta * e.expiry;
+    }
+    const double intrinsic = s.payoff(s.S0);
+    if (intrinsic > out.price){
+        out = Sensitivities();
+        out.price = intrinsic;
+        out.spot = s.w;
+    }
+    return out;
+}
+
+} // namespace
+
+Sensitivities LSMC::sensitivities(const Option& option , const MarketData& marketdata) const {
+    PRICING_TIME(LSMC , CALL);
+    PRICING_COUNT(LSMC , OPTIONS , 1);
+    std::unique_ptr<Quasi> quasi = make_quasi(config_);
+    Setup s = make_setup(option , marketdata , config_ , quasi.get());
+    PRICING_COUNT(LSMC , ALLOCATIONS , 1);
+    std::vector<Continuation> coeffs(s.steps + 1);
+    fit(s , config_ , pool_ , coeffs.data());
+    return taped(s , option , marketdata , config_ , pool_ , coeffs.data());
+}
+
+/*
+ * Policy is fitted once on the base market and frozen , every bump then reprices the same paths
+ * (same seed) under that policy , so the differences do not pick up noise from refitting the regression
+ * with AAD one taped pass over those paths replaces the base , vega , rho and theta repricings
+ */
+Greeks LSMC::greeks(const Option& option, const MarketData& marketdata) const {
+    PRICING_TIME(LSMC , CALL);
+    if (config_.greeks_method == GreeksMethod::PATHWISE){
+        return evaluate(option , marketdata , Valuation::GREEKS).greeks;
+    }
+    PRICING_COUNT(LSMC , OPTIONS , 1);
+    PRICING_COUNT(LSMC , ALLOCATIONS , 1);
+    const double S = marketdata.spot_;
+    const double r = marketdata.rate_;
+    const double sigma = marketdata.volatility_;
+    const double q = marketdata.dividend_;
+    const double hS = 0.01 * S;
+
+    std::unique_ptr<Quasi> quasi = make_quasi(config_);
+    Setup s = make_setup(option , marketdata , config_ , quasi.get());
+    std::vector<Continuation> coeffs(s.steps + 1);
+    fit(s , config_ , pool_ , coeffs.data());
+    auto reprice = [&](const Option& o , const MarketData& m){
+        Setup b = make_setup(o , m , config_ , quasi.get());
+        return floor_intrinsic(b , forward(b , pool_ , config_.seed , FIT_STREAM , 0 , config_.num_paths , coeffs.data()).result(b)).price;
+    };
+
+    double up = reprice(option , MarketData(S + hS , r , sigma , q));
+    double down = reprice(option , MarketData(S - hS , r , sigma , q));
+    if (config_.greeks_method == GreeksMethod::AAD){
+        const Sensitivities d = taped(s , option , marketdata , config_ , pool_ , coeffs.data());
+        return d.greeks((up - 2.0 * d.price + down) / (hS * hS));
+    }
+    double base = reprice(option , marketdata);
+
+    Greeks g;
+    g.delta = (up - down) / (2.0 * hS);
+    g.gamma = (up - 2.0 * base + down) / (hS * hS);
+    // one vol point , or half of sigma when that is smaller , so sigma - h stays positive
+    const double h = std::min(0.01 , 0.5 * sigma);
+    g.vega = (reprice(option , MarketData(S , r , sigma + h , q)) - reprice(option , MarketData(S , r , sigma - h , q))) / (2.0 * h / 0.01);
+    g.rho = (reprice(option , MarketData(S , r + 0.01 , sigma , q)) - reprice(option , MarketData(S , r - 0.01 , sigma , q))) / 2.0;
+
+    // theta off the taped pass: repricing T - 1d under the policy fitted at T is biased (the boundary moves with dt)
+    // and a refit on the same draws leaves the two regressions' noise in a one day difference
+    g.theta = -taped(s , option , marketdata , config_ , pool_ , coeffs.data()).expiry / 365.0;
+    return g;
+}
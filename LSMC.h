@@ -1,20 +1,97 @@
+#pragma once
+#include <memory>
 #include "PricingMain.h"
 
+class ThreadPool;
+
+/*
+ * Longstaff-Schwartz least squares Monte Carlo for American (Bermudan on the simulation grid) options , strike > 0
+ * - paths live in one contiguous timestep-major arena: spot of path p at step t is arena[t*paths + p]
+ * - continuation value at each step is a polynomial in (S/K - 1) fitted on in-the-money paths,
+ *   the fit goes through a fixed size normal equation accumulator (power sums) , no design matrix
+ * - chunk_size = 0 keeps every path resident and prices in sample
+ *   chunk_size > 0 bounds memory: coefficients are fitted on one resident chunk of chunk_size paths,
+ *   then num_paths fresh paths are priced block by block keeping only each path's current spot (out of sample)
+ * - paths are simulated and regressed in fixed blocks on a work-stealing pool , every normal is a Philox draw
+ *   keyed by (seed , path , step) and block partial sums are reduced in block order ,
+ *   so the result is bit-identical for any num_threads
+ * - use_sobol swaps the Philox normals for digitally shifted Sobol points laid out by a Brownian bridge
+ *   (quasi Monte Carlo) , std_error is still the plain sample error , which overstates the error of a Sobol estimate
+ * - use_control_variate prices the european payoff of every path alongside and corrects the estimate by the difference
+ *   between its sample mean and BlackScholes::price (optimal coefficient fitted on the same sample) , the american
+ *   minus european premium is all that is left to Monte Carlo
+ * - target_error > 0 fits the policy on a pilot (chunk_size paths , 16384 when chunk_size is 0) and returns its estimate
+ *   if that already meets the target (deep out of the money) or is below intrinsic (deep in the money) , otherwise it
+ *   prices out of sample rounds sized from the error so far until the target or num_paths is reached , Result::paths
+ *   is what was spent
+ * - sensitivities() and greeks with GreeksMethod::AAD fit the policy once , then tape the pricing pass one path at a time
+ *   under that frozen policy (Aad.h): one recorded pass gives d price / d spot , vol , rate , dividend and expiry together,
+ *   with the control variate applied (coefficient frozen) so the taped price is the one the bumps reprice
+ * - GreeksMethod::PATHWISE needs no extra pass at all: the run that prices (in sample , or the out of sample pass when
+ *   chunked) differentiates each path's cash flow under the policy as it goes , gamma by the pathwise / likelihood ratio
+ *   mix on the first step
+ */
+
 class LSMC : public PricingModel{
 
 public:
+    // BUMP reprices bumped markets on common random numbers (vega bumps min(1 vol point , sigma / 2) , theta comes off the
+    // taped pass: a one day bump of the expiry moves the exercise boundary) , AAD differentiates one taped pass (gamma still from two bumps),
+    // PATHWISE accumulates pathwise delta , vega , rho , theta and a likelihood ratio gamma inside the pricing run
+    enum class GreeksMethod {BUMP , AAD , PATHWISE};
+
     struct Config {
         size_t num_paths;
         size_t num_timesteps;
         unsigned int seed;
         bool use_antithetic;
+        bool use_sobol;
+        bool use_control_variate;
+        double target_error;    // 0 = price num_paths paths , > 0 = stop once std_error <= target_error (num_paths is the cap)
         int polynomial_degree ;
+        size_t chunk_size;
+        size_t num_threads;     // 0 = shared pool over every core , 1 = calling thread only , n = private pool of n threads
+        GreeksMethod greeks_method;
 
 
-        Config():num_paths(50000) , num_timesteps(50) , seed(12345) , use_antithetic(true) , polynomial_degree(3){}
+        Config():num_paths(50000) , num_timesteps(50) , seed(12345) , use_antithetic(true) , use_sobol(false) , use_control_variate(false) , target_error(0.0) , polynomial_degree(3) , chunk_size(0) ,
+                 num_threads(0) , greeks_method(GreeksMethod::BUMP){}
 
 
     };
 
+    // price with its Monte Carlo standard error , std_error_plain is the error of the same paths without the control variate
+    // (equal to std_error when there is none) , so (std_error_plain / std_error)^2 is the path count factor the control saves
+    // with use_antithetic both are errors over the pair averages , the two paths of a pair are not independent
+    struct Result {
+        double price;
+        double std_error;
+        size_t paths;
+        double std_error_plain;
+    };
+
+    static const int MAX_DEGREE = 8;
+
+    LSMC();
+    explicit LSMC(const Config& config);
+
+    double price(const Option& option, const MarketData& marketdata) const override;
+
+    // bump and reprice on common random numbers (same seed for every bump) , or the taped pass with GreeksMethod::AAD
+    Greeks greeks(const Option& option, const MarketData& marketdata) const override;
+
+    Sensitivities sensitivities(const Option& option , const MarketData& marketdata) const override;
+
+    // price and greeks of one run with GreeksMethod::PATHWISE , otherwise the price and greeks() separately
+    Valuation evaluate(const Option& option , const MarketData& marketdata , unsigned request = Valuation::PRICE | Valuation::GREEKS) const override;
+
+    Result run(const Option& option, const MarketData& marketdata) const;
+
+    const Config& config() const {return config_;}
+
+private:
+    Config config_;
+    std::shared_ptr<ThreadPool> own_pool_;
+    ThreadPool* pool_;
+
 };
-    
\ No newline at end of file
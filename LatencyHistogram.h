@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Log-linear latency histogram (HDR style) in nanoseconds
+ * - values below 8 get a bucket each , above that every power of two is split into 8 linear sub buckets,
+ *   so any quantile is within 12.5% of the recorded value from 1 ns up to 2^41 ns (36 minutes) , larger values clamp
+ * - record() is one relaxed fetch_add per counter , any number of threads may record into one histogram,
+ *   readers on other threads see a value that is at worst a few records behind
+ * - fixed size (about 2.5 KB) , nothing allocated after construction
+ */
+
+class LatencyHistogram {
+
+public:
+    static const size_t SUB_BUCKETS = 8;
+    static const size_t OCTAVES = 38;
+    static const size_t BUCKETS = SUB_BUCKETS * (OCTAVES + 1);
+
+    LatencyHistogram(){reset();}
+
+    void record(uint64_t ns){
+        counts_[bucket(ns)].fetch_add(1 , std::memory_order_relaxed);
+        count_.fetch_add(1 , std::memory_order_relaxed);
+        sum_.fetch_add(ns , std::memory_order_relaxed);
+        uint64_t seen = max_.load(std::memory_order_relaxed);
+        while (ns > seen && !max_.compare_exchange_weak(seen , ns , std::memory_order_relaxed)){}
+    }
+
+    uint64_t count() const {return count_.load(std::memory_order_relaxed);}
+    uint64_t sum() const {return sum_.load(std::memory_order_relaxed);}
+    uint64_t max() const {return max_.load(std::memory_order_relaxed);}
+    double mean() const {
+        const uint64_t n = count();
+        return n > 0 ? static_cast<double>(sum()) / static_cast<double>(n) : 0.0;
+    }
+
+    // smallest bucket value with at least q of the records at or below it , 0 when empty
+    uint64_t quantile(double q) const {
+        const uint64_t n = count();
+        if (n == 0){
+            return 0;
+        }
+        const double want = q * static_cast<double>(n);
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BUCKETS; ++b){
+            seen += counts_[b].load(std::memory_order_relaxed);
+            if (static_cast<double>(seen) >= want && seen > 0){
+                return lower(b);
+            }
+        }
+        return max();
+    }
+
+    uint64_t bucket_count(size_t b) const {return counts_[b].load(std::memory_order_relaxed);}
+
+    // smallest value that lands in bucket b
+    static uint64_t lower(size_t b){
+        if (b < SUB_BUCKETS){
+            return b;
+        }
+        const size_t octave = b / SUB_BUCKETS - 1;
+        return (SUB_BUCKETS + b % SUB_BUCKETS) << octave;
+    }
+
+    static size_t bucket(uint64_t ns){
+        if (ns < SUB_BUCKETS){
+            return static_cast<size_t>(ns);
+        }
+        const size_t msb = 63 - static_cast<size_t>(__builtin_clzll(ns));
+        const size_t octave = msb - 3;
+        if (octave >= OCTAVES){
+            return BUCKETS - 1;
+        }
+        return (octave + 1) * SUB_BUCKETS + static_cast<size_t>((ns >> octave) & (SUB_BUCKETS - 1));
+    }
+
+    void merge(const LatencyHistogram& other){
+        for (size_t b = 0; b < BUCKETS; ++b){
+            counts_[b].fetch_add(other.bucket_count(b) , std::memory_order_relaxed);
+        }
+        count_.fetch_add(other.count() , std::memory_order_relaxed);
+        sum_.fetch_add(other.sum() , std::memory_order_relaxed);
+        uint64_t seen = max_.load(std::memory_order_relaxed);
+        const uint64_t m = other.max();
+        while (m > seen && !max_.compare_exchange_weak(seen , m , std::memory_order_relaxed)){}
+    }
+
+    // not atomic against concurrent record() , call between runs
+    void reset(){
+        for (std::atomic<uint64_t>& c : counts_){
+            c.store(0 , std::memory_order_relaxed);
+        }
+        count_.store(0 , std::memory_order_relaxed);
+        sum_.store(0 , std::memory_order_relaxed);
+        max_.store(0 , std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> counts_[BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
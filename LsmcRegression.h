@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "LSMC.h"
+
+/*
+ * The regression step of LSMC.cpp: the normal equations of one exercise date and their solve
+ */
+
+namespace lsmc {
+
+const int MAX_BASIS = LSMC::MAX_DEGREE + 1;
+
+/*
+ * Least squares on 1 , x , ... , x^(n-1) accumulated one sample at a time
+ * X'X is a Hankel matrix so only the power sums sum x^k (k < 2n-1) and sum x^k y are kept
+ */
+struct NormalEquations {
+    int n;
+    size_t count;
+    double moments[2 * MAX_BASIS - 1];
+    double xty[MAX_BASIS];
+
+    void reset(int basis){
+        n = basis;
+        count = 0;
+        std::fill(moments , moments + 2 * n - 1 , 0.0);
+        std::fill(xty , xty + n , 0.0);
+    }
+
+    void add(double x , double y){
+        double pw = 1.0;
+        for (int k = 0; k < n; ++k){
+            moments[k] += pw;
+            xty[k] += pw * y;
+            pw *= x;
+        }
+        for (int k = n; k < 2 * n - 1; ++k){
+            moments[k] += pw;
+            pw *= x;
+        }
+        ++count;
+    }
+
+    void merge(const NormalEquations& other){
+        for (int k = 0; k < 2 * n - 1; ++k){
+            moments[k] += other.moments[k];
+        }
+        for (int k = 0; k < n; ++k){
+            xty[k] += other.xty[k];
+        }
+        count += other.count;
+    }
+};
+
+// fitted continuation value at one exercise date
+struct Continuation {
+    int n;
+    bool valid;
+    double beta[MAX_BASIS];
+
+    double operator()(double x) const {
+        double c = beta[n - 1];
+        for (int k = n - 2; k >= 0; --k){
+            c = c * x + beta[k];
+        }
+        return c;
+    }
+};
+
+// gaussian elimination with partial pivoting on the small normal system , too few samples means no exercise at this date
+inline Continuation solve(const NormalEquations& ne){
+    Continuation c;
+    c.n = ne.n;
+    c.valid = false;
+    std::fill(c.beta , c.beta + MAX_BASIS , 0.0);
+    const int n = ne.n;
+    if (ne.count < static_cast<size_t>(n)){
+        return c;
+    }
+
+    double a[MAX_BASIS][MAX_BASIS + 1];
+    for (int i = 0; i < n; ++i){
+        for (int j = 0; j < n; ++j){
+            a[i][j] = ne.moments[i + j];
+        }
+        a[i][n] = ne.xty[i];
+    }
+    // tiny ridge keeps a degenerate sample (all ITM paths at one spot) solvable
+    for (int i = 0; i < n; ++i){
+        a[i][i] += 1e-12 * (1.0 + a[i][i]);
+    }
+
+    for (int col = 0; col < n; ++col){
+        int pivot = col;
+        for (int row = col + 1; row < n; ++row){
+            if (std::abs(a[row][col]) > std::abs(a[pivot][col])){
+                pivot = row;
+            }
+        }
+        if (a[pivot][col] == 0.0){
+            return c;
+        }
+        if (pivot != col){
+            for (int j = col; j <= n; ++j){
+                std::swap(a[col][j] , a[pivot][j]);
+            }
+        }
+        for (int row = col + 1; row < n; ++row){
+            double f = a[row][col] / a[col][col];
+            for (int j = col; j <= n; ++j){
+                a[row][j] -= f * a[col][j];
+            }
+        }
+    }
+    for (int i = n - 1; i >= 0; --i){
+        double sum = a[i][n];
+        for (int j = i + 1; j < n; ++j){
+            sum -= a[i][j] * c.beta[j];
+        }
+        c.beta[i] = sum / a[i][i];
+    }
+    c.valid = true;
+    return c;
+}
+
+} // namespace lsmc
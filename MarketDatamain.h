@@ -10,7 +10,7 @@ struct MarketData{
     double volatility_;
     double dividend_;
 
-    MarketData(double spot , double rate , double volatility , double dividend = 0.0) : spot_(spot) , rate_(rate) , volatility_(volatility_) , dividend_(dividend)
+    MarketData(double spot , double rate , double volatility , double dividend = 0.0) : spot_(spot) , rate_(rate) , volatility_(volatility) , dividend_(dividend)
     {
         if (spot_ <= 0.0 || !std::isfinite(spot_)){
             throw std::invalid_argument("spot must be finite and positive");
@@ -27,4 +27,9 @@ struct MarketData{
       
     }
 
+    // no validation , for rows already checked in bulk (Ingest.h) , never throws
+    struct Unchecked {};
+    MarketData(Unchecked , double spot , double rate , double volatility , double dividend) :
+                    spot_(spot) , rate_(rate) , volatility_(volatility) , dividend_(dividend){}
+
 };
\ No newline at end of file
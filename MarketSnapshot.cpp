@@ -0,0 +1,86 @@
+#include "MarketSnapshot.h"
+
+ExpiryTerms make_expiry_terms(const MarketData& marketdata , double expiry){
+    if (!std::isfinite(expiry) || expiry <= 0.0){
+        throw std::invalid_argument("expiry must be positive and finite");
+    }
+    ExpiryTerms t;
+    t.expiry = expiry;
+    t.sqrt_t = std::sqrt(expiry);
+    t.discount = std::exp(-marketdata.rate_ * expiry);
+    t.dividend_discount = std::exp(-marketdata.dividend_ * expiry);
+    t.forward = marketdata.spot_ * t.dividend_discount / t.discount;
+    t.sigma_sqrt_t = marketdata.volatility_ * t.sqrt_t;
+    return t;
+}
+
+
+const ExpiryTerms& MarketSnapshot::Underlying::terms(double expiry){
+    auto it = terms_.find(expiry);
+    if (it == terms_.end()){
+        it = terms_.emplace(expiry , make_expiry_terms(market_ , expiry)).first;
+    }
+    return it->second;
+}
+
+void MarketSnapshot::Underlying::update(const MarketData& marketdata){
+    const bool curves = marketdata.rate_ != market_.rate_ || marketdata.dividend_ != market_.dividend_;
+    const bool vol = marketdata.volatility_ != market_.volatility_;
+    market_ = marketdata;
+    ++version_;
+
+    for (auto& entry : terms_){
+        ExpiryTerms& t = entry.second;
+        if (curves){
+            t = make_expiry_terms(market_ , t.expiry);
+            continue;
+        }
+        t.forward = market_.spot_ * t.dividend_discount / t.discount;
+        if (vol){
+            t.sigma_sqrt_t = market_.volatility_ * t.sqrt_t;
+        }
+    }
+}
+
+
+MarketSnapshot::Underlying& MarketSnapshot::set(const std::string& name , const MarketData& marketdata){
+    auto it = underlyings_.find(name);
+    if (it == underlyings_.end()){
+        return underlyings_.emplace(name , Underlying(marketdata)).first->second;
+    }
+    it->second.update(marketdata);
+    return it->second;
+}
+
+MarketSnapshot::Underlying& MarketSnapshot::set_spot(const std::string& name , double spot){
+    Underlying& u = get(name);
+    const MarketData& m = u.market();
+    u.update(MarketData(spot , m.rate_ , m.volatility_ , m.dividend_));
+    return u;
+}
+
+MarketSnapshot::Underlying& MarketSnapshot::get(const std::string& name){
+    Underlying* u = find(name);
+    if (!u){
+        throw std::invalid_argument("unknown underlying " + name);
+    }
+    return *u;
+}
+
+const MarketSnapshot::Underlying& MarketSnapshot::get(const std::string& name) const {
+    const Underlying* u = find(name);
+    if (!u){
+        throw std::invalid_argument("unknown underlying " + name);
+    }
+    return *u;
+}
+
+MarketSnapshot::Underlying* MarketSnapshot::find(const std::string& name){
+    auto it = underlyings_.find(name);
+    return it == underlyings_.end() ? nullptr : &it->second;
+}
+
+const MarketSnapshot::Underlying* MarketSnapshot::find(const std::string& name) const {
+    auto it = underlyings_.find(name);
+    return it == underlyings_.end() ? nullptr : &it->second;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "MarketDatamain.h"
+
+// what every contract on one (underlying , expiry) shares , computed once per expiry instead of once per price()
+struct ExpiryTerms {
+    double expiry;
+    double sqrt_t;
+    double discount;            // e^-rT
+    double dividend_discount;   // e^-qT
+    double forward;             // S e^((r-q)T)
+    double sigma_sqrt_t;
+};
+
+ExpiryTerms make_expiry_terms(const MarketData& marketdata , double expiry);
+
+/*
+ * Market data store with one entry per underlying , for repricing whole books on every tick
+ * - each Underlying keeps its MarketData (validated once , when it is set) and an ExpiryTerms per expiry seen,
+ *   filled on first lookup and handed out by reference to the pricers
+ * - set() on an existing underlying refreshes its cached expiries in place: a spot move only rescales the forwards,
+ *   the exponentials are recomputed only when rate or dividend change
+ * - references to an Underlying and its ExpiryTerms stay valid until that underlying is erased
+ * - not thread safe , one writer updates the snapshot between pricing passes
+ */
+class MarketSnapshot {
+
+public:
+    class Underlying {
+
+    public:
+        explicit Underlying(const MarketData& marketdata) : market_(marketdata){}
+
+        const MarketData& market() const {return market_;}
+
+        // bumped on every update , lets callers tell whether anything they priced off has moved
+        uint64_t version() const {return version_;}
+
+        // cached terms of `expiry` , computed on the first lookup
+        const ExpiryTerms& terms(double expiry);
+
+        size_t expiries() const {return terms_.size();}
+
+    private:
+        friend class MarketSnapshot;
+
+        void update(const MarketData& marketdata);
+
+        MarketData market_;
+        uint64_t version_ = 0;
+        std::unordered_map<double , ExpiryTerms> terms_;
+    };
+
+    // insert a new underlying or update an existing one
+    Underlying& set(const std::string& name , const MarketData& marketdata);
+
+    // spot only tick , keeps rate , volatility and dividend
+    Underlying& set_spot(const std::string& name , double spot);
+
+    // throws std::invalid_argument for an unknown name
+    Underlying& get(const std::string& name);
+    const Underlying& get(const std::string& name) const;
+
+    // nullptr for an unknown name
+    Underlying* find(const std::string& name);
+    const Underlying* find(const std::string& name) const;
+
+    bool erase(const std::string& name) {return underlyings_.erase(name) > 0;}
+    void clear() {underlyings_.clear();}
+    size_t size() const {return underlyings_.size();}
+
+private:
+    std::unordered_map<std::string , Underlying> underlyings_;
+};
@@ -0,0 +1,399 @@
+#include "MemoCache.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+const uint32_t NONE = 0xffffffffu;
+
+uint64_t bits(double x){
+    uint64_t u;
+    std::memcpy(&u , &x , sizeof(u));
+    return u;
+}
+
+CachedModel::Key make_key(double K , double T , Option::Type type , const MarketData& marketdata , uint64_t version){
+    return CachedModel::Key{K , T , marketdata.spot_ , marketdata.rate_ , marketdata.volatility_ , marketdata.dividend_ ,
+                            version , type};
+}
+
+uint64_t mix(uint64_t h , uint64_t x){
+    h ^= x + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+// splitmix64 finalizer over the combined words , the shard takes the high bits and the bucket the low ones
+uint64_t hash(const CachedModel::Key& k){
+    uint64_t h = static_cast<uint64_t>(k.type);
+    for (uint64_t x : {bits(k.strike) , bits(k.expiry) , bits(k.spot) , bits(k.rate) , bits(k.volatility) ,
+                       bits(k.dividend) , k.version}){
+        h = mix(h , x);
+    }
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+bool same(const CachedModel::Key& a , const CachedModel::Key& b){
+    return bits(a.strike) == bits(b.strike) && bits(a.expiry) == bits(b.expiry) && bits(a.spot) == bits(b.spot) &&
+           bits(a.rate) == bits(b.rate) && bits(a.volatility) == bits(b.volatility) &&
+           bits(a.dividend) == bits(b.dividend) && a.version == b.version && a.type == b.type;
+}
+
+size_t round_up(size_t n){
+    size_t c = 1;
+    while (c < n){
+        c <<= 1;
+    }
+    return c;
+}
+
+// the greeks a Valuation request asks for , the others left at 0
+Greeks masked(const Greeks& g , unsigned request){
+    Greeks out;
+    out.delta = request & Valuation::DELTA ? g.delta : 0.0;
+    out.gamma = request & Valuation::GAMMA ? g.gamma : 0.0;
+    out.vega = request & Valuation::VEGA ? g.vega : 0.0;
+    out.theta = request & Valuation::THETA ? g.theta : 0.0;
+    out.rho = request & Valuation::RHO ? g.rho : 0.0;
+    return out;
+}
+
+const MarketData& row(const MarketData& marketdata , size_t){return marketdata;}
+const MarketData& row(const MarketData* marketdata , size_t i){return marketdata[i];}
+
+} // namespace
+
+struct CachedModel::Node {
+    Key key;
+    uint64_t hash;
+    double price;
+    Greeks greeks;
+    bool has_price;
+    bool has_greeks;
+    uint32_t prev;      // towards the most recently used
+    uint32_t next;      // towards the least recently used
+    uint32_t chain;     // next node in the same bucket
+};
+
+struct alignas(64) CachedModel::Shard {
+    std::mutex lock;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> buckets;
+    uint32_t head = NONE;       // most recently used
+    uint32_t tail = NONE;       // least recently used
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    uint32_t& bucket(uint64_t hash){return buckets[hash & (buckets.size() - 1)];}
+
+    uint32_t find(const Key& k , uint64_t hash){
+        for (uint32_t n = bucket(hash); n != NONE; n = nodes[n].chain){
+            if (nodes[n].hash == hash && same(nodes[n].key , k)){
+                return n;
+            }
+        }
+        return NONE;
+    }
+
+    void unlink(uint32_t n){
+        Node& node = nodes[n];
+        (node.prev != NONE ? nodes[node.prev].next : head) = node.next;
+        (node.next != NONE ? nodes[node.next].prev : tail) = node.prev;
+    }
+
+    void push_front(uint32_t n){
+        nodes[n].prev = NONE;
+        nodes[n].next = head;
+        (head != NONE ? nodes[head].prev : tail) = n;
+        head = n;
+    }
+
+    void touch(uint32_t n){
+        if (head != n){
+            unlink(n);
+            push_front(n);
+        }
+    }
+
+    void unchain(uint32_t n){
+        uint32_t* link = &bucket(nodes[n].hash);
+        while (*link != n){
+            link = &nodes[*link].chain;
+        }
+        *link = nodes[n].chain;
+    }
+};
+
+CachedModel::CachedModel(const PricingModel& model , const Config& config) : model_(model) , config_(config) , version_(0){
+    if (config_.shards == 0){
+        throw std::invalid_argument("CachedModel needs at least one shard");
+    }
+    const size_t shards = round_up(config_.shards);
+    // a full bucket array is at most twice the entries , rounded up to a power of two
+    const size_t per_entry = sizeof(Node) + 2 * sizeof(uint32_t);
+    capacity_ = std::min<size_t>(config_.max_bytes / shards / per_entry , NONE - 1);
+    if (capacity_ == 0){
+        throw std::invalid_argument("max_bytes must leave room for one entry per shard");
+    }
+    for (size_t s = 0; s < shards; ++s){
+        shards_.emplace_back(new Shard());
+        shards_.back()->buckets.assign(round_up(capacity_) , NONE);
+    }
+}
+
+CachedModel::~CachedModel() = default;
+
+CachedModel::Shard& CachedModel::shard(uint64_t hash) const {
+    return *shards_[(hash >> 40) & (shards_.size() - 1)];
+}
+
+bool CachedModel::lookup(const Key& k , uint64_t hash , double* price , Greeks* greeks) const {
+    Shard& s = shard(hash);
+    std::lock_guard<std::mutex> guard(s.lock);
+    const uint32_t n = s.find(k , hash);
+    if (n == NONE || (price != nullptr && !s.nodes[n].has_price) || (greeks != nullptr && !s.nodes[n].has_greeks)){
+        ++s.misses;
+        return false;
+    }
+    const Node& node = s.nodes[n];
+    if (price != nullptr){
+        *price = node.price;
+    }
+    if (greeks != nullptr){
+        *greeks = node.greeks;
+    }
+    s.touch(n);
+    ++s.hits;
+    return true;
+}
+
+void CachedModel::insert(const Key& k , uint64_t hash , const double* price , const Greeks* greeks) const {
+    Shard& s = shard(hash);
+    std::lock_guard<std::mutex> guard(s.lock);
+    uint32_t n = s.find(k , hash);
+    if (n != NONE){
+        s.touch(n);
+    }
+    else {
+        if (s.nodes.size() < capacity_){
+            // grown by hand so the array never holds more than capacity_ nodes
+            if (s.nodes.size() == s.nodes.capacity()){
+                s.nodes.reserve(std::min(capacity_ , std::max<size_t>(64 , 2 * s.nodes.size())));
+            }
+            n = static_cast<uint32_t>(s.nodes.size());
+            s.nodes.emplace_back();
+        }
+        else {
+            n = s.tail;
+            s.unlink(n);
+            s.unchain(n);
+            ++s.evictions;
+        }
+        Node& node = s.nodes[n];
+        node.key = k;
+        node.hash = hash;
+        node.has_price = false;
+        node.has_greeks = false;
+        uint32_t& head = s.bucket(hash);
+        node.chain = head;
+        head = n;
+        s.push_front(n);
+    }
+    Node& node = s.nodes[n];
+    if (price != nullptr){
+        node.price = *price;
+        node.has_price = true;
+    }
+    if (greeks != nullptr){
+        node.greeks = *greeks;
+        node.has_greeks = true;
+    }
+}
+
+double CachedModel::price(const Option& option , const MarketData& marketdata) const {
+    const Key k = make_key(option.strike_ , option.expiry_ , option.type_ , marketdata , version());
+    const uint64_t h = hash(k);
+    double value;
+    if (!lookup(k , h , &value , nullptr)){
+        value = model_.price(option , marketdata);
+        insert(k , h , &value , nullptr);
+    }
+    return value;
+}
+
+Greeks CachedModel::greeks(const Option& option , const MarketData& marketdata) const {
+    const Key k = make_key(option.strike_ , option.expiry_ , option.type_ , marketdata , version());
+    const uint64_t h = hash(k);
+    Greeks g;
+    if (!lookup(k , h , nullptr , &g)){
+        g = model_.greeks(option , marketdata);
+        insert(k , h , nullptr , &g);
+    }
+    return g;
+}
+
+Valuation CachedModel::evaluate(const Option& option , const MarketData& marketdata , unsigned request) const {
+    if (request & ~(Valuation::PRICE | Valuation::GREEKS)){
+        return model_.evaluate(option , marketdata , request);
+    }
+    const bool want_price = (request & Valuation::PRICE) != 0;
+    const bool want_greeks = (request & Valuation::GREEKS) != 0;
+    Valuation v;
+    if (!want_price && !want_greeks){
+        return v;
+    }
+    const Key k = make_key(option.strike_ , option.expiry_ , option.type_ , marketdata , version());
+    const uint64_t h = hash(k);
+    Greeks g;
+    if (!lookup(k , h , want_price ? &v.price : nullptr , want_greeks ? &g : nullptr)){
+        // all five greeks whenever any is asked for , so the entry serves any later mask
+        const Valuation full = model_.evaluate(option , marketdata , (want_price ? Valuation::PRICE : 0u) |
+                                                                      (want_greeks ? Valuation::GREEKS : 0u));
+        v.price = full.price;
+        g = full.greeks;
+        insert(k , h , want_price ? &v.price : nullptr , want_greeks ? &g : nullptr);
+    }
+    v.greeks = masked(g , request);
+    return v;
+}
+
+Sensitivities CachedModel::sensitivities(const Option& option , const MarketData& marketdata) const {
+    return model_.sensitivities(option , marketdata);
+}
+
+template <typename Market>
+void CachedModel::price_rows(const OptionBatch& batch , const Market& market , double* out) const {
+    const uint64_t v = version();
+    std::vector<size_t> missed;
+    for (size_t i = 0; i < batch.size(); ++i){
+        const Key k = make_key(batch.strike_[i] , batch.expiry_[i] , batch.type_[i] , row(market , i) , v);
+        if (!lookup(k , hash(k) , &out[i] , nullptr)){
+            missed.push_back(i);
+        }
+    }
+    if (missed.empty()){
+        return;
+    }
+    const size_t m = missed.size();
+    std::vector<double> strike(m) , expiry(m) , priced(m);
+    std::vector<Option::Type> type(m);
+    for (size_t j = 0; j < m; ++j){
+        strike[j] = batch.strike_[missed[j]];
+        expiry[j] = batch.expiry_[missed[j]];
+        type[j] = batch.type_[missed[j]];
+    }
+    const OptionBatch rest(strike.data() , expiry.data() , type.data() , m);
+    if constexpr (std::is_pointer<Market>::value){
+        std::vector<MarketData> markets;
+        markets.reserve(m);
+        for (size_t i : missed){
+            markets.push_back(market[i]);
+        }
+        model_.price_batch(rest , markets.data() , priced.data());
+    }
+    else {
+        model_.price_batch(rest , market , priced.data());
+    }
+    for (size_t j = 0; j < m; ++j){
+        const size_t i = missed[j];
+        out[i] = priced[j];
+        const Key k = make_key(strike[j] , expiry[j] , type[j] , row(market , i) , v);
+        insert(k , hash(k) , &priced[j] , nullptr);
+    }
+}
+
+template <typename Market>
+void CachedModel::greeks_rows(const OptionBatch& batch , const Market& market , const GreeksBatch& out) const {
+    const uint64_t v = version();
+    std::vector<size_t> missed;
+    for (size_t i = 0; i < batch.size(); ++i){
+        const Key k = make_key(batch.strike_[i] , batch.expiry_[i] , batch.type_[i] , row(market , i) , v);
+        Greeks g;
+        if (lookup(k , hash(k) , nullptr , &g)){
+            store(g , out , i);
+        }
+        else {
+            missed.push_back(i);
+        }
+    }
+    if (missed.empty()){
+        return;
+    }
+    const size_t m = missed.size();
+    std::vector<double> strike(m) , expiry(m) , columns(5 * m);
+    std::vector<Option::Type> type(m);
+    for (size_t j = 0; j < m; ++j){
+        strike[j] = batch.strike_[missed[j]];
+        expiry[j] = batch.expiry_[missed[j]];
+        type[j] = batch.type_[missed[j]];
+    }
+    const OptionBatch rest(strike.data() , expiry.data() , type.data() , m);
+    const GreeksBatch found(columns.data() , columns.data() + m , columns.data() + 2 * m , columns.data() + 3 * m ,
+                            columns.data() + 4 * m);
+    if constexpr (std::is_pointer<Market>::value){
+        std::vector<MarketData> markets;
+        markets.reserve(m);
+        for (size_t i : missed){
+            markets.push_back(market[i]);
+        }
+        model_.greeks_batch(rest , markets.data() , found);
+    }
+    else {
+        model_.greeks_batch(rest , market , found);
+    }
+    for (size_t j = 0; j < m; ++j){
+        const size_t i = missed[j];
+        Greeks g;
+        g.delta = found.delta[j];
+        g.gamma = found.gamma[j];
+        g.vega = found.vega[j];
+        g.theta = found.theta[j];
+        g.rho = found.rho[j];
+        store(g , out , i);
+        const Key k = make_key(strike[j] , expiry[j] , type[j] , row(market , i) , v);
+        insert(k , hash(k) , nullptr , &g);
+    }
+}
+
+void CachedModel::price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const {
+    price_rows(batch , marketdata , out);
+}
+
+void CachedModel::price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const {
+    price_rows(batch , marketdata , out);
+}
+
+void CachedModel::greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const {
+    greeks_rows(batch , marketdata , out);
+}
+
+void CachedModel::greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const {
+    greeks_rows(batch , marketdata , out);
+}
+
+void CachedModel::clear(){
+    for (std::unique_ptr<Shard>& s : shards_){
+        std::lock_guard<std::mutex> guard(s->lock);
+        s->nodes.clear();
+        std::fill(s->buckets.begin() , s->buckets.end() , NONE);
+        s->head = s->tail = NONE;
+    }
+}
+
+CachedModel::Stats CachedModel::stats() const {
+    Stats out{0 , 0 , 0 , 0 , 0};
+    for (const std::unique_ptr<Shard>& s : shards_){
+        std::lock_guard<std::mutex> guard(s->lock);
+        out.hits += s->hits;
+        out.misses += s->misses;
+        out.evictions += s->evictions;
+        out.entries += s->nodes.size();
+        out.bytes += s->nodes.capacity() * sizeof(Node) + s->buckets.size() * sizeof(uint32_t);
+    }
+    return out;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "PricingMain.h"
+
+/*
+ * Memoized valuations in front of any PricingModel , for books where many consumers price the same contracts
+ * off the same snapshot
+ * - the key is the contract (strike , expiry , type) , the market (spot , rate , volatility , dividend , bit for bit)
+ *   and a version , set_version() ties it to whatever the model reads outside MarketData (a MarketSnapshot::Underlying
+ *   version , a recalibrated curve) so entries of older versions stop matching and age out
+ * - each entry holds the price and the five greeks , filled as they are asked for , a hit costs one hash and a short
+ *   chain walk under the lock of one shard
+ * - Config::shards independently locked shards picked by the key hash , each an LRU list over a fixed bucket array
+ *   and at most max_bytes / shards worth of entries , the least recently used entry is evicted when a shard is full
+ * - nodes live in one array per shard linked by index , so an insert into a warm cache allocates nothing
+ * - misses are priced outside the lock , two threads missing the same key both price it and the second insert wins,
+ *   in the batch calls the missing rows are gathered and priced with one price_batch / greeks_batch of the model
+ * - sensitivities() and evaluate() with second order bits go straight to the model
+ * - the model must be safe to call from several threads at once when the cache is shared
+ */
+
+class CachedModel : public PricingModel {
+
+public:
+    struct Config {
+        size_t max_bytes;       // cap on entries plus bucket arrays , over all shards
+        size_t shards;          // rounded up to a power of two
+
+        Config() : max_bytes(64u << 20) , shards(16){}
+    };
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t entries;
+        size_t bytes;           // nodes and buckets allocated so far
+    };
+
+    // what an entry is stored under , doubles compared bit for bit
+    struct Key {
+        double strike;
+        double expiry;
+        double spot;
+        double rate;
+        double volatility;
+        double dividend;
+        uint64_t version;
+        Option::Type type;
+    };
+
+    explicit CachedModel(const PricingModel& model , const Config& config = Config());
+    ~CachedModel() override;
+
+    double price(const Option& option , const MarketData& marketdata) const override;
+    Greeks greeks(const Option& option , const MarketData& marketdata) const override;
+    Valuation evaluate(const Option& option , const MarketData& marketdata , unsigned request = Valuation::PRICE | Valuation::GREEKS) const override;
+    Sensitivities sensitivities(const Option& option , const MarketData& marketdata) const override;
+
+    void price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const override;
+    void price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const override;
+    void greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const override;
+
+    // entries keyed under another version are never returned again
+    void set_version(uint64_t version){version_.store(version , std::memory_order_release);}
+    uint64_t version() const {return version_.load(std::memory_order_acquire);}
+
+    void clear();
+    Stats stats() const;
+
+    // entries one shard holds at most
+    size_t shard_capacity() const {return capacity_;}
+    size_t shards() const {return shards_.size();}
+    const PricingModel& model() const {return model_;}
+    const Config& config() const {return config_;}
+
+private:
+    struct Node;
+    struct Shard;
+
+    Shard& shard(uint64_t hash) const;
+
+    // false on a miss , found values go to price / greeks when asked for (nullptr = not needed)
+    bool lookup(const Key& k , uint64_t hash , double* price , Greeks* greeks) const;
+    void insert(const Key& k , uint64_t hash , const double* price , const Greeks* greeks) const;
+
+    template <typename Market>
+    void price_rows(const OptionBatch& batch , const Market& market , double* out) const;
+    template <typename Market>
+    void greeks_rows(const OptionBatch& batch , const Market& market , const GreeksBatch& out) const;
+
+    const PricingModel& model_;
+    Config config_;
+    size_t capacity_;
+    std::atomic<uint64_t> version_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
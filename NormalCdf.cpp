@@ -0,0 +1,21 @@
+#include "NormalCdf.h"
+
+// each interval is the cubic through N and n = N' at both ends , in the local coordinate s = (x - x0) * SCALE
+NormalCdfTable NormalCdfTable::build(){
+    NormalCdfTable table;
+    const double h = 1.0 / SCALE;
+    for (int j = 0; j < INTERVALS; ++j){
+        const double x0 = LO + j * h;
+        const double x1 = x0 + h;
+        const double f0 = normal_cdf<CdfAccuracy::EXACT>(x0);
+        const double f1 = normal_cdf<CdfAccuracy::EXACT>(x1);
+        const double m0 = h * 0.3989422804014327 * std::exp(-0.5 * x0 * x0);
+        const double m1 = h * 0.3989422804014327 * std::exp(-0.5 * x1 * x1);
+        double* c = table.cubic[j].c;
+        c[0] = f0;
+        c[1] = m0;
+        c[2] = 3.0 * (f1 - f0) - 2.0 * m0 - m1;
+        c[3] = 2.0 * (f0 - f1) + m0 + m1;
+    }
+    return table;
+}
@@ -0,0 +1,113 @@
+#include "Numa.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// sysfs list format: "0-3,8,10-11"
+std::vector<int> parse_list(const std::string& text){
+    std::vector<int> out;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss , range , ',')){
+        if (range.empty() || range == "\n"){
+            continue;
+        }
+        const size_t dash = range.find('-');
+        const int lo = std::stoi(range.substr(0 , dash));
+        const int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+        for (int i = lo; i <= hi; ++i){
+            out.push_back(i);
+        }
+    }
+    return out;
+}
+
+bool read_list(const std::string& path , std::vector<int>& out){
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !std::getline(file , line)){
+        return false;
+    }
+    try{
+        out = parse_list(line);
+    }
+    catch (const std::exception&){
+        return false;
+    }
+    return !out.empty();
+}
+
+} // namespace
+
+
+NumaTopology::NumaTopology(){
+    std::vector<int> nodes;
+    if (read_list("/sys/devices/system/node/online" , nodes)){
+        for (int node : nodes){
+            std::vector<int> cpus;
+            if (read_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist" , cpus)){
+                cpus_.resize(static_cast<size_t>(node) + 1);
+                cpus_[static_cast<size_t>(node)] = cpus;
+            }
+        }
+    }
+    // memory only nodes keep an empty cpu list , a machine we could not read is one node
+    if (cpus_.empty()){
+        std::vector<int> all;
+        for (unsigned i = 0; i < std::max(1u , std::thread::hardware_concurrency()); ++i){
+            all.push_back(static_cast<int>(i));
+        }
+        cpus_.push_back(all);
+    }
+}
+
+const NumaTopology& NumaTopology::get(){
+    static const NumaTopology topology;
+    return topology;
+}
+
+int NumaTopology::node_of(const void* p) const {
+#if defined(__linux__) && defined(SYS_move_pages)
+    if (nodes() > 1 && p != nullptr){
+        const long page = sysconf(_SC_PAGESIZE);
+        void* pages[1] = {reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(p) & ~static_cast<uintptr_t>(page - 1))};
+        int status[1] = {-1};
+        // nodes = nullptr only reports where each page lives , nothing is moved
+        if (syscall(SYS_move_pages , 0 , 1UL , pages , nullptr , status , 0) == 0 && status[0] >= 0){
+            return status[0];
+        }
+    }
+#else
+    (void)p;
+#endif
+    return -1;
+}
+
+bool NumaTopology::bind_current_thread(size_t node) const {
+#if defined(__linux__)
+    if (node >= nodes() || cpus_[node].empty()){
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus_[node]){
+        CPU_SET(cpu , &set);
+    }
+    return pthread_setaffinity_np(pthread_self() , sizeof(set) , &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
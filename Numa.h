@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+ * NUMA layout of the machine , read once from /sys/devices/system/node on Linux
+ * - no libnuma dependency: cpus per node come from sysfs , the node of a page from the move_pages syscall (query only)
+ * - anywhere else , or when sysfs is missing , the machine is one node holding every cpu and node_of() returns -1
+ */
+
+class NumaTopology {
+
+public:
+    static const NumaTopology& get();
+
+    size_t nodes() const {return cpus_.size();}
+    const std::vector<int>& cpus(size_t node) const {return cpus_[node];}
+
+    // node whose memory holds the page of p , -1 when unknown (page never touched , no NUMA support)
+    int node_of(const void* p) const;
+
+    // restricts the calling thread to the cpus of node , false if the os refused
+    bool bind_current_thread(size_t node) const;
+
+private:
+    NumaTopology();
+
+    std::vector<std::vector<int>> cpus_;
+};
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "OptionMain.h"
+
+/*
+ * - Structure of arrays layout for a book of options
+ * - One contiguous column per contract field so batch pricers loop over plain arrays
+ * - OptionBatch is a non owning view (pointers + size) so callers can also hand in their own columns
+ */
+
+struct OptionBatch {
+    const double* strike_;
+    const double* expiry_;
+    const Option::Type* type_;
+    size_t size_;
+
+    OptionBatch() : strike_(nullptr) , expiry_(nullptr) , type_(nullptr) , size_(0){}
+
+    OptionBatch(const double* strike , const double* expiry , const Option::Type* type , size_t size) :
+                    strike_(strike) , expiry_(expiry) , type_(type) , size_(size){}
+
+    size_t size() const {return size_;}
+
+    Option at(size_t i) const {return Option(strike_[i] , expiry_[i] , type_[i]);}
+
+    // sub range [begin , end) of the same columns, no copy
+    OptionBatch slice(size_t begin , size_t end) const {
+        return OptionBatch(strike_ + begin , expiry_ + begin , type_ + begin , end - begin);
+    }
+};
+
+// caller provided output columns for batch greeks, each must hold batch.size() values
+struct GreeksBatch {
+    double* delta;
+    double* gamma;
+    double* vega;
+    double* theta;
+    double* rho;
+
+    GreeksBatch() : delta(nullptr) , gamma(nullptr) , vega(nullptr) , theta(nullptr) , rho(nullptr){}
+
+    GreeksBatch(double* d , double* g , double* v , double* t , double* r) :
+                    delta(d) , gamma(g) , vega(v) , theta(t) , rho(r){}
+
+    GreeksBatch offset(size_t i) const {return GreeksBatch(delta + i , gamma + i , vega + i , theta + i , rho + i);}
+};
+
+
+class OptionBook {
+
+public:
+    OptionBook() = default;
+
+    void reserve(size_t n){
+        strike_.reserve(n);
+        expiry_.reserve(n);
+        type_.reserve(n);
+    }
+
+    // goes through the Option constructor so every row in the book is validated once on the way in
+    void add(const Option& option){
+        strike_.push_back(option.strike_);
+        expiry_.push_back(option.expiry_);
+        type_.push_back(option.type_);
+    }
+
+    void add(double strike , double expiry , Option::Type type){
+        add(Option(strike , expiry , type));
+    }
+
+    // n rows handed over as columns , already validated in bulk (Ingest.h) so the Option constructor is skipped
+    void add_unchecked(const double* strike , const double* expiry , const Option::Type* type , size_t n){
+        strike_.insert(strike_.end() , strike , strike + n);
+        expiry_.insert(expiry_.end() , expiry , expiry + n);
+        type_.insert(type_.end() , type , type + n);
+    }
+
+    void clear(){
+        strike_.clear();
+        expiry_.clear();
+        type_.clear();
+    }
+
+    size_t size() const {return strike_.size();}
+    bool empty() const {return strike_.empty();}
+
+    Option at(size_t i) const {return Option(strike_[i] , expiry_[i] , type_[i]);}
+
+    OptionBatch batch() const {return OptionBatch(strike_.data() , expiry_.data() , type_.data() , size());}
+
+    const std::vector<double>& strikes() const {return strike_;}
+    const std::vector<double>& expiries() const {return expiry_;}
+    const std::vector<Option::Type>& types() const {return type_;}
+
+private:
+    std::vector<double> strike_;
+    std::vector<double> expiry_;
+    std::vector<Option::Type> type_;
+};
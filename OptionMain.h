@@ -23,6 +23,10 @@ struct Option {
 
     }
 
+    // no validation , for rows already checked in bulk (Ingest.h) , never throws
+    struct Unchecked {};
+    Option(Unchecked , double strike , double expiry , Type type) : strike_(strike) , expiry_(expiry) , type_(type){}
+
 };
 
 struct  Greeks{
@@ -35,4 +39,61 @@ struct  Greeks{
     Greeks() : delta(0) , gamma(0) , vega(0) , theta(0) , rho(0){
 
     }
-};
\ No newline at end of file
+};
+
+// price plus sensitivities from one pass , PricingModel::evaluate fills only what the request mask asks for
+// - vega , rho per 1% move , theta and charm per calendar day
+// - vanna: change in delta per 1% vol , volga: change in vega per 1% vol
+struct Valuation{
+    enum Request : unsigned {
+        PRICE = 1u << 0,
+        DELTA = 1u << 1,
+        GAMMA = 1u << 2,
+        VEGA = 1u << 3,
+        THETA = 1u << 4,
+        RHO = 1u << 5,
+        VANNA = 1u << 6,
+        VOLGA = 1u << 7,
+        CHARM = 1u << 8,
+
+        GREEKS = DELTA | GAMMA | VEGA | THETA | RHO,
+        SECOND_ORDER = VANNA | VOLGA | CHARM,
+        ALL = PRICE | GREEKS | SECOND_ORDER
+    };
+
+    double price;
+    Greeks greeks;
+    double vanna;
+    double volga;
+    double charm;
+
+    Valuation() : price(0) , vanna(0) , volga(0) , charm(0){
+
+    }
+};
+
+// first order derivatives of the price to every market input and to the expiry , raw (not per 1% , not per day)
+// PricingModel::sensitivities bumps by default , the models that tape their pricing (Aad.h) fill it from one adjoint sweep
+struct Sensitivities{
+    double price;
+    double spot;
+    double volatility;
+    double rate;
+    double dividend;
+    double expiry;
+
+    Sensitivities() : price(0) , spot(0) , volatility(0) , rate(0) , dividend(0) , expiry(0){
+
+    }
+
+    // delta , vega , theta , rho in the units of Greeks , gamma is second order and comes from the caller
+    Greeks greeks(double gamma) const {
+        Greeks g;
+        g.delta = spot;
+        g.gamma = gamma;
+        g.vega = volatility / 100.0;
+        g.theta = -expiry / 365.0;
+        g.rho = rate / 100.0;
+        return g;
+    }
+};
@@ -0,0 +1,131 @@
+#include "ParallelPricer.h"
+#include "Numa.h"
+#include "ThreadPool.h"
+#include <stdexcept>
+
+namespace {
+
+// one chunk's partial sums , a cache line each so neighbouring chunks never write the same line
+struct alignas(64) Partial {
+    double sum[6];
+};
+
+} // namespace
+
+
+ParallelPricer::ParallelPricer(const PricingModel& model , const Config& config) : model_(model) , config_(config) , pool_(nullptr){
+    if (config_.chunk_rows == 0){
+        throw std::invalid_argument("chunk_rows must be positive");
+    }
+    if (config_.numa && config_.num_threads != 1){
+        own_pool_ = std::make_shared<ThreadPool>(config_.num_threads , true);
+        pool_ = own_pool_.get();
+        node_workers_.resize(NumaTopology::get().nodes());
+        for (size_t w = 0; w < pool_->size(); ++w){
+            node_workers_[pool_->node(w)].push_back(w);
+        }
+    }
+    else if (config_.num_threads == 0){
+        pool_ = &ThreadPool::global();
+    }
+    else if (config_.num_threads > 1){
+        own_pool_ = std::make_shared<ThreadPool>(config_.num_threads);
+        pool_ = own_pool_.get();
+    }
+}
+
+// fn(chunk , begin , end) for every chunk of the batch
+template <typename F>
+void ParallelPricer::for_chunks(const OptionBatch& batch , const F& fn) const {
+    const size_t rows = batch.size();
+    const size_t chunk = config_.chunk_rows;
+    const size_t chunks = (rows + chunk - 1) / chunk;
+    auto task = [&](size_t k){
+        const size_t begin = k * chunk;
+        fn(k , begin , begin + chunk < rows ? begin + chunk : rows);
+    };
+    if (pool_ == nullptr || chunks <= 1){
+        for (size_t k = 0; k < chunks; ++k){
+            task(k);
+        }
+        return;
+    }
+    if (node_workers_.empty()){
+        pool_->parallel_for(chunks , std::function<void(size_t)>(task));
+        return;
+    }
+    // the worker of a chunk: round robin over the workers of the node its strikes live on , any worker if unknown
+    const NumaTopology& topology = NumaTopology::get();
+    pool_->parallel_for(chunks , std::function<void(size_t)>(task) , [&](size_t k) -> size_t {
+        const int node = topology.node_of(batch.strike_ + k * chunk);
+        if (node < 0 || static_cast<size_t>(node) >= node_workers_.size() || node_workers_[node].empty()){
+            return k;
+        }
+        const std::vector<size_t>& workers = node_workers_[node];
+        return workers[k % workers.size()];
+    });
+}
+
+void ParallelPricer::price_all(const OptionBatch& batch , const MarketData& marketdata , double* out) const {
+    for_chunks(batch , [&](size_t , size_t begin , size_t end){
+        model_.price_batch(batch.slice(begin , end) , marketdata , out + begin);
+    });
+}
+
+void ParallelPricer::price_all(const OptionBatch& batch , const MarketData* marketdata , double* out) const {
+    for_chunks(batch , [&](size_t , size_t begin , size_t end){
+        model_.price_batch(batch.slice(begin , end) , marketdata + begin , out + begin);
+    });
+}
+
+void ParallelPricer::greeks_all(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const {
+    for_chunks(batch , [&](size_t , size_t begin , size_t end){
+        model_.greeks_batch(batch.slice(begin , end) , marketdata , out.offset(begin));
+    });
+}
+
+void ParallelPricer::greeks_all(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const {
+    for_chunks(batch , [&](size_t , size_t begin , size_t end){
+        model_.greeks_batch(batch.slice(begin , end) , marketdata + begin , out.offset(begin));
+    });
+}
+
+ParallelPricer::PortfolioGreeks ParallelPricer::portfolio(const OptionBatch& batch , const MarketData& marketdata , const double* quantity) const {
+    const size_t chunks = (batch.size() + config_.chunk_rows - 1) / config_.chunk_rows;
+    // per call storage , never thread_local: a thread waiting in ThreadPool::run may pick up a nested task
+    // (the model's own chunks , or another portfolio() call) that would overwrite this chunk's slots or scratch
+    std::vector<Partial> partials(chunks , Partial());
+
+    for_chunks(batch , [&](size_t k , size_t begin , size_t end){
+        const size_t n = end - begin;
+        // price column then the five greek columns , owned by this task
+        std::vector<double> scratch(6 * n);
+        double* price = scratch.data();
+        const OptionBatch rows = batch.slice(begin , end);
+        model_.price_batch(rows , marketdata , price);
+        model_.greeks_batch(rows , marketdata , GreeksBatch(price + n , price + 2 * n , price + 3 * n , price + 4 * n , price + 5 * n));
+        Partial p = {};
+        for (size_t i = 0; i < n; ++i){
+            const double q = quantity ? quantity[begin + i] : 1.0;
+            for (int g = 0; g < 6; ++g){
+                p.sum[g] += q * price[g * n + i];
+            }
+        }
+        partials[k] = p;
+    });
+
+    double total[6] = {};
+    for (const Partial& p : partials){
+        for (int g = 0; g < 6; ++g){
+            total[g] += p.sum[g];
+        }
+    }
+    PortfolioGreeks out;
+    out.value = total[0];
+    out.delta = total[1];
+    out.gamma = total[2];
+    out.vega = total[3];
+    out.theta = total[4];
+    out.rho = total[5];
+    return out;
+}
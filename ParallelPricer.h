@@ -0,0 +1,61 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "PricingMain.h"
+
+class ThreadPool;
+
+/*
+ * Whole book pricing on every core for any PricingModel
+ * - the book is cut into chunks of chunk_rows rows (inputs , outputs and kernel scratch of a chunk stay in L2)
+ *   and each chunk is one task of a persistent work-stealing ThreadPool , nothing is started per call
+ * - numa = true prices on a private pool whose workers are bound to NUMA nodes , and each chunk is queued on a worker
+ *   of the node holding its strike column (found with move_pages , so first touch placement by the caller is what counts)
+ * - portfolio() sums quantity weighted value and greeks: every chunk reduces into its own cache line sized slot,
+ *   the slots are then added in chunk order , so there is no false sharing and the total does not depend on scheduling
+ * - the model must be safe to call from several threads at once (BlackScholes , BinomialTree and LSMC are)
+ */
+
+class ParallelPricer {
+
+public:
+    struct Config {
+        size_t chunk_rows;
+        size_t num_threads;     // 0 = shared pool over every core (own pool over every core with numa) , 1 = calling thread only
+        bool numa;
+
+        Config() : chunk_rows(2048) , num_threads(0) , numa(false){}
+    };
+
+    struct PortfolioGreeks {
+        double value;
+        double delta;
+        double gamma;
+        double vega;
+        double theta;
+        double rho;
+    };
+
+    explicit ParallelPricer(const PricingModel& model , const Config& config = Config());
+
+    // same results , same layout as the model's price_batch / greeks_batch
+    void price_all(const OptionBatch& batch , const MarketData& marketdata , double* out) const;
+    void price_all(const OptionBatch& batch , const MarketData* marketdata , double* out) const;
+    void greeks_all(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const;
+    void greeks_all(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const;
+
+    // sum over rows of quantity[i] * (price , greeks) of row i , quantity = nullptr weighs every row 1
+    PortfolioGreeks portfolio(const OptionBatch& batch , const MarketData& marketdata , const double* quantity = nullptr) const;
+
+    const Config& config() const {return config_;}
+
+private:
+    const PricingModel& model_;
+    Config config_;
+    std::shared_ptr<ThreadPool> own_pool_;
+    ThreadPool* pool_;
+    std::vector<std::vector<size_t>> node_workers_;     // numa only: the pool workers bound to each node
+
+    template <typename F>
+    void for_chunks(const OptionBatch& batch , const F& fn) const;
+};
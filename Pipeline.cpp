@@ -0,0 +1,131 @@
+#include "Pipeline.h"
+#include "Ingest.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+bool pin_current_thread(int cpu){
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu , &set);
+    return pthread_setaffinity_np(pthread_self() , sizeof(set) , &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+void pipeline_backoff(size_t& spins , size_t spin_limit){
+    if (spins < spin_limit){
+        ++spins;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+        return;
+    }
+    std::this_thread::yield();
+}
+
+ChainPipeline::ChainPipeline(const OptionBatch& chain , Publish publish , const Config& config , Decode decode) :
+                    chain_(chain) , config_(config) , submitted_(0) , returned_(0){
+    if (config_.ticks == 0){
+        throw std::invalid_argument("ChainPipeline needs at least one tick");
+    }
+    // every tick fits in every ring , so the last stage never waits on a caller that is not acquiring
+    config_.pipeline.queue_capacity = std::max(config_.pipeline.queue_capacity , config_.ticks);
+
+    const size_t n = chain_.size();
+    ticks_.resize(config_.ticks);
+    for (ChainTick& t : ticks_){
+        t.sequence = 0;
+        t.spot = t.rate = t.dividend = 0.0;
+        t.valid = false;
+        for (std::vector<double>* column : {&t.quotes , &t.vol , &t.delta , &t.gamma , &t.vega , &t.theta , &t.rho}){
+            column->assign(n , 0.0);
+        }
+        t.markets.assign(n , MarketData(MarketData::Unchecked{} , 0.0 , 0.0 , 0.0 , 0.0));
+        free_.push_back(&t);
+    }
+
+    std::vector<Pipeline<ChainTick>::Stage> stages;
+    if (decode){
+        stages.push_back(std::move(decode));
+    }
+    // same rules as the MarketData constructor , the volatility is the chain's to find so any valid one stands in
+    stages.push_back([](ChainTick& t){
+        const MarketRecord record{t.spot , t.rate , 1.0 , t.dividend};
+        uint64_t error = 0;
+        t.valid = validate(&record , 1 , &error) == 0;
+    });
+    stages.push_back([this](ChainTick& t){
+        if (!t.valid){
+            std::fill(t.vol.begin() , t.vol.end() , std::numeric_limits<double>::quiet_NaN());
+            return;
+        }
+        const MarketData market(MarketData::Unchecked{} , t.spot , t.rate , 1.0 , t.dividend);
+        config_.model.implied_vol_batch(chain_ , market , t.quotes.data() , t.vol.data());
+    });
+    stages.push_back([this](ChainTick& t){
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const size_t rows = chain_.size();
+        for (size_t i = 0; i < rows; ++i){
+            // a vol of 0 (quote at intrinsic) has no greeks either , priced at 1 and blanked below
+            const double sigma = t.vol[i] > 0.0 ? t.vol[i] : 1.0;
+            t.markets[i] = MarketData(MarketData::Unchecked{} , t.spot , t.rate , sigma , t.dividend);
+        }
+        config_.model.greeks_batch(chain_ , t.markets.data() , GreeksBatch(t.delta.data() , t.gamma.data() , t.vega.data() ,
+                                                                          t.theta.data() , t.rho.data()));
+        for (size_t i = 0; i < rows; ++i){
+            if (!(t.vol[i] > 0.0)){
+                t.delta[i] = t.gamma[i] = t.vega[i] = t.theta[i] = t.rho[i] = nan;
+            }
+        }
+    });
+    stages.push_back([publish](ChainTick& t){publish(t);});
+
+    pipeline_.reset(new Pipeline<ChainTick>(std::move(stages) , config_.pipeline));
+}
+
+ChainPipeline::~ChainPipeline() = default;
+
+ChainTick* ChainPipeline::try_acquire(){
+    if (free_.empty()){
+        ChainTick* done = pipeline_->try_pop();
+        if (done == nullptr){
+            return nullptr;
+        }
+        ++returned_;
+        return done;
+    }
+    ChainTick* t = free_.back();
+    free_.pop_back();
+    return t;
+}
+
+ChainTick* ChainPipeline::acquire(){
+    if (free_.empty()){
+        ++returned_;
+        return pipeline_->pop();
+    }
+    return try_acquire();
+}
+
+void ChainPipeline::submit(ChainTick* tick){
+    ++submitted_;
+    pipeline_->push(tick);
+}
+
+void ChainPipeline::drain(){
+    while (returned_ < submitted_){
+        free_.push_back(pipeline_->pop());
+        ++returned_;
+    }
+}
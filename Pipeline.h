@@ -0,0 +1,290 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "BlackScholesmain.h"
+#include "LatencyHistogram.h"
+
+/*
+ * Streaming stage pipelines for feed driven pricing
+ * - SpscRing: bounded lock free single producer / single consumer ring , head and tail on their own cache lines and
+ *   each side caching the other's index , so a push or pop touches shared memory only when the ring looks full / empty
+ * - Pipeline<T>: every stage is a function on T& running on its own thread (pinned to Config::cpus when given),
+ *   consecutive stages are joined by SpscRings of T* , items come out of the last stage in the order they went in
+ * - backpressure: a stage whose next ring is full waits (counted in its stalls) , so a slow stage fills the rings behind
+ *   it and try_push() at the head fails instead of queueing without bound
+ * - waiting spins Config::spin times and then yields , spin should be 0 on a machine with fewer cores than stages
+ * - per stage service time histograms , plus the end to end (push to out of the last stage) latency of every item
+ * - ChainPipeline: an option chain per tick through market (checks the quote's spot , rate , dividend) ,
+ *   implied vol (BlackScholes::implied_vol_batch of the option quotes) , greeks (greeks_batch at the implied vols)
+ *   and publish (the caller's callback) , on a fixed pool of ticks , nothing is allocated per tick
+ */
+
+// restricts the calling thread to one cpu , false if the os refused or cannot (not Linux)
+bool pin_current_thread(int cpu);
+
+// one step of a spin then yield wait
+void pipeline_backoff(size_t& spins , size_t spin_limit);
+
+inline uint64_t pipeline_now_ns(){
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+template <typename T>
+class SpscRing {
+
+public:
+    // capacity rounds up to a power of two
+    explicit SpscRing(size_t capacity) : tail_(0) , head_cache_(0) , head_(0) , tail_cache_(0) ,
+                                         mask_(round_up(capacity) - 1) , slots_(new T[mask_ + 1]){}
+
+    // producer thread only
+    bool try_push(const T& value){
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_cache_ > mask_){
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (t - head_cache_ > mask_){
+                return false;
+            }
+        }
+        slots_[t & mask_] = value;
+        tail_.store(t + 1 , std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only
+    bool try_pop(T& out){
+        const size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_cache_){
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_){
+                return false;
+            }
+        }
+        out = slots_[h & mask_];
+        head_.store(h + 1 , std::memory_order_release);
+        return true;
+    }
+
+    // exact from either end when the other side is idle , a snapshot otherwise
+    size_t size() const {return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);}
+    bool empty() const {return size() == 0;}
+    size_t capacity() const {return mask_ + 1;}
+
+private:
+    static size_t round_up(size_t n){
+        size_t c = 1;
+        while (c < n){
+            c <<= 1;
+        }
+        return c;
+    }
+
+    alignas(64) std::atomic<size_t> tail_;      // producer's line
+    size_t head_cache_;
+    alignas(64) std::atomic<size_t> head_;      // consumer's line
+    size_t tail_cache_;
+    alignas(64) const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+};
+
+struct PipelineConfig {
+    size_t queue_capacity;     // items each ring between stages holds
+    size_t spin;               // spins before a waiting thread starts yielding
+    std::vector<int> cpus;     // stage i runs on cpus[i % cpus.size()] , empty = not pinned
+
+    PipelineConfig() : queue_capacity(64) , spin(4096){}
+};
+
+struct StageStats {
+    LatencyHistogram service;           // ns in the stage function per item
+    std::atomic<uint64_t> stalls{0};    // items that waited for room in the next ring
+};
+
+template <typename T>
+class Pipeline {
+
+public:
+    using Stage = std::function<void(T&)>;
+
+    Pipeline(std::vector<Stage> stages , const PipelineConfig& config = PipelineConfig()) :
+                    config_(config) , stages_(std::move(stages)) , stats_(new StageStats[stages_.size()]) ,
+                    busy_(new std::atomic<bool>[stages_.size()]) , running_(true){
+        if (stages_.empty()){
+            throw std::invalid_argument("Pipeline needs at least one stage");
+        }
+        for (size_t i = 0; i <= stages_.size(); ++i){
+            rings_.emplace_back(new SpscRing<Slot>(config_.queue_capacity));
+        }
+        for (size_t i = 0; i < stages_.size(); ++i){
+            busy_[i].store(true , std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < stages_.size(); ++i){
+            threads_.emplace_back([this , i]{run(i);});
+        }
+    }
+
+    ~Pipeline(){stop();}
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // producer thread only: false when the first ring is full (the pipeline is pushing back)
+    bool try_push(T* item){return rings_.front()->try_push(Slot{item , pipeline_now_ns()});}
+
+    void push(T* item){
+        const Slot slot{item , pipeline_now_ns()};
+        size_t spins = 0;
+        while (!rings_.front()->try_push(slot)){
+            pipeline_backoff(spins , config_.spin);
+        }
+    }
+
+    // consumer thread only: the next item out of the last stage , nullptr when none is ready
+    T* try_pop(){
+        Slot slot;
+        return rings_.back()->try_pop(slot) ? slot.item : nullptr;
+    }
+
+    T* pop(){
+        Slot slot;
+        size_t spins = 0;
+        while (!rings_.back()->try_pop(slot)){
+            pipeline_backoff(spins , config_.spin);
+        }
+        return slot.item;
+    }
+
+    // lets every item already pushed through (the output ring must have room for them) and joins the stages
+    void stop(){
+        running_.store(false , std::memory_order_release);
+        for (std::thread& t : threads_){
+            if (t.joinable()){
+                t.join();
+            }
+        }
+    }
+
+    size_t stages() const {return stages_.size();}
+    const StageStats& stats(size_t stage) const {return stats_[stage];}
+    const LatencyHistogram& end_to_end() const {return end_to_end_;}
+    const PipelineConfig& config() const {return config_;}
+
+private:
+    struct Slot {
+        T* item;
+        uint64_t pushed_ns;
+    };
+
+    void run(size_t i){
+        if (!config_.cpus.empty()){
+            pin_current_thread(config_.cpus[i % config_.cpus.size()]);
+        }
+        SpscRing<Slot>& in = *rings_[i];
+        SpscRing<Slot>& out = *rings_[i + 1];
+        StageStats& stats = stats_[i];
+        const bool last = i + 1 == stages_.size();
+        size_t spins = 0;
+        Slot slot;
+        for (;;){
+            if (!in.try_pop(slot)){
+                // upstream has stopped once running_ is clear and the previous stage has exited
+                if (!running_.load(std::memory_order_acquire) && (i == 0 || !busy_[i - 1].load(std::memory_order_acquire)) && in.empty()){
+                    break;
+                }
+                pipeline_backoff(spins , config_.spin);
+                continue;
+            }
+            spins = 0;
+            const uint64_t start = pipeline_now_ns();
+            stages_[i](*slot.item);
+            const uint64_t done = pipeline_now_ns();
+            stats.service.record(done - start);
+            if (last){
+                end_to_end_.record(done - slot.pushed_ns);
+            }
+            if (!out.try_push(slot)){
+                stats.stalls.fetch_add(1 , std::memory_order_relaxed);
+                size_t wait = 0;
+                while (!out.try_push(slot)){
+                    pipeline_backoff(wait , config_.spin);
+                }
+            }
+        }
+        busy_[i].store(false , std::memory_order_release);
+    }
+
+    PipelineConfig config_;
+    std::vector<Stage> stages_;
+    std::vector<std::unique_ptr<SpscRing<Slot>>> rings_;
+    std::unique_ptr<StageStats[]> stats_;
+    std::unique_ptr<std::atomic<bool>[]> busy_;       // cleared by a stage thread as it exits
+    LatencyHistogram end_to_end_;
+    std::atomic<bool> running_;
+    std::vector<std::thread> threads_;
+};
+
+// one quote update of the whole chain , inputs filled by the caller (or the decode stage) , outputs by the pipeline
+struct ChainTick {
+    uint64_t sequence;
+    double spot;
+    double rate;
+    double dividend;
+    std::vector<double> quotes;         // option prices , one per chain row
+
+    bool valid;                         // market stage: spot , rate , dividend passed the MarketData checks
+    std::vector<double> vol;            // implied vols , NaN where the quote admits none
+    std::vector<double> delta;          // greeks at the implied vol , NaN with it
+    std::vector<double> gamma;
+    std::vector<double> vega;
+    std::vector<double> theta;
+    std::vector<double> rho;
+    std::vector<MarketData> markets;    // per row market at its implied vol , scratch of the greeks stage
+};
+
+class ChainPipeline {
+
+public:
+    struct Config {
+        size_t ticks;                   // ticks in flight at most
+        PipelineConfig pipeline;
+        BlackScholes model;
+
+        Config() : ticks(16) , model(BlackScholes::Kernel::SIMD){}
+    };
+
+    using Decode = std::function<void(ChainTick&)>;
+    using Publish = std::function<void(const ChainTick&)>;
+
+    // chain columns must outlive the pipeline , decode (optional) runs as the first stage
+    ChainPipeline(const OptionBatch& chain , Publish publish , const Config& config = Config() , Decode decode = nullptr);
+    ~ChainPipeline();
+
+    // producer thread only: a free tick to fill , nullptr when all are in flight (backpressure: conflate or retry)
+    ChainTick* try_acquire();
+    ChainTick* acquire();
+    void submit(ChainTick* tick);
+
+    // waits until every submitted tick is published
+    void drain();
+
+    const Pipeline<ChainTick>& pipeline() const {return *pipeline_;}
+    const LatencyHistogram& tick_to_price() const {return pipeline_->end_to_end();}
+    size_t submitted() const {return submitted_;}
+
+private:
+    OptionBatch chain_;
+    Config config_;
+    std::vector<ChainTick> ticks_;
+    std::vector<ChainTick*> free_;
+    size_t submitted_;
+    size_t returned_;
+    std::unique_ptr<Pipeline<ChainTick>> pipeline_;
+};
@@ -0,0 +1,127 @@
+#include "PortfolioEngine.h"
+#include <stdexcept>
+
+PortfolioEngine::PortfolioEngine(const PricingModel& model , MarketSnapshot& snapshot , const Config& config) :
+                    model_(model) , snapshot_(snapshot) , config_(config){
+    if (!(config_.max_move >= 0.0)){
+        throw std::invalid_argument("max_move must be non negative");
+    }
+}
+
+size_t PortfolioEngine::add(const std::string& underlying , const Option& option , double quantity){
+    if (!std::isfinite(quantity)){
+        throw std::invalid_argument("quantity must be finite");
+    }
+    auto it = group_index_.find(underlying);
+    if (it == group_index_.end()){
+        groups_.emplace_back(&snapshot_.get(underlying));
+        it = group_index_.emplace(underlying , groups_.size() - 1).first;
+    }
+
+    Group& g = groups_[it->second];
+    g.book.add(option);
+    g.quantity.push_back(quantity);
+    g.price.push_back(0.0);
+    g.exact_price.push_back(0.0);
+    g.delta.push_back(0.0);
+    g.gamma.push_back(0.0);
+    // a new row has never been priced , so its whole group revalues on the next reprice()
+    g.priced = false;
+
+    positions_.push_back({it->second , g.book.size() - 1});
+    return positions_.size() - 1;
+}
+
+void PortfolioEngine::revalue(Group& g , Stats& stats){
+    const size_t n = g.book.size();
+    const MarketData& m = g.underlying->market();
+    vega_.resize(n);
+    theta_.resize(n);
+    rho_.resize(n);
+
+    model_.price_batch(g.book.batch() , m , g.exact_price.data());
+    model_.greeks_batch(g.book.batch() , m , GreeksBatch(g.delta.data() , g.gamma.data() , vega_.data() , theta_.data() , rho_.data()));
+    g.price = g.exact_price;
+
+    g.reference = m;
+    g.spot = m.spot_;
+    g.version = g.underlying->version();
+    g.priced = true;
+    g.approximated = false;
+    stats.exact_rows += n;
+}
+
+// second order in the spot move from the last exact revaluation , delta and gamma stay at the reference point
+void PortfolioEngine::roll(Group& g , Stats& stats){
+    g.spot = g.underlying->market().spot_;
+    const double dS = g.spot - g.reference.spot_;
+    for (size_t i = 0; i < g.book.size(); ++i){
+        g.price[i] = g.exact_price[i] + g.delta[i] * dS + 0.5 * g.gamma[i] * dS * dS;
+    }
+    g.version = g.underlying->version();
+    g.approximated = true;
+    stats.approximate_rows += g.book.size();
+}
+
+PortfolioEngine::Stats PortfolioEngine::reprice(){
+    Stats stats;
+    for (Group& g : groups_){
+        if (g.priced && g.version == g.underlying->version()){
+            continue;
+        }
+        const MarketData& m = g.underlying->market();
+        const bool spot_only = g.priced && m.rate_ == g.reference.rate_ && m.volatility_ == g.reference.volatility_ &&
+                               m.dividend_ == g.reference.dividend_;
+        if (config_.approximate && spot_only && std::abs(m.spot_ - g.reference.spot_) <= config_.max_move * g.reference.spot_){
+            roll(g , stats);
+        }
+        else{
+            revalue(g , stats);
+        }
+    }
+    return stats;
+}
+
+PortfolioEngine::Stats PortfolioEngine::reprice_all(){
+    Stats stats;
+    for (Group& g : groups_){
+        revalue(g , stats);
+    }
+    return stats;
+}
+
+double PortfolioEngine::value() const {
+    double total = 0.0;
+    for (const Group& g : groups_){
+        for (size_t i = 0; i < g.book.size(); ++i){
+            total += g.quantity[i] * g.price[i];
+        }
+    }
+    return total;
+}
+
+double PortfolioEngine::price(size_t position) const {
+    const Position& p = positions_.at(position);
+    return groups_[p.group].price[p.row];
+}
+
+double PortfolioEngine::delta(size_t position) const {
+    const Position& p = positions_.at(position);
+    const Group& g = groups_[p.group];
+    // delta moves with gamma between exact revaluations
+    return g.delta[p.row] + g.gamma[p.row] * (g.spot - g.reference.spot_);
+}
+
+double PortfolioEngine::gamma(size_t position) const {
+    const Position& p = positions_.at(position);
+    return groups_[p.group].gamma[p.row];
+}
+
+double PortfolioEngine::quantity(size_t position) const {
+    const Position& p = positions_.at(position);
+    return groups_[p.group].quantity[p.row];
+}
+
+bool PortfolioEngine::approximated(size_t position) const {
+    return groups_[positions_.at(position).group].approximated;
+}
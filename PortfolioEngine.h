@@ -0,0 +1,100 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "PricingMain.h"
+#include "MarketSnapshot.h"
+
+/*
+ * Tick driven portfolio repricing
+ * - positions are grouped by underlying , each group is a structure of arrays book priced through the model's batch entry points
+ * - a group depends on exactly one snapshot entry , reprice() compares each entry's version() with the one the group was
+ *   priced at and only touches the groups whose inputs moved
+ * - with approximate = true a spot only move within max_move (relative to the spot of the last exact revaluation)
+ *   is rolled forward by delta/gamma: P + delta dS + 1/2 gamma dS^2 , anything bigger , or any rate / vol / dividend change,
+ *   revalues the group exactly and resets its reference point
+ */
+
+class PortfolioEngine {
+
+public:
+    struct Config {
+        bool approximate;
+        double max_move;
+
+        Config() : approximate(false) , max_move(0.01){}
+    };
+
+    // what the last reprice() call did
+    struct Stats {
+        size_t exact_rows;
+        size_t approximate_rows;
+
+        Stats() : exact_rows(0) , approximate_rows(0){}
+    };
+
+    // model and snapshot must outlive the engine
+    PortfolioEngine(const PricingModel& model , MarketSnapshot& snapshot , const Config& config = Config());
+
+    // the underlying must already be in the snapshot , returns the position id
+    size_t add(const std::string& underlying , const Option& option , double quantity = 1.0);
+
+    // brings every position whose market data changed since the last call up to date
+    Stats reprice();
+
+    // reprices every position exactly , whatever changed
+    Stats reprice_all();
+
+    size_t size() const {return positions_.size();}
+    double value() const;
+
+    // per unit of the position , as of the last reprice()
+    double price(size_t position) const;
+    double delta(size_t position) const;
+    double gamma(size_t position) const;
+    double quantity(size_t position) const;
+
+    // true while the position's price is a Taylor estimate
+    bool approximated(size_t position) const;
+
+private:
+    struct Group {
+        MarketSnapshot::Underlying* underlying;
+        uint64_t version;
+        bool priced;
+        bool approximated;
+        MarketData reference;     // market of the last exact revaluation
+        double spot;              // spot the current prices are at
+
+        OptionBook book;
+        std::vector<double> quantity;
+        std::vector<double> price;
+        std::vector<double> exact_price;
+        std::vector<double> delta;
+        std::vector<double> gamma;
+
+        explicit Group(MarketSnapshot::Underlying* u) : underlying(u) , version(0) , priced(false) , approximated(false) , reference(u->market()) ,
+                                                     spot(u->market().spot_){}
+    };
+
+    struct Position {
+        size_t group;
+        size_t row;
+    };
+
+    void revalue(Group& g , Stats& stats);
+    void roll(Group& g , Stats& stats);
+
+    const PricingModel& model_;
+    MarketSnapshot& snapshot_;
+    Config config_;
+
+    std::vector<Group> groups_;
+    std::unordered_map<std::string , size_t> group_index_;
+    std::vector<Position> positions_;
+
+    // greeks_batch scratch , the engine only keeps delta and gamma
+    std::vector<double> vega_;
+    std::vector<double> theta_;
+    std::vector<double> rho_;
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include "OptionMain.h"
+#include "OptionBook.h"
+#include <algorithm>
 
 
 class PricingModel {
@@ -10,4 +12,74 @@ public:
     virtual double price(const Option& option, const MarketData& marketdata) const = 0;
     virtual Greeks greeks(const Option& option , const MarketData& marketdata) const = 0;
 
-};
\ No newline at end of file
+    // price and greeks together , request is a mask of Valuation::Request bits
+    // default just calls price/greeks , models that share work between them override it
+    virtual Valuation evaluate(const Option& option , const MarketData& marketdata , unsigned request = Valuation::PRICE | Valuation::GREEKS) const {
+        Valuation v;
+        if (request & Valuation::PRICE){
+            v.price = price(option , marketdata);
+        }
+        if (request & Valuation::GREEKS){
+            v.greeks = greeks(option , marketdata);
+        }
+        return v;
+    }
+
+    // d price / d (spot , vol , rate , dividend , expiry) , default is central bumps of price() (two prices per input)
+    // BlackScholes , BinomialTree and LSMC override it with one taped valuation and one adjoint sweep (Aad.h)
+    virtual Sensitivities sensitivities(const Option& option , const MarketData& marketdata) const {
+        const MarketData::Unchecked raw;
+        const double S = marketdata.spot_ , r = marketdata.rate_ , sigma = marketdata.volatility_ , q = marketdata.dividend_;
+        const double hS = 1e-4 * S , h = 1e-4 , hT = std::min(1e-4 , 0.5 * option.expiry_);
+        auto at = [&](double s , double rate , double vol , double div){return price(option , MarketData(raw , s , rate , vol , div));};
+        Sensitivities out;
+        out.price = price(option , marketdata);
+        out.spot = (at(S + hS , r , sigma , q) - at(S - hS , r , sigma , q)) / (2.0 * hS);
+        out.volatility = (at(S , r , sigma + h , q) - at(S , r , sigma - h , q)) / (2.0 * h);
+        out.rate = (at(S , r + h , sigma , q) - at(S , r - h , sigma , q)) / (2.0 * h);
+        out.dividend = (at(S , r , sigma , q + h) - at(S , r , sigma , q - h)) / (2.0 * h);
+        const Option later(Option::Unchecked() , option.strike_ , option.expiry_ + hT , option.type_);
+        const Option earlier(Option::Unchecked() , option.strike_ , option.expiry_ - hT , option.type_);
+        out.expiry = (price(later , marketdata) - price(earlier , marketdata)) / (2.0 * hT);
+        return out;
+    }
+
+    // Batch entry points over a structure of arrays book
+    // - results go into caller provided arrays of batch.size() values, nothing is allocated per call
+    // - shared overload prices every row against one MarketData, per row overload takes marketdata[i] for row i
+    // - defaults just loop over price/greeks so every model supports them, models override to get a tight loop
+
+    virtual void price_batch(const OptionBatch& batch , const MarketData& marketdata , double* out) const {
+        for (size_t i = 0; i < batch.size(); ++i){
+            out[i] = price(batch.at(i) , marketdata);
+        }
+    }
+
+    virtual void price_batch(const OptionBatch& batch , const MarketData* marketdata , double* out) const {
+        for (size_t i = 0; i < batch.size(); ++i){
+            out[i] = price(batch.at(i) , marketdata[i]);
+        }
+    }
+
+    virtual void greeks_batch(const OptionBatch& batch , const MarketData& marketdata , const GreeksBatch& out) const {
+        for (size_t i = 0; i < batch.size(); ++i){
+            store(greeks(batch.at(i) , marketdata) , out , i);
+        }
+    }
+
+    virtual void greeks_batch(const OptionBatch& batch , const MarketData* marketdata , const GreeksBatch& out) const {
+        for (size_t i = 0; i < batch.size(); ++i){
+            store(greeks(batch.at(i) , marketdata[i]) , out , i);
+        }
+    }
+
+protected:
+    static void store(const Greeks& g , const GreeksBatch& out , size_t i){
+        out.delta[i] = g.delta;
+        out.gamma[i] = g.gamma;
+        out.vega[i] = g.vega;
+        out.theta[i] = g.theta;
+        out.rho[i] = g.rho;
+    }
+
+};
@@ -0,0 +1,260 @@
+#include "QuasiRandom.h"
+#include "Random.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Joe & Kuo: degree s , middle coefficients a , initial direction numbers m_1..m_s of dimensions 2..21
+struct Primitive {
+    int s;
+    uint32_t a;
+    uint32_t m[16];
+};
+
+const Primitive JOE_KUO[] = {
+    {1 , 0 , {1}},
+    {2 , 1 , {1 , 3}},
+    {3 , 1 , {1 , 3 , 1}},
+    {3 , 2 , {1 , 1 , 1}},
+    {4 , 1 , {1 , 1 , 3 , 3}},
+    {4 , 4 , {1 , 3 , 5 , 13}},
+    {5 , 2 , {1 , 1 , 5 , 5 , 17}},
+    {5 , 4 , {1 , 1 , 5 , 5 , 5}},
+    {5 , 7 , {1 , 1 , 7 , 11 , 19}},
+    {5 , 11 , {1 , 1 , 5 , 1 , 1}},
+    {5 , 13 , {1 , 1 , 1 , 3 , 11}},
+    {5 , 14 , {1 , 3 , 5 , 5 , 31}},
+    {6 , 1 , {1 , 3 , 3 , 9 , 7 , 49}},
+    {6 , 13 , {1 , 1 , 1 , 15 , 21 , 21}},
+    {6 , 16 , {1 , 3 , 1 , 13 , 27 , 49}},
+    {6 , 19 , {1 , 1 , 1 , 15 , 7 , 5}},
+    {6 , 22 , {1 , 3 , 1 , 15 , 13 , 25}},
+    {6 , 25 , {1 , 1 , 5 , 5 , 19 , 61}},
+    {7 , 1 , {1 , 3 , 7 , 11 , 23 , 15 , 103}},
+    {7 , 4 , {1 , 3 , 7 , 13 , 13 , 15 , 69}},
+};
+const size_t JOE_KUO_COUNT = sizeof(JOE_KUO) / sizeof(JOE_KUO[0]);
+
+// x^e mod poly over GF(2) , poly of degree s
+uint64_t power_mod(uint64_t e , uint64_t poly , int s){
+    uint64_t result = 1;
+    uint64_t base = 2;
+    while (e > 0){
+        if (e & 1){
+            uint64_t r = 0;
+            for (int i = 0; i < s; ++i){
+                if (base & (uint64_t(1) << i)){
+                    r ^= result << i;
+                }
+            }
+            for (int i = 2 * s - 2; i >= s; --i){
+                if (r & (uint64_t(1) << i)){
+                    r ^= poly << (i - s);
+                }
+            }
+            result = r;
+        }
+        uint64_t sq = 0;
+        for (int i = 0; i < s; ++i){
+            if (base & (uint64_t(1) << i)){
+                sq ^= base << i;
+            }
+        }
+        for (int i = 2 * s - 2; i >= s; --i){
+            if (sq & (uint64_t(1) << i)){
+                sq ^= poly << (i - s);
+            }
+        }
+        base = sq;
+        e >>= 1;
+    }
+    return result;
+}
+
+// x has order 2^s - 1 modulo poly
+bool primitive(uint64_t poly , int s){
+    const uint64_t order = (uint64_t(1) << s) - 1;
+    if (power_mod(order , poly , s) != 1){
+        return false;
+    }
+    uint64_t rest = order;
+    for (uint64_t q = 2; q * q <= rest; ++q){
+        if (rest % q == 0){
+            if (power_mod(order / q , poly , s) == 1){
+                return false;
+            }
+            while (rest % q == 0){
+                rest /= q;
+            }
+        }
+    }
+    return rest == 1 || power_mod(order / rest , poly , s) != 1;
+}
+
+} // namespace
+
+Sobol::Sobol(size_t dims) : dims_(dims) , direction_(dims * BITS){
+    if (dims == 0){
+        throw std::invalid_argument("Sobol needs at least one dimension");
+    }
+
+    // first dimension is van der Corput
+    for (int k = 0; k < BITS; ++k){
+        direction_[k] = uint32_t(1) << (BITS - 1 - k);
+    }
+
+    // primitive polynomials in Joe & Kuo order: by degree , then by coefficients
+    int s = 1;
+    uint32_t a = 0;
+    for (size_t d = 1; d < dims; ++d){
+        Primitive p;
+        if (d - 1 < JOE_KUO_COUNT){
+            p = JOE_KUO[d - 1];
+        }
+        else{
+            if (d - 1 == JOE_KUO_COUNT){
+                s = JOE_KUO[JOE_KUO_COUNT - 1].s;
+                a = JOE_KUO[JOE_KUO_COUNT - 1].a;
+            }
+            for (;;){
+                if (++a == (uint32_t(1) << (s - 1))){
+                    ++s;
+                    a = 0;
+                }
+                if (primitive((uint64_t(1) << s) | (uint64_t(a) << 1) | 1 , s)){
+                    break;
+                }
+            }
+            if (s > 16){
+                throw std::invalid_argument("Sobol supports polynomials up to degree 16");
+            }
+            p.s = s;
+            p.a = a;
+            // any odd m_k < 2^k gives a valid sequence , draw them reproducibly
+            for (int k = 0; k < s; ++k){
+                Philox4x32 r = Philox4x32::generate(static_cast<uint32_t>(d) , static_cast<uint32_t>(k) , 0 , 0 , 0x50B01u , 0);
+                p.m[k] = (r.v[0] & ((uint32_t(1) << (k + 1)) - 1)) | 1u;
+            }
+        }
+
+        uint32_t* v = direction_.data() + d * BITS;
+        for (int k = 0; k < p.s && k < BITS; ++k){
+            v[k] = p.m[k] << (BITS - 1 - k);
+        }
+        for (int k = p.s; k < BITS; ++k){
+            uint32_t x = v[k - p.s] ^ (v[k - p.s] >> p.s);
+            for (int i = 1; i < p.s; ++i){
+                if ((p.a >> (p.s - 1 - i)) & 1u){
+                    x ^= v[k - i];
+                }
+            }
+            v[k] = x;
+        }
+    }
+}
+
+void Sobol::seek(uint64_t index , uint32_t* state) const {
+    if (index >> BITS){
+        throw std::invalid_argument("Sobol index beyond 2^32 points");
+    }
+    const uint64_t gray = index ^ (index >> 1);
+    for (size_t d = 0; d < dims_; ++d){
+        const uint32_t* v = direction_.data() + d * BITS;
+        uint32_t x = 0;
+        for (int k = 0; k < BITS; ++k){
+            if ((gray >> k) & 1u){
+                x ^= v[k];
+            }
+        }
+        state[d] = x;
+    }
+}
+
+// gray(i+1) differs from gray(i) in the lowest zero bit of i
+void Sobol::advance(uint64_t index , uint32_t* state) const {
+    int k = 0;
+    while ((index >> k) & 1u){
+        ++k;
+    }
+    if (k >= BITS){
+        throw std::invalid_argument("Sobol index beyond 2^32 points");
+    }
+    for (size_t d = 0; d < dims_; ++d){
+        state[d] ^= direction_[d * BITS + k];
+    }
+}
+
+void Sobol::uniforms(const uint32_t* state , const uint32_t* shift , double* u) const {
+    for (size_t d = 0; d < dims_; ++d){
+        u[d] = (static_cast<double>(state[d] ^ shift[d]) + 0.5) * (1.0 / 4294967296.0);
+    }
+}
+
+void Sobol::shift(uint32_t seed , uint32_t stream , uint32_t* out) const {
+    for (size_t d = 0; d < dims_; ++d){
+        out[d] = Philox4x32::generate(static_cast<uint32_t>(d) , 0 , 0 , 0x5EED5u , seed , stream).v[0];
+    }
+}
+
+
+BrownianBridge::BrownianBridge(size_t steps) : steps_(steps) , bridge_(steps) , left_(steps) , right_(steps) ,
+                                               left_weight_(steps) , right_weight_(steps) , std_dev_(steps){
+    if (steps == 0){
+        throw std::invalid_argument("BrownianBridge needs at least one step");
+    }
+
+    // times are in units of one step: point l sits at time l + 1 , point -1 is the start
+    std::vector<size_t> filled(steps , 0);
+    const size_t n = steps;
+    filled[n - 1] = 1;
+    bridge_[0] = n - 1;
+    std_dev_[0] = std::sqrt(static_cast<double>(n));
+
+    size_t j = 0;
+    for (size_t i = 1; i < n; ++i){
+        while (filled[j]){
+            ++j;
+        }
+        size_t k = j;
+        while (!filled[k]){
+            ++k;
+        }
+        // gap [j , k) is empty , k is known , j - 1 is known (or the start)
+        const size_t l = j + ((k - 1 - j) >> 1);
+        filled[l] = 1;
+        bridge_[i] = l;
+        left_[i] = j;
+        right_[i] = k;
+
+        const double tl = static_cast<double>(j);        // time of point j - 1
+        const double tm = static_cast<double>(l + 1);
+        const double tr = static_cast<double>(k + 1);
+        left_weight_[i] = (tr - tm) / (tr - tl);
+        right_weight_[i] = (tm - tl) / (tr - tl);
+        std_dev_[i] = std::sqrt((tm - tl) * (tr - tm) / (tr - tl));
+
+        j = k + 1;
+        if (j >= n){
+            j = 0;
+        }
+    }
+}
+
+void BrownianBridge::transform(const double* z , double* out) const {
+    // build the path W(t_1..t_n) in out , then difference it in place
+    out[steps_ - 1] = std_dev_[0] * z[0];
+    for (size_t i = 1; i < steps_; ++i){
+        const size_t j = left_[i];
+        const size_t k = right_[i];
+        const size_t l = bridge_[i];
+        double w = right_weight_[i] * out[k] + std_dev_[i] * z[i];
+        if (j > 0){
+            w += left_weight_[i] * out[j - 1];
+        }
+        out[l] = w;
+    }
+    for (size_t i = steps_ - 1; i > 0; --i){
+        out[i] -= out[i - 1];
+    }
+}
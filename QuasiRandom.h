@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Sobol low discrepancy sequence , 32 bit , any number of dimensions
+ * - direction numbers of the first 21 dimensions are Joe & Kuo's (new-joe-kuo-6.21201) ,
+ *   further dimensions use the next primitive polynomials with deterministic odd initial numbers
+ * - points are in gray code order so point i only depends on i: seek() jumps anywhere , advance() steps by one,
+ *   which lets every block of paths start at its own index
+ * - coordinates are integers , uniforms() applies a per dimension digital shift (xor) and maps into (0 , 1)
+ */
+
+class Sobol {
+
+public:
+    static const int BITS = 32;
+
+    explicit Sobol(size_t dims);
+
+    size_t dims() const {return dims_;}
+
+    // coordinates of point `index` into state[dims]
+    void seek(uint64_t index , uint32_t* state) const;
+
+    // state of point `index` -> state of point `index + 1`
+    void advance(uint64_t index , uint32_t* state) const;
+
+    // shifted coordinates as uniforms strictly inside (0 , 1)
+    void uniforms(const uint32_t* state , const uint32_t* shift , double* u) const;
+
+    // random digital shift of every dimension for (seed , stream)
+    void shift(uint32_t seed , uint32_t stream , uint32_t* out) const;
+
+private:
+    size_t dims_;
+    std::vector<uint32_t> direction_;   // dims x BITS , direction_[d*BITS + k] is v_(k+1) of dimension d
+};
+
+/*
+ * Brownian bridge over equally spaced steps
+ * the first normal fixes the terminal value , each next one the midpoint of the widest unfilled gap ,
+ * so the leading (best distributed) Sobol dimensions carry most of the path variance
+ */
+class BrownianBridge {
+
+public:
+    explicit BrownianBridge(size_t steps);
+
+    size_t steps() const {return steps_;}
+
+    // standard normals z[steps] in bridge order -> standard normal step increments out[steps]
+    void transform(const double* z , double* out) const;
+
+private:
+    size_t steps_;
+    std::vector<size_t> bridge_;
+    std::vector<size_t> left_;
+    std::vector<size_t> right_;
+    std::vector<double> left_weight_;
+    std::vector<double> right_weight_;
+    std::vector<double> std_dev_;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+/*
+ * Counter based random numbers for the Monte Carlo engines
+ * - Philox4x32-10 (Salmon et al. , "Parallel random numbers: as easy as 1, 2, 3") maps (counter , key) to 128 random bits
+ *   with no state , so the draw for (path , step) can be computed by any thread in any order
+ * - normals come from the inverse normal cdf , which is also what quasi random points need
+ */
+
+struct Philox4x32 {
+    uint32_t v[4];
+
+    static Philox4x32 generate(uint32_t c0 , uint32_t c1 , uint32_t c2 , uint32_t c3 , uint32_t k0 , uint32_t k1){
+        const uint32_t M0 = 0xD2511F53u;
+        const uint32_t M1 = 0xCD9E8D57u;
+        const uint32_t W0 = 0x9E3779B9u;
+        const uint32_t W1 = 0xBB67AE85u;
+
+        for (int round = 0; round < 10; ++round){
+            uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+            uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+            uint32_t hi0 = static_cast<uint32_t>(p0 >> 32);
+            uint32_t lo0 = static_cast<uint32_t>(p0);
+            uint32_t hi1 = static_cast<uint32_t>(p1 >> 32);
+            uint32_t lo1 = static_cast<uint32_t>(p1);
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+            k0 += W0;
+            k1 += W1;
+        }
+        Philox4x32 out = {{c0 , c1 , c2 , c3}};
+        return out;
+    }
+};
+
+// 53 bit uniform strictly inside (0 , 1) from two 32 bit words
+inline double uniform_open(uint32_t hi , uint32_t lo){
+    uint64_t bits = (static_cast<uint64_t>(hi >> 5) << 26) | (lo >> 6);
+    return (static_cast<double>(bits) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// P. J. Acklam's rational approximation of the inverse normal cdf , relative error below 1.15e-9
+inline double inverse_normal_cdf(double p){
+    static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                3.754408661907416e+00};
+    const double p_low = 0.02425;
+
+    if (p < p_low){
+        double q = std::sqrt(-2.0 * std::log(p));
+        return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+               ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    if (p > 1.0 - p_low){
+        double q = std::sqrt(-2.0 * std::log(1.0 - p));
+        return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+                ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5]) * q /
+           (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+}
+
+/*
+ * Standard normal draw number `step` of path `path` in stream `stream` under `seed`
+ * the key is (seed , stream) and the counter is (step , path) so every draw is independent of how work is split
+ */
+inline double counter_normal(uint32_t seed , uint32_t stream , uint64_t path , uint64_t step){
+    Philox4x32 r = Philox4x32::generate(static_cast<uint32_t>(step) , static_cast<uint32_t>(step >> 32) ,
+                                        static_cast<uint32_t>(path) , static_cast<uint32_t>(path >> 32) ,
+                                        seed , stream);
+    return inverse_normal_cdf(uniform_open(r.v[0] , r.v[1]));
+}
@@ -0,0 +1,100 @@
+#include "RateCurve.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// cells in the bucket index , enough that a cell is no wider than the closest pair of nodes
+static const size_t MAX_INDEX_CELLS = 4096;
+
+RateCurve::RateCurve(double rate) : RateCurve(std::vector<double>{1.0} , std::vector<double>{rate}){}
+
+RateCurve::RateCurve(const std::vector<double>& times , const std::vector<double>& zero_rates){
+    if (times.empty() || times.size() != zero_rates.size()){
+        throw std::invalid_argument("RateCurve needs one zero rate per node time");
+    }
+    times_ = times;
+    forward_.resize(times.size());
+    log_df_.resize(times.size());
+    double prev_time = 0.0;
+    double prev_log_df = 0.0;
+    for (size_t j = 0; j < times.size(); ++j){
+        if (!std::isfinite(times[j]) || !(times[j] > prev_time)){
+            throw std::invalid_argument("curve node times must be positive , finite and increasing");
+        }
+        if (!std::isfinite(zero_rates[j])){
+            throw std::invalid_argument("curve zero rates must be finite");
+        }
+        log_df_[j] = -zero_rates[j] * times[j];
+        forward_[j] = (prev_log_df - log_df_[j]) / (times[j] - prev_time);
+        prev_time = times[j];
+        prev_log_df = log_df_[j];
+    }
+    build_index();
+}
+
+void RateCurve::build_index(){
+    double min_gap = times_[0];
+    for (size_t j = 1; j < times_.size(); ++j){
+        min_gap = std::min(min_gap , times_[j] - times_[j - 1]);
+    }
+    const double last = times_.back();
+    const size_t cells = std::min(MAX_INDEX_CELLS , static_cast<size_t>(std::ceil(last / min_gap)) + 1);
+    cell_ = last / static_cast<double>(cells);
+    index_.resize(cells);
+    size_t j = 0;
+    for (size_t c = 0; c < cells; ++c){
+        const double start = cell_ * static_cast<double>(c);
+        while (j + 1 < times_.size() && times_[j] < start){
+            ++j;
+        }
+        index_[c] = static_cast<unsigned>(j);
+    }
+}
+
+size_t RateCurve::bucket(double T) const {
+    const double cell = T / cell_;
+    size_t j = cell >= 0.0 && cell < static_cast<double>(index_.size()) ? index_[static_cast<size_t>(cell)] : (cell < 0.0 ? 0 : times_.size() - 1);
+    while (j + 1 < times_.size() && times_[j] < T){
+        ++j;
+    }
+    return j;
+}
+
+double RateCurve::discount(double T) const {
+    const size_t j = bucket(T);
+    const double start = bucket_start(j);
+    const double log_df = j == 0 ? 0.0 : log_df_[j - 1];
+    return std::exp(log_df - forward_[j] * (T - start));
+}
+
+double RateCurve::zero_rate(double T) const {
+    if (!(T > 0.0)){
+        return forward_[0];
+    }
+    const size_t j = bucket(T);
+    const double log_df = j == 0 ? 0.0 : log_df_[j - 1];
+    return -(log_df - forward_[j] * (T - bucket_start(j))) / T;
+}
+
+RateCurve RateCurve::bumped(size_t bucket , double shift) const {
+    if (bucket >= forward_.size()){
+        throw std::invalid_argument("curve bucket out of range");
+    }
+    RateCurve c(*this);
+    c.forward_[bucket] += shift;
+    // every node from this bucket on sees the extra forward over the bucket's length
+    const double length = c.times_[bucket] - c.bucket_start(bucket);
+    for (size_t j = bucket; j < c.log_df_.size(); ++j){
+        c.log_df_[j] -= shift * length;
+    }
+    return c;
+}
+
+RateCurve RateCurve::shifted(double shift) const {
+    RateCurve c(*this);
+    for (size_t j = 0; j < c.forward_.size(); ++j){
+        c.forward_[j] += shift;
+        c.log_df_[j] -= shift * c.times_[j];
+    }
+    return c;
+}
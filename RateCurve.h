@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+ * Term structure for a continuously compounded rate , used for both the yield curve and the dividend yield curve
+ * - built from zero rates at node times , stored as piecewise flat forwards: forward(j) holds on (time(j-1) , time(j)],
+ *   bucket 0 starts at t = 0 and the last forward carries on past the last node
+ * - log discount factors at the nodes are precomputed , so discount(T) is one exp of a linear interpolation in ln DF
+ * - the bucket holding T is found in O(1) through a uniform index table over [0 , last node] instead of a search
+ * - BlackScholes' curve batches look each distinct expiry of a batch up once , whatever the row order
+ * - bumped() shifts one bucket's forward , which moves the discount factor of every expiry after that bucket starts
+ *   and of none before it , so a rho ladder only reprices the options past each bucket
+ */
+
+class RateCurve {
+
+public:
+    // one rate for every maturity
+    explicit RateCurve(double rate);
+
+    // times increasing and positive , zero_rates[j] is the zero rate to times[j]
+    RateCurve(const std::vector<double>& times , const std::vector<double>& zero_rates);
+
+    double discount(double T) const;
+
+    // -ln DF(T) / T , the flat rate that gives the same discount factor
+    double zero_rate(double T) const;
+
+    double forward(size_t bucket) const {return forward_[bucket];}
+
+    size_t buckets() const {return forward_.size();}
+
+    // start of a bucket , expiries at or before it do not depend on its forward
+    double bucket_start(size_t bucket) const {return bucket == 0 ? 0.0 : times_[bucket - 1];}
+
+    // bucket = the index of the node it ends at
+    size_t bucket(double T) const;
+
+    // copy with shift added to one bucket's forward , or to every forward (parallel shift)
+    RateCurve bumped(size_t bucket , double shift) const;
+    RateCurve shifted(double shift) const;
+
+private:
+    void build_index();
+
+    std::vector<double> times_;
+    std::vector<double> forward_;
+    std::vector<double> log_df_;      // ln DF at each node
+    std::vector<unsigned> index_;     // first bucket that can hold a T in each uniform cell
+    double cell_ = 1.0;
+};
@@ -0,0 +1,152 @@
+#include "ScenarioGrid.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// rows per pool task , a block of 64 rows on a 21 x 11 grid is ~15k cells , enough to amortise the task
+const size_t BLOCK_ROWS = 64;
+
+// the shocked spots of one market , shared by every row on it
+struct SpotTerms {
+    std::vector<double> spot;
+    std::vector<double> log_spot;
+};
+
+void shock_spots(const std::vector<double>& shocks , double S , SpotTerms& terms){
+    terms.spot.resize(shocks.size());
+    terms.log_spot.resize(shocks.size());
+    for (size_t a = 0; a < shocks.size(); ++a){
+        terms.spot[a] = S * (1.0 + shocks[a]);
+        terms.log_spot[a] = std::log(terms.spot[a]);
+    }
+}
+
+void check_vols(const std::vector<double>& shocks , double sigma){
+    for (double shock : shocks){
+        if (!(sigma + shock > 0.0)){
+            throw std::invalid_argument("shocked volatility must be positive");
+        }
+    }
+}
+
+// every cell of one row , the per vol terms live in per thread scratch reused across rows
+template <CdfAccuracy Accuracy>
+void price_row(double K , double T , Option::Type type , const MarketData& m , const SpotTerms& spots ,
+               const std::vector<double>& vol_shocks , double* out){
+    const size_t nv = vol_shocks.size();
+    const double w = type == Option::Type::CALL ? 1.0 : -1.0;
+    const double sqrt_T = std::sqrt(T);
+    const double log_K = std::log(K);
+    const double exp_qT = std::exp(-m.dividend_ * T);
+    const double K_df = K * std::exp(-m.rate_ * T);
+
+    thread_local std::vector<double> sst , inv_sst , drift;
+    sst.resize(nv);
+    inv_sst.resize(nv);
+    drift.resize(nv);
+    for (size_t b = 0; b < nv; ++b){
+        const double sigma = m.volatility_ + vol_shocks[b];
+        sst[b] = sigma * sqrt_T;
+        inv_sst[b] = 1.0 / sst[b];
+        drift[b] = (m.rate_ - m.dividend_ + 0.5 * sigma * sigma) * T - log_K;
+    }
+
+    for (size_t a = 0; a < spots.spot.size(); ++a){
+        const double S_q = spots.spot[a] * exp_qT;
+        const double log_S = spots.log_spot[a];
+        double* cell = out + a * nv;
+        for (size_t b = 0; b < nv; ++b){
+            const double d1 = (log_S + drift[b]) * inv_sst[b];
+            const double d2 = d1 - sst[b];
+            cell[b] = w * (S_q * normal_cdf<Accuracy>(w * d1) - K_df * normal_cdf<Accuracy>(w * d2));
+        }
+    }
+}
+
+template <typename F>
+void for_blocks(ThreadPool* pool , size_t rows , const F& fn){
+    const size_t blocks = (rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    auto block = [&](size_t k){
+        const size_t begin = k * BLOCK_ROWS;
+        const size_t end = begin + BLOCK_ROWS < rows ? begin + BLOCK_ROWS : rows;
+        fn(begin , end);
+    };
+    if (pool == nullptr || blocks <= 1){
+        for (size_t k = 0; k < blocks; ++k){
+            block(k);
+        }
+        return;
+    }
+    pool->parallel_for(blocks , std::function<void(size_t)>(block));
+}
+
+// market(i) is the MarketData of row i , spots(i) its shocked spots
+template <CdfAccuracy Accuracy , typename Market , typename Spots>
+void price_rows(const ScenarioGrid& grid , ThreadPool* pool , const OptionBatch& batch , const Market& market , const Spots& spots , double* out){
+    for_blocks(pool , batch.size() , [&](size_t begin , size_t end){
+        for (size_t i = begin; i < end; ++i){
+            price_row<Accuracy>(batch.strike_[i] , batch.expiry_[i] , batch.type_[i] , market(i) , spots(i) ,
+                                grid.vol_shocks() , out + grid.index(i , 0 , 0));
+        }
+    });
+}
+
+template <typename Market , typename Spots>
+void price_all(const ScenarioGrid& grid , ThreadPool* pool , const OptionBatch& batch , const Market& market , const Spots& spots , double* out){
+    switch (grid.config().accuracy){
+    case CdfAccuracy::RATIONAL: price_rows<CdfAccuracy::RATIONAL>(grid , pool , batch , market , spots , out); return;
+    case CdfAccuracy::POLYNOMIAL: price_rows<CdfAccuracy::POLYNOMIAL>(grid , pool , batch , market , spots , out); return;
+    case CdfAccuracy::TABLE: price_rows<CdfAccuracy::TABLE>(grid , pool , batch , market , spots , out); return;
+    default: price_rows<CdfAccuracy::EXACT>(grid , pool , batch , market , spots , out); return;
+    }
+}
+
+} // namespace
+
+
+ScenarioGrid::ScenarioGrid(std::vector<double> spot_shocks , std::vector<double> vol_shocks , const Config& config) :
+                    spot_shocks_(std::move(spot_shocks)) , vol_shocks_(std::move(vol_shocks)) , config_(config) , pool_(nullptr){
+    if (spot_shocks_.empty() || vol_shocks_.empty()){
+        throw std::invalid_argument("scenario grid needs at least one spot and one vol shock");
+    }
+    for (double shock : spot_shocks_){
+        if (!(shock > -1.0) || !std::isfinite(shock)){
+            throw std::invalid_argument("spot shocks must be finite and above -100%");
+        }
+    }
+    for (double shock : vol_shocks_){
+        if (!std::isfinite(shock)){
+            throw std::invalid_argument("vol shocks must be finite");
+        }
+    }
+    if (config_.num_threads == 0){
+        pool_ = &ThreadPool::global();
+    }
+    else if (config_.num_threads > 1){
+        own_pool_ = std::make_shared<ThreadPool>(config_.num_threads);
+        pool_ = own_pool_.get();
+    }
+}
+
+// one market: the shocked spots and their logs are built once for the whole book
+void ScenarioGrid::price(const OptionBatch& batch , const MarketData& marketdata , double* out) const {
+    check_vols(vol_shocks_ , marketdata.volatility_);
+    SpotTerms spots;
+    shock_spots(spot_shocks_ , marketdata.spot_ , spots);
+    price_all(*this , pool_ , batch , [&](size_t) -> const MarketData& {return marketdata;} , [&](size_t) -> const SpotTerms& {return spots;} , out);
+}
+
+// one market per row: the shocked spots are rebuilt per row , spots() logs against cells() cells
+void ScenarioGrid::price(const OptionBatch& batch , const MarketData* marketdata , double* out) const {
+    for (size_t i = 0; i < batch.size(); ++i){
+        check_vols(vol_shocks_ , marketdata[i].volatility_);
+    }
+    price_all(*this , pool_ , batch , [&](size_t i) -> const MarketData& {return marketdata[i];} ,
+              [&](size_t i) -> const SpotTerms& {
+                  thread_local SpotTerms spots;
+                  shock_spots(spot_shocks_ , marketdata[i].spot_ , spots);
+                  return spots;
+              } , out);
+}
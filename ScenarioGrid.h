@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "OptionBook.h"
+#include "NormalCdf.h"
+
+class ThreadPool;
+
+/*
+ * Full revaluation of a book on a spot x vol shock grid (risk reports , stress tests)
+ * - spot shocks are relative: S (1 + spot_shock[a]) , vol shocks are absolute: sigma + vol_shock[b]
+ * - results go into one dense caller provided cube , option major:
+ *   out[index(i , a , b)] = out[(i * spots() + a) * vols() + b] is the Black Scholes price of row i in cell (a , b)
+ * - nothing is rebuilt per cell: log(S_a) once per grid , log K , sqrt(T) and both discount factors once per option,
+ *   sigma_b sqrt(T) and the drift once per (option , vol) , so a cell costs the two N() calls and a few multiplies
+ * - rows run in blocks on a thread pool , num_threads follows LSMC::Config (0 shared pool , 1 calling thread , n own pool)
+ */
+
+class ScenarioGrid {
+
+public:
+    struct Config {
+        CdfAccuracy accuracy;
+        size_t num_threads;
+
+        Config() : accuracy(CdfAccuracy::EXACT) , num_threads(0){}
+    };
+
+    // throws std::invalid_argument on an empty shock vector or a spot shock at or below -100%
+    ScenarioGrid(std::vector<double> spot_shocks , std::vector<double> vol_shocks , const Config& config = Config());
+
+    size_t spots() const {return spot_shocks_.size();}
+    size_t vols() const {return vol_shocks_.size();}
+    size_t cells() const {return spots() * vols();}
+
+    // doubles the cube needs for a batch of n rows
+    size_t values(size_t n) const {return n * cells();}
+    size_t index(size_t i , size_t a , size_t b) const {return (i * spots() + a) * vols() + b;}
+
+    const std::vector<double>& spot_shocks() const {return spot_shocks_;}
+    const std::vector<double>& vol_shocks() const {return vol_shocks_;}
+    const Config& config() const {return config_;}
+
+    // out holds values(batch.size()) doubles , the per row overload shocks marketdata[i] for row i
+    // throws std::invalid_argument when a shocked vol is not positive
+    void price(const OptionBatch& batch , const MarketData& marketdata , double* out) const;
+    void price(const OptionBatch& batch , const MarketData* marketdata , double* out) const;
+
+private:
+    std::vector<double> spot_shocks_;
+    std::vector<double> vol_shocks_;
+    Config config_;
+    std::shared_ptr<ThreadPool> own_pool_;
+    ThreadPool* pool_;
+};
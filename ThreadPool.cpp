@@ -0,0 +1,187 @@
+#include "ThreadPool.h"
+#include "Numa.h"
+
+namespace {
+
+// which pool (if any) the current thread works for , and its slot in it
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+}
+
+ThreadPool::ThreadPool(size_t threads , bool numa) : pending_(0) , next_queue_(0) , stop_(false){
+    if (threads == 0){
+        threads = std::max<size_t>(1 , std::thread::hardware_concurrency());
+    }
+    // one extra queue for tasks pushed by threads outside the pool
+    for (size_t i = 0; i <= threads; ++i){
+        queues_.emplace_back(new Queue());
+    }
+
+    // worker i takes the node of the i-th cpu in node order , so nodes fill in proportion to their cpus
+    const NumaTopology& topology = NumaTopology::get();
+    std::vector<size_t> cpu_node;
+    for (size_t n = 0; n < topology.nodes(); ++n){
+        cpu_node.insert(cpu_node.end() , topology.cpus(n).size() , n);
+    }
+    numa = numa && topology.nodes() > 1 && !cpu_node.empty();
+    node_.assign(threads , 0);
+    for (size_t i = 0; numa && i < threads; ++i){
+        node_[i] = cpu_node[i * cpu_node.size() / threads];
+    }
+
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i){
+        workers_.emplace_back([this , i , numa](){
+            if (numa){
+                NumaTopology::get().bind_current_thread(node_[i]);
+            }
+            worker_loop(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_){
+        t.join();
+    }
+}
+
+ThreadPool& ThreadPool::global(){
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::worker_index() const {
+    return current_pool == this ? current_index : size();
+}
+
+bool ThreadPool::pop(size_t queue , Task& task , bool back){
+    Queue& q = *queues_[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()){
+        return false;
+    }
+    if (back){
+        task = q.tasks.back();
+        q.tasks.pop_back();
+    }
+    else{
+        task = q.tasks.front();
+        q.tasks.pop_front();
+    }
+    pending_.fetch_sub(1 , std::memory_order_acq_rel);
+    return true;
+}
+
+void ThreadPool::execute(const Task& task){
+    Job& job = *task.job;
+    if (!job.failed.load(std::memory_order_acquire)){
+        try {
+            (*job.fn)(task.index);
+        }
+        catch (...){
+            if (!job.failed.exchange(true , std::memory_order_acq_rel)){
+                job.error = std::current_exception();
+            }
+        }
+    }
+    if (job.remaining.fetch_sub(1 , std::memory_order_acq_rel) == 1){
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        wake_.notify_all();
+    }
+}
+
+// own queue first (newest work , still hot in cache) then steal the oldest work of the others
+bool ThreadPool::try_run(size_t self){
+    Task task;
+    if (pop(self , task , true)){
+        execute(task);
+        return true;
+    }
+    const size_t n = queues_.size();
+    for (size_t k = 1; k < n; ++k){
+        if (pop((self + k) % n , task , false)){
+            execute(task);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t self){
+    current_pool = this;
+    current_index = self;
+    for (;;){
+        if (try_run(self)){
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock , [this](){return stop_ || pending_.load(std::memory_order_acquire) > 0;});
+        if (stop_ && pending_.load(std::memory_order_acquire) == 0){
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallel_for(size_t n , const std::function<void(size_t)>& fn){
+    run(n , fn , nullptr);
+}
+
+void ThreadPool::parallel_for(size_t n , const std::function<void(size_t)>& fn , const std::function<size_t(size_t)>& home){
+    run(n , fn , &home);
+}
+
+void ThreadPool::run(size_t n , const std::function<void(size_t)>& fn , const std::function<size_t(size_t)>* home){
+    if (n == 0){
+        return;
+    }
+    if (n == 1 || workers_.empty()){
+        for (size_t i = 0; i < n; ++i){
+            fn(i);
+        }
+        return;
+    }
+
+    Job job;
+    job.fn = &fn;
+    job.remaining.store(n , std::memory_order_relaxed);
+    job.failed.store(false , std::memory_order_relaxed);
+
+    // deal indices round robin over the worker queues , starting where the previous call stopped,
+    // or onto the queue each index asks for
+    const size_t workers = workers_.size();
+    size_t start = next_queue_.fetch_add(1 , std::memory_order_relaxed);
+    pending_.fetch_add(n , std::memory_order_acq_rel);
+    for (size_t i = 0; i < n; ++i){
+        Queue& q = *queues_[(home ? (*home)(i) : start + i) % workers];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(Task{&job , i});
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_all();
+
+    // help out until our own job is finished , sleeping only while nothing is queued anywhere
+    // (a worker blocked here in a nested call keeps draining the queues , so nesting cannot starve the pool)
+    const size_t self = worker_index() < workers ? worker_index() : workers;
+    while (job.remaining.load(std::memory_order_acquire) > 0){
+        if (try_run(self)){
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock , [this , &job](){
+            return job.remaining.load(std::memory_order_acquire) == 0 || pending_.load(std::memory_order_acquire) > 0;
+        });
+    }
+    // every task is done with the stack allocated job , safe to unwind now
+    if (job.error){
+        std::rethrow_exception(job.error);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Persistent work-stealing thread pool
+ * - threads are started once and sleep when idle , nothing is created per call
+ * - every worker owns a deque: it pops its own work from the back and steals from the front of the others
+ * - parallel_for blocks until all indices ran , the calling thread executes tasks while it waits
+ *   so a parallel_for issued from inside a task cannot deadlock the pool
+ * - a task that throws does not take its worker down: the first exception of a parallel_for is kept , the indices not
+ *   yet started are skipped , and once every queued task of the call is done it is rethrown on the calling thread
+ * - the pool only decides where work runs , callers that need reproducible results
+ *   keep per-index partial results and reduce them in index order
+ * - numa = true spreads the workers over the NUMA nodes in proportion to their cpus and binds each to its node,
+ *   parallel_for with a home function then queues task i on worker home(i) (it can still be stolen when that worker is busy)
+ */
+
+class ThreadPool {
+
+public:
+    // threads = 0 uses every hardware thread
+    explicit ThreadPool(size_t threads = 0 , bool numa = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const {return workers_.size();}
+
+    // runs fn(i) for every i in [0 , n)
+    void parallel_for(size_t n , const std::function<void(size_t)>& fn);
+
+    // same , task i queued first on worker home(i) % size()
+    void parallel_for(size_t n , const std::function<void(size_t)>& fn , const std::function<size_t(size_t)>& home);
+
+    // NUMA node worker runs on , 0 for a pool built without numa
+    size_t node(size_t worker) const {return node_[worker];}
+
+    // process wide pool sized to the machine , built on first use
+    static ThreadPool& global();
+
+    // index of the calling worker in [0 , size()) , size() for threads outside this pool
+    size_t worker_index() const;
+
+private:
+    struct Job {
+        const std::function<void(size_t)>* fn;
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed;       // set by the first task that throws , later tasks of the job are skipped
+        std::exception_ptr error;       // written once by that task , read by run() after remaining reaches 0
+    };
+
+    struct Task {
+        Job* job;
+        size_t index;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void worker_loop(size_t self);
+    bool try_run(size_t self);
+    bool pop(size_t queue , Task& task , bool back);
+    void execute(const Task& task);
+    void run(size_t n , const std::function<void(size_t)>& fn , const std::function<size_t(size_t)>* home);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::vector<size_t> node_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_;      // queued , not yet picked up
+    std::atomic<size_t> next_queue_;
+    bool stop_;
+};
@@ -0,0 +1,205 @@
+#include "VolSurface.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// tags every surface so the per thread lookup cache never mixes two of them up
+uint64_t next_id(){
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
+// direct mapped , one entry per slot , a collision just overwrites
+struct CacheEntry {
+    uint64_t id;
+    double strike;
+    double expiry;
+    double vol;
+};
+
+const size_t CACHE_SLOTS = 256;
+
+size_t cache_slot(double strike , double expiry){
+    uint64_t k , t;
+    std::memcpy(&k , &strike , sizeof(k));
+    std::memcpy(&t , &expiry , sizeof(t));
+    uint64_t h = k * 0x9E3779B97F4A7C15ull ^ t * 0xC2B2AE3D27D4EB4Full;
+    return static_cast<size_t>(h >> 56) & (CACHE_SLOTS - 1);
+}
+
+void check_positive(double x , const char* what){
+    if (!std::isfinite(x) || x <= 0.0){
+        throw std::invalid_argument(what);
+    }
+}
+
+} // namespace
+
+
+VolSurface::VolSurface(const std::vector<SviSlice>& slices) : id_(next_id()){
+    if (slices.empty()){
+        throw std::invalid_argument("VolSurface needs at least one slice");
+    }
+    for (const SviSlice& p : slices){
+        check_positive(p.expiry , "slice expiry must be positive and finite");
+        check_positive(p.forward , "slice forward must be positive and finite");
+        check_positive(p.sigma , "svi sigma must be positive and finite");
+        if (!(p.b >= 0.0) || !(std::abs(p.rho) < 1.0) || !std::isfinite(p.a) || !std::isfinite(p.m) || !std::isfinite(p.b)){
+            throw std::invalid_argument("svi needs b >= 0 and |rho| < 1");
+        }
+        // minimum of w over k
+        if (p.a + p.b * p.sigma * std::sqrt(1.0 - p.rho * p.rho) < 0.0){
+            throw std::invalid_argument("svi slice has negative total variance");
+        }
+        Slice s;
+        s.expiry = p.expiry;
+        s.log_forward = std::log(p.forward);
+        s.spline = false;
+        s.a = p.a;
+        s.b = p.b;
+        s.b_rho = p.b * p.rho;
+        s.m = p.m;
+        s.sigma_sq = p.sigma * p.sigma;
+        slices_.push_back(s);
+    }
+    check_expiries();
+}
+
+VolSurface::VolSurface(const std::vector<double>& expiries , const std::vector<double>& forwards , const std::vector<double>& strikes ,
+                       const std::vector<double>& vols) : id_(next_id()){
+    const size_t n = strikes.size();
+    if (expiries.empty() || n < 2){
+        throw std::invalid_argument("VolSurface grid needs at least one expiry and two strikes");
+    }
+    if (forwards.size() != expiries.size() || vols.size() != expiries.size() * n){
+        throw std::invalid_argument("VolSurface grid sizes do not match");
+    }
+    for (size_t j = 0; j < n; ++j){
+        check_positive(strikes[j] , "grid strikes must be positive and finite");
+        if (j > 0 && !(strikes[j] > strikes[j - 1])){
+            throw std::invalid_argument("grid strikes must be increasing");
+        }
+    }
+
+    for (size_t i = 0; i < expiries.size(); ++i){
+        check_positive(expiries[i] , "slice expiry must be positive and finite");
+        check_positive(forwards[i] , "slice forward must be positive and finite");
+        Slice s;
+        s.expiry = expiries[i];
+        s.log_forward = std::log(forwards[i]);
+        s.spline = true;
+        s.a = s.b = s.b_rho = s.m = s.sigma_sq = 0.0;
+        s.k.resize(n);
+        s.w.resize(n);
+        for (size_t j = 0; j < n; ++j){
+            const double vol = vols[i * n + j];
+            check_positive(vol , "grid vols must be positive and finite");
+            s.k[j] = std::log(strikes[j]) - s.log_forward;
+            s.w[j] = vol * vol * s.expiry;
+        }
+
+        // natural spline: w2 = 0 at both ends , tridiagonal solve for the interior
+        s.w2.assign(n , 0.0);
+        std::vector<double> c(n , 0.0);
+        for (size_t j = 1; j + 1 < n; ++j){
+            const double h0 = s.k[j] - s.k[j - 1];
+            const double h1 = s.k[j + 1] - s.k[j];
+            const double rhs = 6.0 * ((s.w[j + 1] - s.w[j]) / h1 - (s.w[j] - s.w[j - 1]) / h0);
+            const double diag = 2.0 * (h0 + h1) - h0 * c[j - 1];
+            c[j] = h1 / diag;
+            s.w2[j] = (rhs - h0 * s.w2[j - 1]) / diag;
+        }
+        for (size_t j = n - 2; j >= 1; --j){
+            s.w2[j] -= c[j] * s.w2[j + 1];
+        }
+        slices_.push_back(s);
+    }
+    check_expiries();
+}
+
+void VolSurface::check_expiries() const {
+    for (size_t i = 1; i < slices_.size(); ++i){
+        if (!(slices_[i].expiry > slices_[i - 1].expiry)){
+            throw std::invalid_argument("slice expiries must be increasing");
+        }
+    }
+}
+
+double VolSurface::slice_variance(const Slice& s , double log_strike){
+    const double k = log_strike - s.log_forward;
+    if (!s.spline){
+        const double x = k - s.m;
+        return s.a + s.b_rho * x + s.b * std::sqrt(x * x + s.sigma_sq);
+    }
+
+    const size_t n = s.k.size();
+    if (k <= s.k[0]){
+        return s.w[0];
+    }
+    if (k >= s.k[n - 1]){
+        return s.w[n - 1];
+    }
+    const size_t j = static_cast<size_t>(std::upper_bound(s.k.begin() , s.k.end() , k) - s.k.begin()) - 1;
+    const double h = s.k[j + 1] - s.k[j];
+    const double A = (s.k[j + 1] - k) / h;
+    const double B = 1.0 - A;
+    return A * s.w[j] + B * s.w[j + 1] + ((A * A * A - A) * s.w2[j] + (B * B * B - B) * s.w2[j + 1]) * h * h / 6.0;
+}
+
+VolSurface::Bracket VolSurface::bracket(double expiry) const {
+    const Slice& first = slices_.front();
+    const Slice& last = slices_.back();
+    // flat vol outside the slices: w scales with T
+    if (expiry <= first.expiry){
+        return {&first , &first , expiry / first.expiry , 0.0};
+    }
+    if (expiry >= last.expiry){
+        return {&last , &last , expiry / last.expiry , 0.0};
+    }
+    auto it = std::upper_bound(slices_.begin() , slices_.end() , expiry , [](double t , const Slice& s){return t < s.expiry;});
+    const Slice& hi = *it;
+    const Slice& lo = *(it - 1);
+    const double u = (expiry - lo.expiry) / (hi.expiry - lo.expiry);
+    return {&lo , &hi , 1.0 - u , u};
+}
+
+double VolSurface::variance(const Bracket& b , double log_strike) const {
+    double w = b.w_lo * slice_variance(*b.lo , log_strike);
+    if (b.w_hi != 0.0){
+        w += b.w_hi * slice_variance(*b.hi , log_strike);
+    }
+    return w;
+}
+
+double VolSurface::total_variance(double strike , double expiry) const {
+    return variance(bracket(expiry) , std::log(strike));
+}
+
+double VolSurface::volatility(double strike , double expiry) const {
+    thread_local CacheEntry cache[CACHE_SLOTS] = {};
+    CacheEntry& e = cache[cache_slot(strike , expiry)];
+    if (e.id == id_ && e.strike == strike && e.expiry == expiry){
+        return e.vol;
+    }
+    const double vol = std::sqrt(std::max(total_variance(strike , expiry) , 0.0) / expiry);
+    e = {id_ , strike , expiry , vol};
+    return vol;
+}
+
+void VolSurface::volatility_batch(const OptionBatch& batch , double* out) const {
+    double expiry = -1.0;
+    Bracket b = bracket(slices_.front().expiry);
+    double inv_expiry = 0.0;
+    for (size_t i = 0; i < batch.size(); ++i){
+        if (batch.expiry_[i] != expiry){
+            expiry = batch.expiry_[i];
+            b = bracket(expiry);
+            inv_expiry = 1.0 / expiry;
+        }
+        out[i] = std::sqrt(std::max(variance(b , std::log(batch.strike_[i])) , 0.0) * inv_expiry);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "OptionBook.h"
+
+/*
+ * Implied volatility surface over strike and expiry
+ * - one slice per expiry , each gives total variance w(k) = sigma^2 T as a function of k = ln(K / F) with F the slice's forward
+ *   SVI slices: raw SVI w(k) = a + b (rho (k - m) + sqrt((k - m)^2 + sigma^2))
+ *   grid slices: natural cubic spline of w through the quoted strikes , flat in w beyond the first and last strike
+ * - between slices total variance is linear in T at fixed strike , before the first and after the last slice the vol is flat
+ * - slice coefficients (log forward , b rho , sigma^2 , spline second derivatives) are computed once at construction
+ * - the surface is immutable , volatility() keeps a small per thread cache of recent (K , T) lookups,
+ *   volatility_batch() skips the cache and only redoes the expiry bracketing when the expiry changes between rows
+ */
+
+class VolSurface {
+
+public:
+    struct SviSlice {
+        double expiry;
+        double forward;
+        double a;
+        double b;
+        double rho;
+        double m;
+        double sigma;
+    };
+
+    // slices in increasing expiry
+    explicit VolSurface(const std::vector<SviSlice>& slices);
+
+    // quoted vols on a strike x expiry grid , vols[i * strikes.size() + j] is the quote at expiries[i] , strikes[j]
+    VolSurface(const std::vector<double>& expiries , const std::vector<double>& forwards , const std::vector<double>& strikes ,
+               const std::vector<double>& vols);
+
+    double volatility(double strike , double expiry) const;
+    double total_variance(double strike , double expiry) const;
+
+    // out[i] = volatility(batch.strike_[i] , batch.expiry_[i])
+    void volatility_batch(const OptionBatch& batch , double* out) const;
+
+    size_t slices() const {return slices_.size();}
+
+private:
+    struct Slice {
+        double expiry;
+        double log_forward;
+        bool spline;
+
+        // svi , b_rho = b * rho , sigma_sq = sigma^2
+        double a;
+        double b;
+        double b_rho;
+        double m;
+        double sigma_sq;
+
+        // spline nodes in k , total variance and its second derivative at each node
+        std::vector<double> k;
+        std::vector<double> w;
+        std::vector<double> w2;
+    };
+
+    // expiry -> the two slices around it and the weights of their total variances
+    struct Bracket {
+        const Slice* lo;
+        const Slice* hi;
+        double w_lo;
+        double w_hi;
+    };
+
+    static double slice_variance(const Slice& s , double log_strike);
+    Bracket bracket(double expiry) const;
+    double variance(const Bracket& b , double log_strike) const;
+    void check_expiries() const;
+
+    std::vector<Slice> slices_;
+    uint64_t id_;
+};
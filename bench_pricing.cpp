@@ -0,0 +1,723 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "BlackScholesmain.h"
+#include "LSMC.h"
+#include "PortfolioEngine.h"
+#include "Ingest.h"
+#include "BookPricer.h"
+#include "ScenarioGrid.h"
+#include "ParallelPricer.h"
+#include "CrankNicolson.h"
+#include "BinomialTree.h"
+#include "BookFile.h"
+#include "Pipeline.h"
+#include "MemoCache.h"
+#include "GpuBackend.h"
+
+/*
+ * Microbenchmarks of the new model API
+ * - every benchmark reports options/s and time/option next to the raw time per iteration
+ * - batch benchmarks take the book size as argument , LSMC takes the path count
+ * - run with --benchmark_format=json (or --benchmark_out=...) to keep a baseline for regression checks
+ */
+
+static void report(benchmark::State& state , double options_per_iteration){
+    state.counters["options/s"] = benchmark::Counter(options_per_iteration , benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["time/option"] = benchmark::Counter(options_per_iteration ,
+                                                       benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// strikes 60..140 , expiries 1m..2y , calls and puts mixed , the shape of a listed chain
+static OptionBook make_book(size_t n){
+    OptionBook book;
+    book.reserve(n);
+    for (size_t i = 0; i < n; ++i){
+        double strike = 60.0 + 80.0 * static_cast<double>(i % 41) / 40.0;
+        double expiry = 1.0 / 12.0 + 2.0 * static_cast<double>((i / 41) % 24) / 24.0;
+        book.add(strike , expiry , i % 2 ? Option::Type::PUT : Option::Type::CALL);
+    }
+    return book;
+}
+
+static const MarketData MARKET(100.0 , 0.03 , 0.25 , 0.01);
+
+
+static void BM_BlackScholes_price(benchmark::State& state){
+    BlackScholes model;
+    Option option(105.0 , 0.5 , Option::Type::CALL);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(model.price(option , MARKET));
+    }
+    report(state , 1);
+}
+BENCHMARK(BM_BlackScholes_price);
+
+static void BM_BlackScholes_greeks(benchmark::State& state){
+    BlackScholes model;
+    Option option(105.0 , 0.5 , Option::Type::CALL);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(model.greeks(option , MARKET));
+    }
+    report(state , 1);
+}
+BENCHMARK(BM_BlackScholes_greeks);
+
+static void BM_BlackScholes_evaluate_all(benchmark::State& state){
+    BlackScholes model;
+    Option option(105.0 , 0.5 , Option::Type::CALL);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(model.evaluate(option , MARKET , Valuation::ALL));
+    }
+    report(state , 1);
+}
+BENCHMARK(BM_BlackScholes_evaluate_all);
+
+template <BlackScholes::Kernel K>
+static void BM_BlackScholes_price_batch(benchmark::State& state){
+    BlackScholes model(K);
+    OptionBook book = make_book(static_cast<size_t>(state.range(0)));
+    std::vector<double> out(book.size());
+    for (auto _ : state){
+        model.price_batch(book.batch() , MARKET , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch , BlackScholes::Kernel::SCALAR)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch , BlackScholes::Kernel::SIMD)->Arg(1000)->Arg(100000);
+
+// q = 0 lets the scalar kernel drop every e^-qT
+static void BM_BlackScholes_price_batch_no_dividend(benchmark::State& state){
+    BlackScholes model;
+    OptionBook book = make_book(static_cast<size_t>(state.range(0)));
+    MarketData market(MARKET.spot_ , MARKET.rate_ , MARKET.volatility_ , 0.0);
+    std::vector<double> out(book.size());
+    for (auto _ : state){
+        model.price_batch(book.batch() , market , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK(BM_BlackScholes_price_batch_no_dividend)->Arg(100000);
+
+// N(x) alone per accuracy tier over 10k points in [-4 , 4] , see NormalCdf.h for the error of each
+template <CdfAccuracy A>
+static void BM_normal_cdf(benchmark::State& state){
+    std::vector<double> x(10000) , out(x.size());
+    for (size_t i = 0; i < x.size(); ++i){
+        x[i] = -4.0 + 8.0 * static_cast<double>((i * 7919) % x.size()) / static_cast<double>(x.size());
+    }
+    for (auto _ : state){
+        for (size_t i = 0; i < x.size(); ++i){
+            out[i] = normal_cdf<A>(x[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(x.size()));
+}
+BENCHMARK_TEMPLATE(BM_normal_cdf , CdfAccuracy::EXACT);
+BENCHMARK_TEMPLATE(BM_normal_cdf , CdfAccuracy::RATIONAL);
+BENCHMARK_TEMPLATE(BM_normal_cdf , CdfAccuracy::POLYNOMIAL);
+BENCHMARK_TEMPLATE(BM_normal_cdf , CdfAccuracy::TABLE);
+
+// whole batch prices per tier , the cdf is two of the five transcendental calls per row
+template <BlackScholes::Kernel K , CdfAccuracy A>
+static void BM_BlackScholes_price_batch_accuracy(benchmark::State& state){
+    BlackScholes model(K , A);
+    OptionBook book = make_book(static_cast<size_t>(state.range(0)));
+    std::vector<double> out(book.size());
+    for (auto _ : state){
+        model.price_batch(book.batch() , MARKET , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SCALAR , CdfAccuracy::EXACT)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SCALAR , CdfAccuracy::RATIONAL)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SCALAR , CdfAccuracy::POLYNOMIAL)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SCALAR , CdfAccuracy::TABLE)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SIMD , CdfAccuracy::EXACT)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SIMD , CdfAccuracy::RATIONAL)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SIMD , CdfAccuracy::POLYNOMIAL)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_accuracy , BlackScholes::Kernel::SIMD , CdfAccuracy::TABLE)->Arg(100000);
+
+template <BlackScholes::Kernel K>
+static void BM_BlackScholes_greeks_batch(benchmark::State& state){
+    BlackScholes model(K);
+    OptionBook book = make_book(static_cast<size_t>(state.range(0)));
+    size_t n = book.size();
+    std::vector<double> d(n) , g(n) , v(n) , t(n) , r(n);
+    GreeksBatch out(d.data() , g.data() , v.data() , t.data() , r.data());
+    for (auto _ : state){
+        model.greeks_batch(book.batch() , MARKET , out);
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(n));
+}
+BENCHMARK_TEMPLATE(BM_BlackScholes_greeks_batch , BlackScholes::Kernel::SCALAR)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_greeks_batch , BlackScholes::Kernel::SIMD)->Arg(1000)->Arg(100000);
+
+// same book priced off a snapshot entry , the expiry terms are already cached after the first iteration
+static void BM_BlackScholes_price_batch_snapshot(benchmark::State& state){
+    BlackScholes model;
+    OptionBook book = make_book(static_cast<size_t>(state.range(0)));
+    MarketSnapshot snapshot;
+    MarketSnapshot::Underlying& underlying = snapshot.set("UND" , MARKET);
+    std::vector<double> out(book.size());
+    for (auto _ : state){
+        model.price_batch(book.batch() , underlying , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK(BM_BlackScholes_price_batch_snapshot)->Arg(1000)->Arg(100000);
+
+// vol of every row read off a 12 slice svi surface
+template <BlackScholes::Kernel K>
+static void BM_BlackScholes_price_batch_surface(benchmark::State& state){
+    BlackScholes model(K);
+    OptionBook book = make_book(static_cast<size_t>(state.range(0)));
+    std::vector<VolSurface::SviSlice> slices;
+    for (int i = 1; i <= 12; ++i){
+        double T = i / 6.0;
+        slices.push_back({T , MARKET.spot_ * std::exp(0.02 * T) , 0.04 * T , 0.1 , -0.5 , 0.0 , 0.2});
+    }
+    VolSurface surface(slices);
+    std::vector<double> out(book.size());
+    for (auto _ : state){
+        model.price_batch(book.batch() , MARKET , surface , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_surface , BlackScholes::Kernel::SCALAR)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_price_batch_surface , BlackScholes::Kernel::SIMD)->Arg(100000);
+
+template <BlackScholes::Kernel K>
+static void BM_BlackScholes_implied_vol_batch(benchmark::State& state){
+    BlackScholes model(K);
+    OptionBook book = make_book(static_cast<size_t>(state.range(0)));
+    std::vector<double> prices(book.size()) , out(book.size());
+    model.price_batch(book.batch() , MARKET , prices.data());
+    for (auto _ : state){
+        model.implied_vol_batch(book.batch() , MARKET , prices.data() , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK_TEMPLATE(BM_BlackScholes_implied_vol_batch , BlackScholes::Kernel::SCALAR)->Arg(10000);
+BENCHMARK_TEMPLATE(BM_BlackScholes_implied_vol_batch , BlackScholes::Kernel::SIMD)->Arg(10000);
+
+// 100 underlyings x 1000 options , one underlying ticks per iteration , time/option is per option actually repriced
+static void BM_PortfolioEngine_tick(benchmark::State& state){
+    BlackScholes model(BlackScholes::Kernel::SIMD);
+    MarketSnapshot snapshot;
+    PortfolioEngine::Config config;
+    config.approximate = state.range(0) != 0;
+    PortfolioEngine engine(model , snapshot , config);
+    OptionBook book = make_book(1000);
+    std::vector<std::string> names;
+    for (int u = 0; u < 100; ++u){
+        names.push_back("U" + std::to_string(u));
+        snapshot.set(names.back() , MARKET);
+        for (size_t i = 0; i < book.size(); ++i){
+            engine.add(names.back() , book.at(i));
+        }
+    }
+    engine.reprice();
+
+    size_t tick = 0;
+    for (auto _ : state){
+        snapshot.set_spot(names[tick % names.size()] , MARKET.spot_ * (1.0 + 0.001 * static_cast<double>(tick % 3)));
+        benchmark::DoNotOptimize(engine.reprice());
+        ++tick;
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK(BM_PortfolioEngine_tick)->Arg(0)->Arg(1);
+
+// 21 x 11 spot x vol grid over a 1000 row book , time/option is one full grid for one row
+static std::vector<double> shocks(int half , double step){
+    std::vector<double> s;
+    for (int k = -half; k <= half; ++k){
+        s.push_back(step * k);
+    }
+    return s;
+}
+
+static void BM_Scenario_per_cell(benchmark::State& state){
+    BlackScholes model;
+    OptionBook book = make_book(1000);
+    std::vector<double> ds = shocks(10 , 0.02) , dv = shocks(5 , 0.02);
+    std::vector<double> out(book.size() * ds.size() * dv.size());
+    for (auto _ : state){
+        size_t k = 0;
+        for (size_t i = 0; i < book.size(); ++i){
+            for (double s : ds){
+                for (double v : dv){
+                    MarketData cell(MARKET.spot_ * (1.0 + s) , MARKET.rate_ , MARKET.volatility_ + v , MARKET.dividend_);
+                    out[k++] = model.price(book.at(i) , cell);
+                }
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK(BM_Scenario_per_cell)->Unit(benchmark::kMillisecond);
+
+template <CdfAccuracy A>
+static void BM_Scenario_grid(benchmark::State& state){
+    ScenarioGrid::Config config;
+    config.accuracy = A;
+    config.num_threads = static_cast<size_t>(state.range(0));
+    ScenarioGrid grid(shocks(10 , 0.02) , shocks(5 , 0.02) , config);
+    OptionBook book = make_book(1000);
+    std::vector<double> out(grid.values(book.size()));
+    for (auto _ : state){
+        grid.price(book.batch() , MARKET , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK_TEMPLATE(BM_Scenario_grid , CdfAccuracy::EXACT)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Scenario_grid , CdfAccuracy::TABLE)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 1M rows , argument is the thread count (0 = every core) , real time since the work happens on the pool
+static void BM_ParallelPricer_price_all(benchmark::State& state){
+    BlackScholes model(BlackScholes::Kernel::SIMD);
+    ParallelPricer::Config config;
+    config.num_threads = static_cast<size_t>(state.range(0));
+    ParallelPricer pricer(model , config);
+    OptionBook book = make_book(1000000);
+    std::vector<double> out(book.size());
+    for (auto _ : state){
+        pricer.price_all(book.batch() , MARKET , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK(BM_ParallelPricer_price_all)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ParallelPricer_portfolio(benchmark::State& state){
+    BlackScholes model(BlackScholes::Kernel::SIMD);
+    ParallelPricer::Config config;
+    config.num_threads = static_cast<size_t>(state.range(0));
+    ParallelPricer pricer(model , config);
+    OptionBook book = make_book(1000000);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(pricer.portfolio(book.batch() , MARKET));
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK(BM_ParallelPricer_portfolio)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// feed ingestion of 100k contracts with one bad row in a thousand:
+// one Option per row through the throwing constructor , against bulk validate + unchecked append
+static std::vector<ContractRecord> make_records(size_t n){
+    OptionBook book = make_book(n);
+    std::vector<ContractRecord> records(n);
+    for (size_t i = 0; i < n; ++i){
+        records[i] = {book.strikes()[i] , book.expiries()[i] , book.types()[i]};
+        if (i % 1000 == 999){
+            records[i].expiry = -1.0;
+        }
+    }
+    return records;
+}
+
+static void BM_Ingest_constructor(benchmark::State& state){
+    std::vector<ContractRecord> records = make_records(static_cast<size_t>(state.range(0)));
+    OptionBook book;
+    book.reserve(records.size());
+    for (auto _ : state){
+        book.clear();
+        for (const ContractRecord& r : records){
+            try{
+                book.add(r.strike , r.expiry , r.type);
+            }
+            catch (const std::invalid_argument&){
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(records.size()));
+}
+BENCHMARK(BM_Ingest_constructor)->Arg(100000);
+
+static void BM_Ingest_bulk(benchmark::State& state){
+    std::vector<ContractRecord> records = make_records(static_cast<size_t>(state.range(0)));
+    std::vector<uint64_t> errors(error_words(records.size()));
+    OptionBook book;
+    book.reserve(records.size());
+    for (auto _ : state){
+        book.clear();
+        validate(records.data() , records.size() , errors.data());
+        append(book , records.data() , records.size() , errors.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(records.size()));
+}
+BENCHMARK(BM_Ingest_bulk)->Arg(100000);
+
+static void BM_Ingest_validate(benchmark::State& state){
+    std::vector<ContractRecord> records = make_records(static_cast<size_t>(state.range(0)));
+    std::vector<uint64_t> errors(error_words(records.size()));
+    for (auto _ : state){
+        benchmark::DoNotOptimize(validate(records.data() , records.size() , errors.data()));
+    }
+    report(state , static_cast<double>(records.size()));
+}
+BENCHMARK(BM_Ingest_validate)->Arg(100000);
+
+// binomial trees on the old hierarchy , argument is the number of tree steps , cost grows as steps^2
+template <AmericanOption::TreeType T>
+static void BM_American_price(benchmark::State& state){
+    AmericanOption option(100.0 , 100.0 , 0.05 , 1.0 , 0.2 , OptionBase::Optiontype::PUT , static_cast<int>(state.range(0)) , T);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(option.price());
+    }
+    report(state , 1);
+}
+BENCHMARK_TEMPLATE(BM_American_price , AmericanOption::TreeType::CRR)->RangeMultiplier(4)->Range(64 , 4096);
+BENCHMARK_TEMPLATE(BM_American_price , AmericanOption::TreeType::LEISEN_REIMER)->RangeMultiplier(4)->Range(64 , 4096);
+
+// price , delta , gamma , theta , vega and rho together
+template <AmericanOption::TreeType T>
+static void BM_American_greeks(benchmark::State& state){
+    AmericanOption option(100.0 , 100.0 , 0.05 , 1.0 , 0.2 , OptionBase::Optiontype::PUT , static_cast<int>(state.range(0)) , T);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(option.greeks());
+    }
+    report(state , 1);
+}
+BENCHMARK_TEMPLATE(BM_American_greeks , AmericanOption::TreeType::CRR)->Arg(256)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_American_greeks , AmericanOption::TreeType::LEISEN_REIMER)->Arg(256)->Arg(1024);
+
+// 10k row book with one american row in range(0) , priced in one pass: simd black scholes + a 101 step leisen reimer tree
+static void BM_BookPricer_mixed(benchmark::State& state){
+    BinomialTree::Config tree;
+    tree.num_steps = 101;
+    BookPricer pricer(BlackScholes(BlackScholes::Kernel::SIMD) , BinomialTree(tree));
+    OptionBook rows = make_book(10000);
+    MixedBook book;
+    for (size_t i = 0; i < rows.size(); ++i){
+        book.add(rows.at(i) , i % static_cast<size_t>(state.range(0)) == 0 ? Exercise::AMERICAN : Exercise::EUROPEAN);
+    }
+    MarketData market(100.0 , 0.03 , 0.25);
+    std::vector<double> out(book.size());
+    for (auto _ : state){
+        pricer.price(book , market , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(book.size()));
+}
+BENCHMARK(BM_BookPricer_mixed)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+
+// 100 American puts of one expiry , strikes 50 .. 149: one shared Crank-Nicolson grid (arg 0) against 100 trees of
+// matching accuracy (arg 1 , 1000 leisen reimer steps) , both to about 1e-3 of a 4000 step tree
+static void BM_American_strip(benchmark::State& state){
+    std::vector<double> strikes(100) , expiry(100 , 1.0) , out(100);
+    std::vector<Option::Type> type(100 , Option::Type::PUT);
+    for (size_t i = 0; i < strikes.size(); ++i){
+        strikes[i] = 50.0 + static_cast<double>(i);
+    }
+    const OptionBatch batch(strikes.data() , expiry.data() , type.data() , strikes.size());
+    BinomialTree::Config tree;
+    tree.num_steps = 1000;
+    const CrankNicolson pde;
+    const BinomialTree binomial(tree);
+    const PricingModel& model = state.range(0) == 0 ? static_cast<const PricingModel&>(pde) : binomial;
+    MarketData market(100.0 , 0.03 , 0.25);
+    for (auto _ : state){
+        model.price_batch(batch , market , out.data());
+        benchmark::ClobberMemory();
+    }
+    report(state , static_cast<double>(strikes.size()));
+}
+BENCHMARK(BM_American_strip)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// one put: arg 0 = price , 1 = greeks , 2 = sensitivities (taped , Aad.h) , the AAD cost is 2 against 0
+static const PricingModel& sensitivity_model(int which){
+    static const BlackScholes bs;
+    static const BinomialTree tree;
+    static const LSMC lsmc = []{
+        LSMC::Config config;
+        config.num_threads = 1;
+        config.greeks_method = LSMC::GreeksMethod::AAD;
+        return LSMC(config);
+    }();
+    return which == 0 ? static_cast<const PricingModel&>(bs) : which == 1 ? static_cast<const PricingModel&>(tree) : lsmc;
+}
+
+template <int Model>
+static void BM_Sensitivities(benchmark::State& state){
+    const PricingModel& model = sensitivity_model(Model);
+    Option option(105.0 , 0.8 , Option::Type::PUT);
+    MarketData market(100.0 , 0.03 , 0.25);
+    for (auto _ : state){
+        if (state.range(0) == 0){
+            benchmark::DoNotOptimize(model.price(option , market));
+        }
+        else if (state.range(0) == 1){
+            benchmark::DoNotOptimize(model.greeks(option , market));
+        }
+        else{
+            benchmark::DoNotOptimize(model.sensitivities(option , market));
+        }
+    }
+    report(state , 1);
+}
+BENCHMARK_TEMPLATE(BM_Sensitivities , 0)->DenseRange(0 , 2);
+BENCHMARK_TEMPLATE(BM_Sensitivities , 1)->DenseRange(0 , 2);
+BENCHMARK_TEMPLATE(BM_Sensitivities , 2)->DenseRange(0 , 2)->Unit(benchmark::kMillisecond);
+
+// one American put across path counts , time/option is the cost of one full Monte Carlo price
+static void BM_LSMC_price(benchmark::State& state){
+    LSMC::Config config;
+    config.num_paths = static_cast<size_t>(state.range(0));
+    config.num_timesteps = 50;
+    LSMC model(config);
+    Option option(100.0 , 1.0 , Option::Type::PUT);
+    MarketData market(100.0 , 0.05 , 0.2 , 0.0);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(model.price(option , market));
+    }
+    report(state , 1);
+    state.counters["paths/s"] = benchmark::Counter(static_cast<double>(config.num_paths) , benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_LSMC_price)->Arg(10000)->Arg(50000)->Arg(200000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// one American put at 50k paths without (arg 0) and with (arg 1) the european control variate,
+// "paths_saved" is (std_error_plain / std_error)^2 , the path count factor for the same confidence interval
+static void BM_LSMC_control_variate(benchmark::State& state){
+    LSMC::Config config;
+    config.use_control_variate = state.range(0) != 0;
+    LSMC model(config);
+    Option option(100.0 , 1.0 , Option::Type::PUT);
+    MarketData market(100.0 , 0.05 , 0.2 , 0.0);
+    LSMC::Result r = {};
+    for (auto _ : state){
+        r = model.run(option , market);
+        benchmark::DoNotOptimize(r);
+    }
+    report(state , 1);
+    state.counters["std_error"] = r.std_error;
+    state.counters["paths_saved"] = (r.std_error_plain / r.std_error) * (r.std_error_plain / r.std_error);
+}
+BENCHMARK(BM_LSMC_control_variate)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// price and greeks of one American put , arg = LSMC::GreeksMethod (0 bump , 1 aad , 2 pathwise)
+static void BM_LSMC_evaluate(benchmark::State& state){
+    LSMC::Config config;
+    config.greeks_method = static_cast<LSMC::GreeksMethod>(state.range(0));
+    LSMC model(config);
+    Option option(100.0 , 1.0 , Option::Type::PUT);
+    MarketData market(100.0 , 0.05 , 0.2 , 0.0);
+    for (auto _ : state){
+        benchmark::DoNotOptimize(model.evaluate(option , market));
+    }
+    report(state , 1);
+}
+BENCHMARK(BM_LSMC_evaluate)->DenseRange(0 , 2)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// eleven puts , strikes 60..160 , at a fixed budget (arg 1 = 0) against the error controllers (arg 1 = 1):
+// arg 0 = 0 is LSMC at 200k paths against target_error 0.03 capped at 200k , arg 0 = 1 is the Leisen-Reimer tree
+// at 2001 steps against tolerance 5e-4 from 51 steps (the same worst error over the strip) , "work" is the mean
+// paths / steps of the last run per option
+static void BM_Adaptive(benchmark::State& state){
+    const bool adaptive = state.range(1) != 0;
+    MarketData market(100.0 , 0.05 , 0.2 , 0.0);
+    std::vector<Option> puts;
+    for (int i = 0; i <= 10; ++i){
+        puts.emplace_back(60.0 + 10.0 * i , 1.0 , Option::Type::PUT);
+    }
+    double work = 0.0;
+    if (state.range(0) == 0){
+        LSMC::Config config;
+        config.num_paths = 200000;
+        config.target_error = adaptive ? 0.03 : 0.0;
+        LSMC model(config);
+        for (auto _ : state){
+            work = 0.0;
+            for (const Option& put : puts){
+                LSMC::Result r = model.run(put , market);
+                work += static_cast<double>(r.paths);
+                benchmark::DoNotOptimize(r);
+            }
+        }
+    }
+    else {
+        BinomialTree::Config config;
+        config.num_steps = adaptive ? 51 : 2001;
+        config.tolerance = adaptive ? 5e-4 : 0.0;
+        BinomialTree model(config);
+        for (auto _ : state){
+            work = 0.0;
+            for (const Option& put : puts){
+                BinomialTree::Result r = adaptive ? model.run(put , market) : BinomialTree::Result{model.price(put , market) , 0.0 , 2001};
+                work += r.steps;
+                benchmark::DoNotOptimize(r);
+            }
+        }
+    }
+    report(state , static_cast<double>(puts.size()));
+    state.counters["work"] = work / static_cast<double>(puts.size());
+}
+BENCHMARK(BM_Adaptive)->ArgsProduct({{0 , 1} , {0 , 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 5M row book file , page cache warm: arg 0 = open (map and check the header) , arg 1 = open and a scan of every strike,
+// arg 2 = the same rows appended into an OptionBook from ContractRecords (Ingest.h) , the cheapest copying load
+static void BM_BookFile_load(benchmark::State& state){
+    const size_t n = 5000000;
+    const std::string path = "bench_book.dpl";
+    OptionBook book = make_book(n);
+    write_book(path , book.batch());
+    std::vector<ContractRecord> records(n);
+    for (size_t i = 0; i < n; ++i){
+        records[i] = {book.strikes()[i] , book.expiries()[i] , book.types()[i]};
+    }
+    for (auto _ : state){
+        if (state.range(0) == 2){
+            OptionBook loaded;
+            loaded.reserve(n);
+            append(loaded , records.data() , n , nullptr);
+            benchmark::DoNotOptimize(loaded.batch().strike_);
+            continue;
+        }
+        MappedBook mapped(path);
+        OptionBatch batch = mapped.batch();
+        double sum = 0.0;
+        if (state.range(0) == 1){
+            for (size_t i = 0; i < batch.size(); ++i){
+                sum += batch.strike_[i];
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    std::remove(path.c_str());
+    report(state , static_cast<double>(n));
+}
+BENCHMARK(BM_BookFile_load)->DenseRange(0 , 2)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 5M prices streamed into a result file in 64k row chunks
+static void BM_ResultWriter(benchmark::State& state){
+    const size_t n = 5000000 , chunk = 65536;
+    std::vector<double> prices(chunk , 1.0);
+    for (auto _ : state){
+        ResultWriter writer("bench_results.dpl" , n , false);
+        for (size_t i = 0; i < n; i += chunk){
+            writer.append(prices.data() , nullptr , std::min(chunk , n - i));
+        }
+        writer.close();
+    }
+    std::remove("bench_results.dpl");
+    report(state , static_cast<double>(n));
+}
+BENCHMARK(BM_ResultWriter)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 300 strike chain: quotes -> implied vols -> greeks at them , arg = ticks in flight (1 = one tick at a time , the
+// tick to price latency , 8 = back to back , the throughput) , spin 0 when there are fewer cores than the 4 stages
+static void BM_ChainPipeline(benchmark::State& state){
+    OptionBook chain;
+    for (int i = 0; i < 300; ++i){
+        chain.add(70.0 + 0.2 * i , 0.5 , i % 2 == 0 ? Option::Type::CALL : Option::Type::PUT);
+    }
+    std::vector<double> quotes(chain.size());
+    BlackScholes().price_batch(chain.batch() , MarketData(100.0 , 0.03 , 0.22 , 0.01) , quotes.data());
+    ChainPipeline::Config config;
+    config.ticks = static_cast<size_t>(state.range(0));
+    config.pipeline.spin = std::thread::hardware_concurrency() > 4 ? 4096 : 0;
+    size_t published = 0;
+    ChainPipeline pipeline(chain.batch() , [&](const ChainTick&){++published;} , config);
+    uint64_t sequence = 0;
+    for (auto _ : state){
+        ChainTick* t = pipeline.acquire();
+        t->sequence = sequence++;
+        t->spot = 100.0;
+        t->rate = 0.03;
+        t->dividend = 0.01;
+        std::copy(quotes.begin() , quotes.end() , t->quotes.begin());
+        pipeline.submit(t);
+        if (config.ticks == 1){
+            pipeline.drain();
+        }
+    }
+    pipeline.drain();
+    report(state , static_cast<double>(chain.size()));
+    const LatencyHistogram& latency = pipeline.tick_to_price();
+    state.counters["p50_us"] = static_cast<double>(latency.quantile(0.5)) * 1e-3;
+    state.counters["p99_us"] = static_cast<double>(latency.quantile(0.99)) * 1e-3;
+    for (size_t i = 0; i < pipeline.pipeline().stages(); ++i){
+        state.counters["stage" + std::to_string(i) + "_us"] = pipeline.pipeline().stats(i).service.mean() * 1e-3;
+    }
+}
+BENCHMARK(BM_ChainPipeline)->Arg(1)->Arg(8)->UseRealTime();
+
+// repeat valuations through CachedModel , arg 0 = 0 the Leisen-Reimer tree , 1 LSMC , 2 a 10k row BlackScholes batch,
+// arg 1 = 0 straight to the model , 1 through a warm cache (every request a hit)
+static void BM_MemoCache(benchmark::State& state){
+    const bool cached = state.range(1) != 0;
+    MarketData market(100.0 , 0.05 , 0.2 , 0.0);
+    Option put(100.0 , 1.0 , Option::Type::PUT);
+    BinomialTree tree;
+    LSMC lsmc;
+    BlackScholes bs;
+    const PricingModel& model = state.range(0) == 0 ? static_cast<const PricingModel&>(tree) :
+                                state.range(0) == 1 ? static_cast<const PricingModel&>(lsmc) : static_cast<const PricingModel&>(bs);
+    CachedModel cache(model);
+    const PricingModel& target = cached ? static_cast<const PricingModel&>(cache) : model;
+    if (state.range(0) < 2){
+        target.price(put , market);
+        for (auto _ : state){
+            benchmark::DoNotOptimize(target.price(put , market));
+        }
+        report(state , 1);
+        return;
+    }
+    const size_t n = 10000;
+    OptionBook book = make_book(n);
+    std::vector<double> out(n);
+    target.price_batch(book.batch() , market , out.data());
+    for (auto _ : state){
+        target.price_batch(book.batch() , market , out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    report(state , static_cast<double>(n));
+}
+BENCHMARK(BM_MemoCache)->ArgsProduct({{0 , 1 , 2} , {0 , 1}})->UseRealTime();
+
+// arg 0 = 0 a 1M row GpuBlackScholes price_batch , 1 GpuLSMC at 200k paths , "device" = 1 when it ran on a GPU (never in this build)
+// (the CPU engine otherwise)
+static void BM_GpuBackend(benchmark::State& state){
+    bool device = false;
+    if (state.range(0) == 0){
+        const size_t n = 1000000;
+        OptionBook book = make_book(n);
+        std::vector<double> out(n);
+        MarketData market(100.0 , 0.05 , 0.2 , 0.0);
+        GpuBlackScholes model;
+        device = model.on_device(n);
+        for (auto _ : state){
+            model.price_batch(book.batch() , market , out.data());
+            benchmark::DoNotOptimize(out.data());
+        }
+        report(state , static_cast<double>(n));
+    }
+    else {
+        LSMC::Config config;
+        config.num_paths = 200000;
+        GpuLSMC model{GpuLSMC::Config(config)};
+        device = model.on_device();
+        Option put(100.0 , 1.0 , Option::Type::PUT);
+        MarketData market(100.0 , 0.05 , 0.2 , 0.0);
+        for (auto _ : state){
+            benchmark::DoNotOptimize(model.run(put , market));
+        }
+        report(state , 1);
+    }
+    state.counters["device"] = device ? 1.0 : 0.0;
+}
+BENCHMARK(BM_GpuBackend)->DenseRange(0 , 1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();